@@ -0,0 +1,283 @@
+#include "batch_parser.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <iomanip>
+#include <memory_resource>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+namespace {
+    bool has_extension(const std::string &filename, const std::string &extension) {
+        return filename.size() >= extension.size() &&
+               filename.compare(filename.size() - extension.size(), extension.size(), extension) == 0;
+    }
+
+    bool is_archive(const std::string &filename) {
+        return has_extension(filename, ".jar") || has_extension(filename, ".zip");
+    }
+
+    struct Worker {
+        std::pmr::unsynchronized_pool_resource pool;
+        ClassParser parser{&pool};
+        std::vector<uint8_t> buffer;
+        BatchParser::Stats stats;
+    };
+
+    // A worker's share of the items as a contiguous range. The owner takes from the front, keeping
+    // neighbouring jar entries on one thread; thieves split off the back half.
+    struct alignas(64) WorkRange {
+        std::mutex mutex;
+        size_t begin = 0;
+        size_t end = 0;
+
+        bool take(size_t &index) {
+            std::lock_guard lock(mutex);
+            if (begin == end) {
+                return false;
+            }
+            index = begin++;
+            return true;
+        }
+
+        bool split(size_t &stolen_begin, size_t &stolen_end) {
+            std::lock_guard lock(mutex);
+            const size_t remaining = end - begin;
+            if (remaining == 0) {
+                return false;
+            }
+            stolen_end = end;
+            stolen_begin = end - (remaining + 1) / 2;
+            end = stolen_begin;
+            return true;
+        }
+
+        void assign(const size_t new_begin, const size_t new_end) {
+            std::lock_guard lock(mutex);
+            begin = new_begin;
+            end = new_end;
+        }
+    };
+}
+
+std::string BatchParser::Item::to_string() const {
+    return jar != nullptr ? jar->get_filename() + "!/" + entry->name : path;
+}
+
+std::string BatchParser::Stats::to_string() const {
+    std::ostringstream oss;
+    oss << classes << " classes";
+    if (failed != 0) {
+        oss << " (" << failed << " failed)";
+    }
+    oss << ", " << std::fixed << std::setprecision(1) << bytes / (1024.0 * 1024.0) << " MB in "
+            << std::setprecision(1) << seconds * 1000.0 << " ms on " << threads << " threads: "
+            << std::setprecision(0) << classes_per_second() << " classes/s, "
+            << std::setprecision(1) << megabytes_per_second() << " MB/s";
+    return oss.str();
+}
+
+BatchParser::BatchParser(const unsigned thread_count) : thread_count(thread_count) {
+}
+
+BatchParser::~BatchParser() = default;
+
+void BatchParser::add(const std::string &path) {
+    if (std::filesystem::is_directory(path)) {
+        std::vector<std::filesystem::path> archives;
+        for (const auto &entry: std::filesystem::recursive_directory_iterator(path)) {
+            if (!entry.is_regular_file()) continue;
+            const std::string name = entry.path().string();
+            if (has_extension(name, ".class")) {
+                add_file(name, entry.file_size());
+            } else if (is_archive(name)) {
+                archives.push_back(entry.path());
+            }
+        }
+        std::sort(archives.begin(), archives.end());
+        for (const auto &archive: archives) {
+            add_jar(archive.string());
+        }
+    } else if (is_archive(path)) {
+        add_jar(path);
+    } else if (std::filesystem::is_regular_file(path)) {
+        add_file(path, std::filesystem::file_size(path));
+    } else {
+        throw std::runtime_error("Class path entry not found: " + path);
+    }
+}
+
+void BatchParser::add_file(const std::string &path, const uint64_t size) {
+    Item item;
+    item.path = path;
+    item.size = size;
+    items.push_back(std::move(item));
+    total_bytes += size;
+}
+
+void BatchParser::add_jar(const std::string &path) {
+    jars.push_back(std::make_unique<JarReader>(path));
+    const JarReader *jar = jars.back().get();
+    for (const JarReader::Entry &entry: jar->get_entries()) {
+        if (!entry.is_class()) continue;
+        Item item;
+        item.jar = jar;
+        item.entry = &entry;
+        item.size = entry.uncompressed_size;
+        items.push_back(std::move(item));
+        total_bytes += entry.uncompressed_size;
+    }
+}
+
+BatchParser::Stats BatchParser::run(const ClassCallback &callback, const ErrorCallback &on_error) const {
+    unsigned threads = thread_count;
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    threads = static_cast<unsigned>(std::min<size_t>(threads, std::max<size_t>(1, items.size())));
+
+    // With a loader, plain class files stream in through it first; everything else is shared out
+    // in ranges for the workers to steal from.
+    std::vector<size_t> loaded_items;
+    std::vector<const char *> loaded_paths;
+    std::vector<size_t> ranged_items;
+    ranged_items.reserve(items.size());
+    for (size_t i = 0; i < items.size(); ++i) {
+        if (loader != nullptr && items[i].jar == nullptr) {
+            loaded_items.push_back(i);
+            loaded_paths.push_back(items[i].path.c_str());
+        } else {
+            ranged_items.push_back(i);
+        }
+    }
+
+    std::unique_ptr<WorkRange[]> ranges(new WorkRange[threads]);
+    for (unsigned t = 0; t < threads; ++t) {
+        ranges[t].begin = ranged_items.size() * t / threads;
+        ranges[t].end = ranged_items.size() * (t + 1) / threads;
+    }
+
+    std::unique_ptr<Worker[]> workers(new Worker[threads]);
+    std::atomic<size_t> load_failures{0};
+    std::atomic<bool> failed{false};
+    std::exception_ptr error;
+    std::mutex error_mutex;
+
+    const auto record_error = [&] {
+        std::lock_guard lock(error_mutex);
+        if (!error) {
+            error = std::current_exception();
+        }
+        failed.store(true, std::memory_order_relaxed);
+    };
+
+    // Returns once the item is parsed or its error went to on_error; otherwise the error propagates.
+    const auto process = [&](Worker &worker, const Item &item, const std::span<const uint8_t> *data) {
+        try {
+            // Reading into the parser's reused buffer avoids an mmap/munmap pair per class, which
+            // serialises on the address-space lock once many threads are loading small files.
+            if (data != nullptr) {
+                worker.parser.reset(*data);
+            } else if (item.jar == nullptr) {
+                worker.parser.reset(item.path, ClassParser::LOAD_STREAM);
+            } else if (item.entry->method == JarReader::METHOD_STORED && !item.entry->is_encrypted()) {
+                const std::span<const uint8_t> raw = item.jar->get_raw_data(*item.entry);
+                JarReader::verify_crc(*item.entry, raw);
+                worker.parser.reset(raw);
+            } else {
+                item.jar->read_entry(*item.entry, worker.buffer);
+                worker.parser.reset(std::span<const uint8_t>(worker.buffer));
+            }
+            worker.parser.parse(options);
+            callback(item, worker.parser);
+            worker.stats.classes++;
+            worker.stats.bytes += item.size;
+        } catch (const std::exception &e) {
+            worker.stats.failed++;
+            if (!on_error) throw;
+            std::lock_guard lock(error_mutex);
+            on_error(item, e);
+        } catch (...) {
+            worker.stats.failed++;
+            throw;
+        }
+    };
+
+    // Nothing adds work once the batch starts, so a worker that finds every range empty is done:
+    // items a thief is still moving into its own range are already that thief's to parse.
+    const auto next_item = [&](const unsigned self, size_t &index) {
+        if (ranges[self].take(index)) {
+            return true;
+        }
+        for (unsigned i = 1; i < threads; ++i) {
+            size_t stolen_begin, stolen_end;
+            if (ranges[(self + i) % threads].split(stolen_begin, stolen_end)) {
+                ranges[self].assign(stolen_begin + 1, stolen_end);
+                index = stolen_begin;
+                return true;
+            }
+        }
+        return false;
+    };
+
+    const auto worker = [&](const unsigned self) {
+        size_t index;
+        while (!failed.load(std::memory_order_relaxed) && next_item(self, index)) {
+            try {
+                process(workers[self], items[ranged_items[index]], nullptr);
+            } catch (...) {
+                record_error();
+            }
+        }
+    };
+
+    const auto start = std::chrono::steady_clock::now();
+    for (unsigned t = 0; t < threads; ++t) {
+        workers[t].parser.set_symbol_table(symbols);
+    }
+    if (!loaded_items.empty()) {
+        FileLoader::ErrorCallback on_load_error;
+        if (on_error) {
+            on_load_error = [&](const size_t index, const std::exception &e) {
+                load_failures.fetch_add(1, std::memory_order_relaxed);
+                std::lock_guard lock(error_mutex);
+                on_error(items[loaded_items[index]], e);
+            };
+        }
+        loader->run(loaded_paths, threads, [&](const unsigned self, const size_t index,
+                                                const std::span<const uint8_t> data) {
+            process(workers[self], items[loaded_items[index]], &data);
+        }, on_load_error);
+    }
+    if (!ranged_items.empty()) {
+        std::vector<std::thread> threads_running;
+        threads_running.reserve(threads - 1);
+        for (unsigned t = 1; t < threads; ++t) {
+            threads_running.emplace_back(worker, t);
+        }
+        worker(0);
+        for (auto &thread: threads_running) {
+            thread.join();
+        }
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+
+    Stats total;
+    for (unsigned t = 0; t < threads; ++t) {
+        total.classes += workers[t].stats.classes;
+        total.failed += workers[t].stats.failed;
+        total.bytes += workers[t].stats.bytes;
+    }
+    total.failed += load_failures.load();
+    total.seconds = elapsed.count();
+    total.threads = threads;
+    return total;
+}
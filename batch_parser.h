@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "class_parser.h"
+#include "file_loader.h"
+#include "jar_reader.h"
+
+// Parses every class reachable from a list of directories, jars and class files on a pool of
+// worker threads. Each worker reuses one parser, so the ClassParser handed to the callback is
+// only valid until the callback returns.
+class BatchParser {
+public:
+    struct Item {
+        std::string path;
+        const JarReader *jar = nullptr;
+        const JarReader::Entry *entry = nullptr;
+        uint64_t size = 0;
+
+        std::string to_string() const;
+    };
+
+    struct Stats {
+        size_t classes = 0;
+        size_t failed = 0;
+        uint64_t bytes = 0;
+        double seconds = 0;
+        unsigned threads = 0;
+
+        double classes_per_second() const { return seconds > 0 ? classes / seconds : 0; }
+        double megabytes_per_second() const { return seconds > 0 ? bytes / seconds / (1024.0 * 1024.0) : 0; }
+        std::string to_string() const;
+    };
+
+    typedef std::function<void(const Item &, ClassParser &)> ClassCallback;
+    typedef std::function<void(const Item &, const std::exception &)> ErrorCallback;
+
+    explicit BatchParser(unsigned thread_count = 0);
+    ~BatchParser();
+
+    BatchParser(const BatchParser &) = delete;
+    BatchParser &operator=(const BatchParser &) = delete;
+
+    // Directories are searched recursively for .class files and jars; jars contribute their classes.
+    void add(const std::string &path);
+
+    void set_thread_count(unsigned thread_count) { this->thread_count = thread_count; }
+    void set_options(ClassParser::ParseOptions options) { this->options = options; }
+    void set_symbol_table(SymbolTable *symbols) { this->symbols = symbols; }
+    // Plain class files are then read ahead through the loader instead of by each worker.
+    void set_file_loader(const FileLoader *loader) { this->loader = loader; }
+
+    const std::vector<Item> &get_items() const { return items; }
+    uint64_t get_total_bytes() const { return total_bytes; }
+
+    // callback runs concurrently on the worker threads and must be thread-safe; on_error calls are
+    // serialised. Without an error callback the first failure stops the batch and is rethrown.
+    Stats run(const ClassCallback &callback, const ErrorCallback &on_error = nullptr) const;
+
+private:
+    unsigned thread_count;
+    ClassParser::ParseOptions options = ClassParser::PARSE_DEFAULT;
+    SymbolTable *symbols = nullptr;
+    const FileLoader *loader = nullptr;
+    std::vector<std::unique_ptr<JarReader> > jars;
+    std::vector<Item> items;
+    uint64_t total_bytes = 0;
+
+    void add_file(const std::string &path, uint64_t size);
+    void add_jar(const std::string &path);
+};
@@ -0,0 +1,347 @@
+#include "bytecode.h"
+
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+    const char *array_type_name(const uint8_t type) {
+        switch (type) {
+            case 4: return "boolean";
+            case 5: return "char";
+            case 6: return "float";
+            case 7: return "double";
+            case 8: return "byte";
+            case 9: return "short";
+            case 10: return "int";
+            case 11: return "long";
+            default: return "?";
+        }
+    }
+}
+
+Bytecode::Bytecode(const std::span<const uint8_t> code) : code(code) {
+    if (code.size() > UINT32_MAX) {
+        throw std::runtime_error("Bytecode too large: " + std::to_string(code.size()) + " bytes");
+    }
+}
+
+Bytecode::Instruction Bytecode::at(const uint32_t pc) const {
+    return {code.data(), pc, instruction_length(code, pc)};
+}
+
+uint32_t Bytecode::instruction_length(const std::span<const uint8_t> code, const uint32_t pc) {
+    const auto need = [&](const uint64_t length) {
+        if (pc + length > code.size()) {
+            throw std::runtime_error("Truncated instruction at pc " + std::to_string(pc));
+        }
+        return static_cast<uint32_t>(length);
+    };
+    const auto read_s4 = [&](const uint32_t at) {
+        return static_cast<int32_t>(static_cast<uint32_t>(code[at]) << 24 | static_cast<uint32_t>(code[at + 1]) << 16 |
+                                    static_cast<uint32_t>(code[at + 2]) << 8 | code[at + 3]);
+    };
+
+    if (pc >= code.size()) {
+        throw std::runtime_error("Instruction offset outside code: " + std::to_string(pc));
+    }
+    const OpcodeInfo &info = OPCODES[code[pc]];
+    if (!info.is_valid()) {
+        throw std::runtime_error("Invalid opcode " + std::to_string(code[pc]) + " at pc " + std::to_string(pc));
+    }
+    if (!info.is_variable_length()) {
+        return need(info.length);
+    }
+
+    const uint32_t base = (pc + 4) & ~3u;
+    switch (info.operand) {
+        case OPERAND_TABLESWITCH: {
+            need(base - pc + 12);
+            const int64_t low = read_s4(base + 4);
+            const int64_t high = read_s4(base + 8);
+            if (high < low) {
+                throw std::runtime_error("Invalid tableswitch range at pc " + std::to_string(pc));
+            }
+            return need(base - pc + 12 + 4 * static_cast<uint64_t>(high - low + 1));
+        }
+        case OPERAND_LOOKUPSWITCH: {
+            need(base - pc + 8);
+            const int32_t pairs = read_s4(base + 4);
+            if (pairs < 0) {
+                throw std::runtime_error("Invalid lookupswitch pair count at pc " + std::to_string(pc));
+            }
+            return need(base - pc + 8 + 8 * static_cast<uint64_t>(pairs));
+        }
+        case OPERAND_WIDE: {
+            need(2);
+            const OpcodeInfo &modified = OPCODES[code[pc + 1]];
+            if (modified.operand == OPERAND_IINC) {
+                return need(6);
+            }
+            if (modified.operand == OPERAND_LOCAL) {
+                return need(4);
+            }
+            throw std::runtime_error("Invalid wide instruction at pc " + std::to_string(pc));
+        }
+        default:
+            throw std::runtime_error("Invalid opcode at pc " + std::to_string(pc));
+    }
+}
+
+int Bytecode::descriptor_slots(const std::string_view descriptor) {
+    int slots = 0;
+    size_t i = descriptor.size() > 0 && descriptor[0] == '(' ? 1 : 0;
+    const bool method = i == 1;
+    while (i < descriptor.size() && descriptor[i] != ')') {
+        const char c = descriptor[i];
+        if (c == '[') {
+            while (i < descriptor.size() && descriptor[i] == '[') ++i;
+            if (i < descriptor.size() && descriptor[i] == 'L') {
+                i = descriptor.find(';', i);
+                if (i == std::string_view::npos) break;
+            }
+            ++i;
+            ++slots;
+        } else if (c == 'L') {
+            i = descriptor.find(';', i);
+            if (i == std::string_view::npos) break;
+            ++i;
+            ++slots;
+        } else {
+            ++i;
+            slots += c == 'J' || c == 'D' ? 2 : 1;
+        }
+        if (!method) break;
+    }
+    return slots;
+}
+
+int Bytecode::return_slots(const std::string_view method_descriptor) {
+    const size_t close = method_descriptor.rfind(')');
+    if (close == std::string_view::npos || close + 1 >= method_descriptor.size()) {
+        return 0;
+    }
+    const char c = method_descriptor[close + 1];
+    return c == 'V' ? 0 : c == 'J' || c == 'D' ? 2 : 1;
+}
+
+int32_t Bytecode::Instruction::get_immediate() const {
+    switch (get_info().operand) {
+        case OPERAND_BYTE:
+            return static_cast<int8_t>(code[pc + 1]);
+        case OPERAND_SHORT:
+            return static_cast<int16_t>(read_u2(pc + 1));
+        case OPERAND_IINC:
+            return is_wide() ? static_cast<int16_t>(read_u2(pc + 4)) : static_cast<int8_t>(code[pc + 2]);
+        default:
+            throw std::runtime_error(std::string(get_name()) + " has no immediate operand");
+    }
+}
+
+uint16_t Bytecode::Instruction::get_local_index() const {
+    const OperandKind kind = get_info().operand;
+    if (kind == OPERAND_LOCAL || kind == OPERAND_IINC) {
+        return is_wide() ? read_u2(pc + 2) : code[pc + 1];
+    }
+    // The _0.._3 forms encode the slot in the opcode.
+    const uint8_t opcode = code[pc];
+    if (opcode >= OP_ILOAD_0 && opcode <= OP_ALOAD_3) {
+        return (opcode - OP_ILOAD_0) & 3;
+    }
+    if (opcode >= OP_ISTORE_0 && opcode <= OP_ASTORE_3) {
+        return (opcode - OP_ISTORE_0) & 3;
+    }
+    throw std::runtime_error(std::string(get_name()) + " has no local variable operand");
+}
+
+uint16_t Bytecode::Instruction::get_constant_index() const {
+    switch (get_info().operand) {
+        case OPERAND_CONSTANT_BYTE:
+            return code[pc + 1];
+        case OPERAND_CONSTANT:
+        case OPERAND_CLASS:
+        case OPERAND_FIELD:
+        case OPERAND_METHOD:
+        case OPERAND_INVOKEINTERFACE:
+        case OPERAND_INVOKEDYNAMIC:
+        case OPERAND_MULTIANEWARRAY:
+            return read_u2(pc + 1);
+        default:
+            throw std::runtime_error(std::string(get_name()) + " has no constant pool operand");
+    }
+}
+
+int32_t Bytecode::Instruction::get_branch_offset() const {
+    switch (get_info().operand) {
+        case OPERAND_BRANCH:
+            return static_cast<int16_t>(read_u2(pc + 1));
+        case OPERAND_BRANCH_WIDE:
+            return read_s4(pc + 1);
+        default:
+            throw std::runtime_error(std::string(get_name()) + " has no branch operand");
+    }
+}
+
+uint32_t Bytecode::Instruction::get_case_count() const {
+    if (code[pc] == OP_TABLESWITCH) {
+        return static_cast<uint32_t>(static_cast<int64_t>(get_high()) - get_low() + 1);
+    }
+    if (code[pc] == OP_LOOKUPSWITCH) {
+        return static_cast<uint32_t>(read_s4(switch_base() + 4));
+    }
+    throw std::runtime_error(std::string(get_name()) + " is not a switch");
+}
+
+int32_t Bytecode::Instruction::get_case_key(const uint32_t index) const {
+    if (code[pc] == OP_TABLESWITCH) {
+        return static_cast<int32_t>(static_cast<int64_t>(get_low()) + index);
+    }
+    return read_s4(switch_base() + 8 + 8 * index);
+}
+
+int32_t Bytecode::Instruction::get_case_offset(const uint32_t index) const {
+    if (code[pc] == OP_TABLESWITCH) {
+        return read_s4(switch_base() + 12 + 4 * index);
+    }
+    return read_s4(switch_base() + 12 + 8 * index);
+}
+
+const ClassParser::MemberReference &Bytecode::Instruction::get_member_reference(const ClassParser &parser) const {
+    const ClassParser::ConstantPool &pool = parser.get_constant_pool();
+    const uint16_t index = get_constant_index();
+    switch (pool.tag(index)) {
+        case ClassParser::CONSTANT_Fieldref:
+        case ClassParser::CONSTANT_Methodref:
+        case ClassParser::CONSTANT_InterfaceMethodref:
+            return parser.resolve_member_reference(index);
+        case ClassParser::CONSTANT_Dynamic:
+        case ClassParser::CONSTANT_InvokeDynamic: {
+            const uint16_t name_and_type = pool.index2(index);
+            if (!pool.is(name_and_type, ClassParser::CONSTANT_NameAndType)) {
+                throw std::runtime_error("Invalid NameAndType index in constant pool: " +
+                                         std::to_string(name_and_type));
+            }
+            return parser.resolve_member_reference(name_and_type);
+        }
+        default:
+            throw std::runtime_error("Invalid member reference in constant pool: " + std::to_string(index));
+    }
+}
+
+std::string_view Bytecode::Instruction::get_class_name(const ClassParser &parser) const {
+    const uint16_t index = get_constant_index();
+    const ClassParser::ConstantPool &pool = parser.get_constant_pool();
+    switch (pool.tag(index)) {
+        case ClassParser::CONSTANT_Class:
+            return parser.get_class_name_view(index);
+        case ClassParser::CONSTANT_Fieldref:
+        case ClassParser::CONSTANT_Methodref:
+        case ClassParser::CONSTANT_InterfaceMethodref:
+            return parser.resolve_member_reference(index).owner;
+        default:
+            throw std::runtime_error(std::string(get_name()) + " has no class operand");
+    }
+}
+
+std::string_view Bytecode::Instruction::get_member_name(const ClassParser &parser) const {
+    return get_member_reference(parser).name;
+}
+
+std::string_view Bytecode::Instruction::get_member_descriptor(const ClassParser &parser) const {
+    return get_member_reference(parser).descriptor;
+}
+
+Bytecode::StackEffect Bytecode::Instruction::get_stack_effect(const ClassParser &parser) const {
+    const OpcodeInfo &info = get_info();
+    if (info.pops != STACK_VARIABLE && info.pushes != STACK_VARIABLE) {
+        return {info.pops, info.pushes};
+    }
+    if (info.operand == OPERAND_MULTIANEWARRAY) {
+        return {get_dimensions(), 1};
+    }
+
+    const std::string_view descriptor = get_member_descriptor(parser);
+    switch (get_opcode()) {
+        case OP_GETSTATIC:
+            return {0, descriptor_slots(descriptor)};
+        case OP_PUTSTATIC:
+            return {descriptor_slots(descriptor), 0};
+        case OP_GETFIELD:
+            return {1, descriptor_slots(descriptor)};
+        case OP_PUTFIELD:
+            return {1 + descriptor_slots(descriptor), 0};
+        case OP_INVOKESTATIC:
+        case OP_INVOKEDYNAMIC:
+            return {descriptor_slots(descriptor), return_slots(descriptor)};
+        default:
+            return {1 + descriptor_slots(descriptor), return_slots(descriptor)};
+    }
+}
+
+std::string Bytecode::Instruction::to_string(const ClassParser *parser) const {
+    std::ostringstream oss;
+    oss << pc << ": " << (is_wide() ? "wide " : "") << get_name();
+    switch (get_info().operand) {
+        case OPERAND_NONE:
+        case OPERAND_WIDE:
+            break;
+        case OPERAND_BYTE:
+        case OPERAND_SHORT:
+            oss << " " << get_immediate();
+            break;
+        case OPERAND_LOCAL:
+            oss << " " << get_local_index();
+            break;
+        case OPERAND_IINC:
+            oss << " " << get_local_index() << " " << get_immediate();
+            break;
+        case OPERAND_ARRAY_TYPE:
+            oss << " " << array_type_name(get_array_type());
+            break;
+        case OPERAND_BRANCH:
+        case OPERAND_BRANCH_WIDE:
+            oss << " " << get_branch_target();
+            break;
+        case OPERAND_TABLESWITCH:
+        case OPERAND_LOOKUPSWITCH: {
+            oss << " {";
+            for (uint32_t i = 0; i < get_case_count(); ++i) {
+                oss << " " << get_case_key(i) << ": " << pc + get_case_offset(i) << ";";
+            }
+            oss << " default: " << pc + get_default_offset() << " }";
+            break;
+        }
+        case OPERAND_CLASS:
+        case OPERAND_MULTIANEWARRAY:
+            oss << " #" << get_constant_index();
+            if (parser != nullptr) {
+                oss << " " << get_class_name(*parser);
+            }
+            if (get_info().operand == OPERAND_MULTIANEWARRAY) {
+                oss << " dim " << static_cast<int>(get_dimensions());
+            }
+            break;
+        case OPERAND_FIELD:
+        case OPERAND_METHOD:
+        case OPERAND_INVOKEINTERFACE:
+            oss << " #" << get_constant_index();
+            if (parser != nullptr) {
+                oss << " " << get_class_name(*parser) << "." << get_member_name(*parser) << ":"
+                        << get_member_descriptor(*parser);
+            }
+            break;
+        case OPERAND_INVOKEDYNAMIC:
+            oss << " #" << get_constant_index();
+            if (parser != nullptr) {
+                oss << " " << get_member_name(*parser) << ":" << get_member_descriptor(*parser);
+            }
+            break;
+        case OPERAND_CONSTANT_BYTE:
+        case OPERAND_CONSTANT:
+            oss << " #" << get_constant_index();
+            if (parser != nullptr) {
+                oss << " " << parser->get_constant_pool()[get_constant_index()].to_string();
+            }
+            break;
+    }
+    return oss.str();
+}
@@ -0,0 +1,613 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <span>
+#include <string>
+#include <string_view>
+
+#include "class_parser.h"
+
+// Decodes JVM bytecode in place. Opcode lengths, operand kinds and stack effects come from a
+// table built at compile time; iterating allocates nothing and constant-pool operands are only
+// looked up when asked for.
+class Bytecode {
+public:
+    enum Opcode : uint8_t {
+        OP_NOP = 0x00,
+        OP_ACONST_NULL = 0x01,
+        OP_ICONST_M1 = 0x02,
+        OP_ICONST_0 = 0x03,
+        OP_ICONST_1 = 0x04,
+        OP_ICONST_2 = 0x05,
+        OP_ICONST_3 = 0x06,
+        OP_ICONST_4 = 0x07,
+        OP_ICONST_5 = 0x08,
+        OP_LCONST_0 = 0x09,
+        OP_LCONST_1 = 0x0a,
+        OP_FCONST_0 = 0x0b,
+        OP_FCONST_1 = 0x0c,
+        OP_FCONST_2 = 0x0d,
+        OP_DCONST_0 = 0x0e,
+        OP_DCONST_1 = 0x0f,
+        OP_BIPUSH = 0x10,
+        OP_SIPUSH = 0x11,
+        OP_LDC = 0x12,
+        OP_LDC_W = 0x13,
+        OP_LDC2_W = 0x14,
+        OP_ILOAD = 0x15,
+        OP_LLOAD = 0x16,
+        OP_FLOAD = 0x17,
+        OP_DLOAD = 0x18,
+        OP_ALOAD = 0x19,
+        OP_ILOAD_0 = 0x1a,
+        OP_ILOAD_1 = 0x1b,
+        OP_ILOAD_2 = 0x1c,
+        OP_ILOAD_3 = 0x1d,
+        OP_LLOAD_0 = 0x1e,
+        OP_LLOAD_1 = 0x1f,
+        OP_LLOAD_2 = 0x20,
+        OP_LLOAD_3 = 0x21,
+        OP_FLOAD_0 = 0x22,
+        OP_FLOAD_1 = 0x23,
+        OP_FLOAD_2 = 0x24,
+        OP_FLOAD_3 = 0x25,
+        OP_DLOAD_0 = 0x26,
+        OP_DLOAD_1 = 0x27,
+        OP_DLOAD_2 = 0x28,
+        OP_DLOAD_3 = 0x29,
+        OP_ALOAD_0 = 0x2a,
+        OP_ALOAD_1 = 0x2b,
+        OP_ALOAD_2 = 0x2c,
+        OP_ALOAD_3 = 0x2d,
+        OP_IALOAD = 0x2e,
+        OP_LALOAD = 0x2f,
+        OP_FALOAD = 0x30,
+        OP_DALOAD = 0x31,
+        OP_AALOAD = 0x32,
+        OP_BALOAD = 0x33,
+        OP_CALOAD = 0x34,
+        OP_SALOAD = 0x35,
+        OP_ISTORE = 0x36,
+        OP_LSTORE = 0x37,
+        OP_FSTORE = 0x38,
+        OP_DSTORE = 0x39,
+        OP_ASTORE = 0x3a,
+        OP_ISTORE_0 = 0x3b,
+        OP_ISTORE_1 = 0x3c,
+        OP_ISTORE_2 = 0x3d,
+        OP_ISTORE_3 = 0x3e,
+        OP_LSTORE_0 = 0x3f,
+        OP_LSTORE_1 = 0x40,
+        OP_LSTORE_2 = 0x41,
+        OP_LSTORE_3 = 0x42,
+        OP_FSTORE_0 = 0x43,
+        OP_FSTORE_1 = 0x44,
+        OP_FSTORE_2 = 0x45,
+        OP_FSTORE_3 = 0x46,
+        OP_DSTORE_0 = 0x47,
+        OP_DSTORE_1 = 0x48,
+        OP_DSTORE_2 = 0x49,
+        OP_DSTORE_3 = 0x4a,
+        OP_ASTORE_0 = 0x4b,
+        OP_ASTORE_1 = 0x4c,
+        OP_ASTORE_2 = 0x4d,
+        OP_ASTORE_3 = 0x4e,
+        OP_IASTORE = 0x4f,
+        OP_LASTORE = 0x50,
+        OP_FASTORE = 0x51,
+        OP_DASTORE = 0x52,
+        OP_AASTORE = 0x53,
+        OP_BASTORE = 0x54,
+        OP_CASTORE = 0x55,
+        OP_SASTORE = 0x56,
+        OP_POP = 0x57,
+        OP_POP2 = 0x58,
+        OP_DUP = 0x59,
+        OP_DUP_X1 = 0x5a,
+        OP_DUP_X2 = 0x5b,
+        OP_DUP2 = 0x5c,
+        OP_DUP2_X1 = 0x5d,
+        OP_DUP2_X2 = 0x5e,
+        OP_SWAP = 0x5f,
+        OP_IADD = 0x60,
+        OP_LADD = 0x61,
+        OP_FADD = 0x62,
+        OP_DADD = 0x63,
+        OP_ISUB = 0x64,
+        OP_LSUB = 0x65,
+        OP_FSUB = 0x66,
+        OP_DSUB = 0x67,
+        OP_IMUL = 0x68,
+        OP_LMUL = 0x69,
+        OP_FMUL = 0x6a,
+        OP_DMUL = 0x6b,
+        OP_IDIV = 0x6c,
+        OP_LDIV = 0x6d,
+        OP_FDIV = 0x6e,
+        OP_DDIV = 0x6f,
+        OP_IREM = 0x70,
+        OP_LREM = 0x71,
+        OP_FREM = 0x72,
+        OP_DREM = 0x73,
+        OP_INEG = 0x74,
+        OP_LNEG = 0x75,
+        OP_FNEG = 0x76,
+        OP_DNEG = 0x77,
+        OP_ISHL = 0x78,
+        OP_LSHL = 0x79,
+        OP_ISHR = 0x7a,
+        OP_LSHR = 0x7b,
+        OP_IUSHR = 0x7c,
+        OP_LUSHR = 0x7d,
+        OP_IAND = 0x7e,
+        OP_LAND = 0x7f,
+        OP_IOR = 0x80,
+        OP_LOR = 0x81,
+        OP_IXOR = 0x82,
+        OP_LXOR = 0x83,
+        OP_IINC = 0x84,
+        OP_I2L = 0x85,
+        OP_I2F = 0x86,
+        OP_I2D = 0x87,
+        OP_L2I = 0x88,
+        OP_L2F = 0x89,
+        OP_L2D = 0x8a,
+        OP_F2I = 0x8b,
+        OP_F2L = 0x8c,
+        OP_F2D = 0x8d,
+        OP_D2I = 0x8e,
+        OP_D2L = 0x8f,
+        OP_D2F = 0x90,
+        OP_I2B = 0x91,
+        OP_I2C = 0x92,
+        OP_I2S = 0x93,
+        OP_LCMP = 0x94,
+        OP_FCMPL = 0x95,
+        OP_FCMPG = 0x96,
+        OP_DCMPL = 0x97,
+        OP_DCMPG = 0x98,
+        OP_IFEQ = 0x99,
+        OP_IFNE = 0x9a,
+        OP_IFLT = 0x9b,
+        OP_IFGE = 0x9c,
+        OP_IFGT = 0x9d,
+        OP_IFLE = 0x9e,
+        OP_IF_ICMPEQ = 0x9f,
+        OP_IF_ICMPNE = 0xa0,
+        OP_IF_ICMPLT = 0xa1,
+        OP_IF_ICMPGE = 0xa2,
+        OP_IF_ICMPGT = 0xa3,
+        OP_IF_ICMPLE = 0xa4,
+        OP_IF_ACMPEQ = 0xa5,
+        OP_IF_ACMPNE = 0xa6,
+        OP_GOTO = 0xa7,
+        OP_JSR = 0xa8,
+        OP_RET = 0xa9,
+        OP_TABLESWITCH = 0xaa,
+        OP_LOOKUPSWITCH = 0xab,
+        OP_IRETURN = 0xac,
+        OP_LRETURN = 0xad,
+        OP_FRETURN = 0xae,
+        OP_DRETURN = 0xaf,
+        OP_ARETURN = 0xb0,
+        OP_RETURN = 0xb1,
+        OP_GETSTATIC = 0xb2,
+        OP_PUTSTATIC = 0xb3,
+        OP_GETFIELD = 0xb4,
+        OP_PUTFIELD = 0xb5,
+        OP_INVOKEVIRTUAL = 0xb6,
+        OP_INVOKESPECIAL = 0xb7,
+        OP_INVOKESTATIC = 0xb8,
+        OP_INVOKEINTERFACE = 0xb9,
+        OP_INVOKEDYNAMIC = 0xba,
+        OP_NEW = 0xbb,
+        OP_NEWARRAY = 0xbc,
+        OP_ANEWARRAY = 0xbd,
+        OP_ARRAYLENGTH = 0xbe,
+        OP_ATHROW = 0xbf,
+        OP_CHECKCAST = 0xc0,
+        OP_INSTANCEOF = 0xc1,
+        OP_MONITORENTER = 0xc2,
+        OP_MONITOREXIT = 0xc3,
+        OP_WIDE = 0xc4,
+        OP_MULTIANEWARRAY = 0xc5,
+        OP_IFNULL = 0xc6,
+        OP_IFNONNULL = 0xc7,
+        OP_GOTO_W = 0xc8,
+        OP_JSR_W = 0xc9,
+        OP_BREAKPOINT = 0xca,
+        OP_IMPDEP1 = 0xfe,
+        OP_IMPDEP2 = 0xff,
+    };
+
+    enum OperandKind : uint8_t {
+        OPERAND_NONE,
+        OPERAND_BYTE,
+        OPERAND_SHORT,
+        OPERAND_LOCAL,
+        OPERAND_IINC,
+        OPERAND_CONSTANT_BYTE,
+        OPERAND_CONSTANT,
+        OPERAND_CLASS,
+        OPERAND_FIELD,
+        OPERAND_METHOD,
+        OPERAND_INVOKEINTERFACE,
+        OPERAND_INVOKEDYNAMIC,
+        OPERAND_MULTIANEWARRAY,
+        OPERAND_ARRAY_TYPE,
+        OPERAND_BRANCH,
+        OPERAND_BRANCH_WIDE,
+        OPERAND_TABLESWITCH,
+        OPERAND_LOOKUPSWITCH,
+        OPERAND_WIDE,
+    };
+
+    // Stack effects are in slots, so long and double values count twice. Field access, invokes and
+    // multianewarray depend on their operand and are marked STACK_VARIABLE.
+    static constexpr int8_t STACK_VARIABLE = -1;
+
+    struct OpcodeInfo {
+        uint8_t opcode = 0;
+        const char *name = nullptr;
+        uint8_t length = 0;
+        OperandKind operand = OPERAND_NONE;
+        int8_t pops = 0;
+        int8_t pushes = 0;
+
+        bool is_valid() const { return name != nullptr; }
+        bool is_variable_length() const { return is_valid() && length == 0; }
+    };
+
+    static const std::array<OpcodeInfo, 256> OPCODES;
+
+    struct StackEffect {
+        int pops = 0;
+        int pushes = 0;
+    };
+
+    class Instruction {
+    public:
+        Instruction() = default;
+
+        uint32_t get_offset() const { return pc; }
+        uint32_t get_length() const { return length; }
+        uint8_t get_opcode() const { return is_wide() ? code[pc + 1] : code[pc]; }
+        const OpcodeInfo &get_info() const { return OPCODES[get_opcode()]; }
+        std::string_view get_name() const { return get_info().name; }
+        bool is_wide() const { return code[pc] == OP_WIDE; }
+
+        // bipush and sipush values, and the iinc increment.
+        int32_t get_immediate() const;
+        // Local variable slot of loads, stores, ret and iinc, widened when prefixed by wide.
+        uint16_t get_local_index() const;
+        // Constant-pool operand of ldc, field and method references, and class operands.
+        uint16_t get_constant_index() const;
+        uint8_t get_dimensions() const { return code[pc + 3]; }
+        uint8_t get_array_type() const { return code[pc + 1]; }
+        uint8_t get_interface_count() const { return code[pc + 3]; }
+
+        int32_t get_branch_offset() const;
+        uint32_t get_branch_target() const { return pc + get_branch_offset(); }
+
+        // tableswitch cases run from get_low() to get_high(); lookupswitch cases are key/offset pairs.
+        int32_t get_default_offset() const { return read_s4(switch_base()); }
+        int32_t get_low() const { return read_s4(switch_base() + 4); }
+        int32_t get_high() const { return read_s4(switch_base() + 8); }
+        uint32_t get_case_count() const;
+        int32_t get_case_key(uint32_t index) const;
+        int32_t get_case_offset(uint32_t index) const;
+
+        // Lazily resolved through the parser's constant pool. Field and method references come from
+        // the parser's member reference cache; invokedynamic's has an empty owner.
+        std::string_view get_class_name(const ClassParser &parser) const;
+        const ClassParser::MemberReference &get_member_reference(const ClassParser &parser) const;
+        std::string_view get_member_name(const ClassParser &parser) const;
+        std::string_view get_member_descriptor(const ClassParser &parser) const;
+        StackEffect get_stack_effect(const ClassParser &parser) const;
+
+        std::string to_string(const ClassParser *parser = nullptr) const;
+
+    private:
+        friend class Bytecode;
+
+        const uint8_t *code = nullptr;
+        uint32_t pc = 0;
+        uint32_t length = 0;
+
+        Instruction(const uint8_t *code, const uint32_t pc, const uint32_t length) : code(code), pc(pc), length(length) {}
+
+        uint32_t switch_base() const { return (pc + 4) & ~3u; }
+        uint16_t read_u2(const uint32_t at) const { return static_cast<uint16_t>(code[at] << 8 | code[at + 1]); }
+        int32_t read_s4(const uint32_t at) const {
+            return static_cast<int32_t>(static_cast<uint32_t>(code[at]) << 24 | static_cast<uint32_t>(code[at + 1]) << 16 |
+                                        static_cast<uint32_t>(code[at + 2]) << 8 | code[at + 3]);
+        }
+    };
+
+    class Iterator {
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef Instruction value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const Instruction *pointer;
+        typedef const Instruction &reference;
+
+        Iterator() = default;
+
+        reference operator*() const { return current; }
+        pointer operator->() const { return &current; }
+        Iterator &operator++() {
+            advance(current.pc + current.length);
+            return *this;
+        }
+        Iterator operator++(int) {
+            Iterator previous = *this;
+            ++*this;
+            return previous;
+        }
+        bool operator==(const Iterator &other) const { return current.pc == other.current.pc; }
+
+    private:
+        friend class Bytecode;
+
+        Instruction current;
+        uint32_t size = 0;
+
+        Iterator(const uint8_t *code, uint32_t size, uint32_t pc);
+        void advance(uint32_t pc);
+    };
+
+    explicit Bytecode(std::span<const uint8_t> code);
+    explicit Bytecode(const ClassParser::CodeAttribute &code) : Bytecode(code.bytecode()) {}
+
+    Iterator begin() const { return {code.data(), static_cast<uint32_t>(code.size()), 0}; }
+    Iterator end() const { return {code.data(), static_cast<uint32_t>(code.size()), static_cast<uint32_t>(code.size())}; }
+
+    // Instruction at pc, which must be the start of an instruction.
+    Instruction at(uint32_t pc) const;
+
+    // Length of the instruction at pc, including switch padding and the wide prefix.
+    static uint32_t instruction_length(std::span<const uint8_t> code, uint32_t pc);
+    // Stack slots taken by a field descriptor, or by a method's arguments when given one.
+    static int descriptor_slots(std::string_view descriptor);
+    static int return_slots(std::string_view method_descriptor);
+
+private:
+    std::span<const uint8_t> code;
+};
+
+inline constexpr std::array<Bytecode::OpcodeInfo, 256> Bytecode::OPCODES = [] {
+    constexpr OpcodeInfo LIST[] = {
+        {OP_NOP, "nop", 1, OPERAND_NONE, 0, 0},
+        {OP_ACONST_NULL, "aconst_null", 1, OPERAND_NONE, 0, 1},
+        {OP_ICONST_M1, "iconst_m1", 1, OPERAND_NONE, 0, 1},
+        {OP_ICONST_0, "iconst_0", 1, OPERAND_NONE, 0, 1},
+        {OP_ICONST_1, "iconst_1", 1, OPERAND_NONE, 0, 1},
+        {OP_ICONST_2, "iconst_2", 1, OPERAND_NONE, 0, 1},
+        {OP_ICONST_3, "iconst_3", 1, OPERAND_NONE, 0, 1},
+        {OP_ICONST_4, "iconst_4", 1, OPERAND_NONE, 0, 1},
+        {OP_ICONST_5, "iconst_5", 1, OPERAND_NONE, 0, 1},
+        {OP_LCONST_0, "lconst_0", 1, OPERAND_NONE, 0, 2},
+        {OP_LCONST_1, "lconst_1", 1, OPERAND_NONE, 0, 2},
+        {OP_FCONST_0, "fconst_0", 1, OPERAND_NONE, 0, 1},
+        {OP_FCONST_1, "fconst_1", 1, OPERAND_NONE, 0, 1},
+        {OP_FCONST_2, "fconst_2", 1, OPERAND_NONE, 0, 1},
+        {OP_DCONST_0, "dconst_0", 1, OPERAND_NONE, 0, 2},
+        {OP_DCONST_1, "dconst_1", 1, OPERAND_NONE, 0, 2},
+        {OP_BIPUSH, "bipush", 2, OPERAND_BYTE, 0, 1},
+        {OP_SIPUSH, "sipush", 3, OPERAND_SHORT, 0, 1},
+        {OP_LDC, "ldc", 2, OPERAND_CONSTANT_BYTE, 0, 1},
+        {OP_LDC_W, "ldc_w", 3, OPERAND_CONSTANT, 0, 1},
+        {OP_LDC2_W, "ldc2_w", 3, OPERAND_CONSTANT, 0, 2},
+        {OP_ILOAD, "iload", 2, OPERAND_LOCAL, 0, 1},
+        {OP_LLOAD, "lload", 2, OPERAND_LOCAL, 0, 2},
+        {OP_FLOAD, "fload", 2, OPERAND_LOCAL, 0, 1},
+        {OP_DLOAD, "dload", 2, OPERAND_LOCAL, 0, 2},
+        {OP_ALOAD, "aload", 2, OPERAND_LOCAL, 0, 1},
+        {OP_ILOAD_0, "iload_0", 1, OPERAND_NONE, 0, 1},
+        {OP_ILOAD_1, "iload_1", 1, OPERAND_NONE, 0, 1},
+        {OP_ILOAD_2, "iload_2", 1, OPERAND_NONE, 0, 1},
+        {OP_ILOAD_3, "iload_3", 1, OPERAND_NONE, 0, 1},
+        {OP_LLOAD_0, "lload_0", 1, OPERAND_NONE, 0, 2},
+        {OP_LLOAD_1, "lload_1", 1, OPERAND_NONE, 0, 2},
+        {OP_LLOAD_2, "lload_2", 1, OPERAND_NONE, 0, 2},
+        {OP_LLOAD_3, "lload_3", 1, OPERAND_NONE, 0, 2},
+        {OP_FLOAD_0, "fload_0", 1, OPERAND_NONE, 0, 1},
+        {OP_FLOAD_1, "fload_1", 1, OPERAND_NONE, 0, 1},
+        {OP_FLOAD_2, "fload_2", 1, OPERAND_NONE, 0, 1},
+        {OP_FLOAD_3, "fload_3", 1, OPERAND_NONE, 0, 1},
+        {OP_DLOAD_0, "dload_0", 1, OPERAND_NONE, 0, 2},
+        {OP_DLOAD_1, "dload_1", 1, OPERAND_NONE, 0, 2},
+        {OP_DLOAD_2, "dload_2", 1, OPERAND_NONE, 0, 2},
+        {OP_DLOAD_3, "dload_3", 1, OPERAND_NONE, 0, 2},
+        {OP_ALOAD_0, "aload_0", 1, OPERAND_NONE, 0, 1},
+        {OP_ALOAD_1, "aload_1", 1, OPERAND_NONE, 0, 1},
+        {OP_ALOAD_2, "aload_2", 1, OPERAND_NONE, 0, 1},
+        {OP_ALOAD_3, "aload_3", 1, OPERAND_NONE, 0, 1},
+        {OP_IALOAD, "iaload", 1, OPERAND_NONE, 2, 1},
+        {OP_LALOAD, "laload", 1, OPERAND_NONE, 2, 2},
+        {OP_FALOAD, "faload", 1, OPERAND_NONE, 2, 1},
+        {OP_DALOAD, "daload", 1, OPERAND_NONE, 2, 2},
+        {OP_AALOAD, "aaload", 1, OPERAND_NONE, 2, 1},
+        {OP_BALOAD, "baload", 1, OPERAND_NONE, 2, 1},
+        {OP_CALOAD, "caload", 1, OPERAND_NONE, 2, 1},
+        {OP_SALOAD, "saload", 1, OPERAND_NONE, 2, 1},
+        {OP_ISTORE, "istore", 2, OPERAND_LOCAL, 1, 0},
+        {OP_LSTORE, "lstore", 2, OPERAND_LOCAL, 2, 0},
+        {OP_FSTORE, "fstore", 2, OPERAND_LOCAL, 1, 0},
+        {OP_DSTORE, "dstore", 2, OPERAND_LOCAL, 2, 0},
+        {OP_ASTORE, "astore", 2, OPERAND_LOCAL, 1, 0},
+        {OP_ISTORE_0, "istore_0", 1, OPERAND_NONE, 1, 0},
+        {OP_ISTORE_1, "istore_1", 1, OPERAND_NONE, 1, 0},
+        {OP_ISTORE_2, "istore_2", 1, OPERAND_NONE, 1, 0},
+        {OP_ISTORE_3, "istore_3", 1, OPERAND_NONE, 1, 0},
+        {OP_LSTORE_0, "lstore_0", 1, OPERAND_NONE, 2, 0},
+        {OP_LSTORE_1, "lstore_1", 1, OPERAND_NONE, 2, 0},
+        {OP_LSTORE_2, "lstore_2", 1, OPERAND_NONE, 2, 0},
+        {OP_LSTORE_3, "lstore_3", 1, OPERAND_NONE, 2, 0},
+        {OP_FSTORE_0, "fstore_0", 1, OPERAND_NONE, 1, 0},
+        {OP_FSTORE_1, "fstore_1", 1, OPERAND_NONE, 1, 0},
+        {OP_FSTORE_2, "fstore_2", 1, OPERAND_NONE, 1, 0},
+        {OP_FSTORE_3, "fstore_3", 1, OPERAND_NONE, 1, 0},
+        {OP_DSTORE_0, "dstore_0", 1, OPERAND_NONE, 2, 0},
+        {OP_DSTORE_1, "dstore_1", 1, OPERAND_NONE, 2, 0},
+        {OP_DSTORE_2, "dstore_2", 1, OPERAND_NONE, 2, 0},
+        {OP_DSTORE_3, "dstore_3", 1, OPERAND_NONE, 2, 0},
+        {OP_ASTORE_0, "astore_0", 1, OPERAND_NONE, 1, 0},
+        {OP_ASTORE_1, "astore_1", 1, OPERAND_NONE, 1, 0},
+        {OP_ASTORE_2, "astore_2", 1, OPERAND_NONE, 1, 0},
+        {OP_ASTORE_3, "astore_3", 1, OPERAND_NONE, 1, 0},
+        {OP_IASTORE, "iastore", 1, OPERAND_NONE, 3, 0},
+        {OP_LASTORE, "lastore", 1, OPERAND_NONE, 4, 0},
+        {OP_FASTORE, "fastore", 1, OPERAND_NONE, 3, 0},
+        {OP_DASTORE, "dastore", 1, OPERAND_NONE, 4, 0},
+        {OP_AASTORE, "aastore", 1, OPERAND_NONE, 3, 0},
+        {OP_BASTORE, "bastore", 1, OPERAND_NONE, 3, 0},
+        {OP_CASTORE, "castore", 1, OPERAND_NONE, 3, 0},
+        {OP_SASTORE, "sastore", 1, OPERAND_NONE, 3, 0},
+        {OP_POP, "pop", 1, OPERAND_NONE, 1, 0},
+        {OP_POP2, "pop2", 1, OPERAND_NONE, 2, 0},
+        {OP_DUP, "dup", 1, OPERAND_NONE, 1, 2},
+        {OP_DUP_X1, "dup_x1", 1, OPERAND_NONE, 2, 3},
+        {OP_DUP_X2, "dup_x2", 1, OPERAND_NONE, 3, 4},
+        {OP_DUP2, "dup2", 1, OPERAND_NONE, 2, 4},
+        {OP_DUP2_X1, "dup2_x1", 1, OPERAND_NONE, 3, 5},
+        {OP_DUP2_X2, "dup2_x2", 1, OPERAND_NONE, 4, 6},
+        {OP_SWAP, "swap", 1, OPERAND_NONE, 2, 2},
+        {OP_IADD, "iadd", 1, OPERAND_NONE, 2, 1},
+        {OP_LADD, "ladd", 1, OPERAND_NONE, 4, 2},
+        {OP_FADD, "fadd", 1, OPERAND_NONE, 2, 1},
+        {OP_DADD, "dadd", 1, OPERAND_NONE, 4, 2},
+        {OP_ISUB, "isub", 1, OPERAND_NONE, 2, 1},
+        {OP_LSUB, "lsub", 1, OPERAND_NONE, 4, 2},
+        {OP_FSUB, "fsub", 1, OPERAND_NONE, 2, 1},
+        {OP_DSUB, "dsub", 1, OPERAND_NONE, 4, 2},
+        {OP_IMUL, "imul", 1, OPERAND_NONE, 2, 1},
+        {OP_LMUL, "lmul", 1, OPERAND_NONE, 4, 2},
+        {OP_FMUL, "fmul", 1, OPERAND_NONE, 2, 1},
+        {OP_DMUL, "dmul", 1, OPERAND_NONE, 4, 2},
+        {OP_IDIV, "idiv", 1, OPERAND_NONE, 2, 1},
+        {OP_LDIV, "ldiv", 1, OPERAND_NONE, 4, 2},
+        {OP_FDIV, "fdiv", 1, OPERAND_NONE, 2, 1},
+        {OP_DDIV, "ddiv", 1, OPERAND_NONE, 4, 2},
+        {OP_IREM, "irem", 1, OPERAND_NONE, 2, 1},
+        {OP_LREM, "lrem", 1, OPERAND_NONE, 4, 2},
+        {OP_FREM, "frem", 1, OPERAND_NONE, 2, 1},
+        {OP_DREM, "drem", 1, OPERAND_NONE, 4, 2},
+        {OP_INEG, "ineg", 1, OPERAND_NONE, 1, 1},
+        {OP_LNEG, "lneg", 1, OPERAND_NONE, 2, 2},
+        {OP_FNEG, "fneg", 1, OPERAND_NONE, 1, 1},
+        {OP_DNEG, "dneg", 1, OPERAND_NONE, 2, 2},
+        {OP_ISHL, "ishl", 1, OPERAND_NONE, 2, 1},
+        {OP_LSHL, "lshl", 1, OPERAND_NONE, 3, 2},
+        {OP_ISHR, "ishr", 1, OPERAND_NONE, 2, 1},
+        {OP_LSHR, "lshr", 1, OPERAND_NONE, 3, 2},
+        {OP_IUSHR, "iushr", 1, OPERAND_NONE, 2, 1},
+        {OP_LUSHR, "lushr", 1, OPERAND_NONE, 3, 2},
+        {OP_IAND, "iand", 1, OPERAND_NONE, 2, 1},
+        {OP_LAND, "land", 1, OPERAND_NONE, 4, 2},
+        {OP_IOR, "ior", 1, OPERAND_NONE, 2, 1},
+        {OP_LOR, "lor", 1, OPERAND_NONE, 4, 2},
+        {OP_IXOR, "ixor", 1, OPERAND_NONE, 2, 1},
+        {OP_LXOR, "lxor", 1, OPERAND_NONE, 4, 2},
+        {OP_IINC, "iinc", 3, OPERAND_IINC, 0, 0},
+        {OP_I2L, "i2l", 1, OPERAND_NONE, 1, 2},
+        {OP_I2F, "i2f", 1, OPERAND_NONE, 1, 1},
+        {OP_I2D, "i2d", 1, OPERAND_NONE, 1, 2},
+        {OP_L2I, "l2i", 1, OPERAND_NONE, 2, 1},
+        {OP_L2F, "l2f", 1, OPERAND_NONE, 2, 1},
+        {OP_L2D, "l2d", 1, OPERAND_NONE, 2, 2},
+        {OP_F2I, "f2i", 1, OPERAND_NONE, 1, 1},
+        {OP_F2L, "f2l", 1, OPERAND_NONE, 1, 2},
+        {OP_F2D, "f2d", 1, OPERAND_NONE, 1, 2},
+        {OP_D2I, "d2i", 1, OPERAND_NONE, 2, 1},
+        {OP_D2L, "d2l", 1, OPERAND_NONE, 2, 2},
+        {OP_D2F, "d2f", 1, OPERAND_NONE, 2, 1},
+        {OP_I2B, "i2b", 1, OPERAND_NONE, 1, 1},
+        {OP_I2C, "i2c", 1, OPERAND_NONE, 1, 1},
+        {OP_I2S, "i2s", 1, OPERAND_NONE, 1, 1},
+        {OP_LCMP, "lcmp", 1, OPERAND_NONE, 4, 1},
+        {OP_FCMPL, "fcmpl", 1, OPERAND_NONE, 2, 1},
+        {OP_FCMPG, "fcmpg", 1, OPERAND_NONE, 2, 1},
+        {OP_DCMPL, "dcmpl", 1, OPERAND_NONE, 4, 1},
+        {OP_DCMPG, "dcmpg", 1, OPERAND_NONE, 4, 1},
+        {OP_IFEQ, "ifeq", 3, OPERAND_BRANCH, 1, 0},
+        {OP_IFNE, "ifne", 3, OPERAND_BRANCH, 1, 0},
+        {OP_IFLT, "iflt", 3, OPERAND_BRANCH, 1, 0},
+        {OP_IFGE, "ifge", 3, OPERAND_BRANCH, 1, 0},
+        {OP_IFGT, "ifgt", 3, OPERAND_BRANCH, 1, 0},
+        {OP_IFLE, "ifle", 3, OPERAND_BRANCH, 1, 0},
+        {OP_IF_ICMPEQ, "if_icmpeq", 3, OPERAND_BRANCH, 2, 0},
+        {OP_IF_ICMPNE, "if_icmpne", 3, OPERAND_BRANCH, 2, 0},
+        {OP_IF_ICMPLT, "if_icmplt", 3, OPERAND_BRANCH, 2, 0},
+        {OP_IF_ICMPGE, "if_icmpge", 3, OPERAND_BRANCH, 2, 0},
+        {OP_IF_ICMPGT, "if_icmpgt", 3, OPERAND_BRANCH, 2, 0},
+        {OP_IF_ICMPLE, "if_icmple", 3, OPERAND_BRANCH, 2, 0},
+        {OP_IF_ACMPEQ, "if_acmpeq", 3, OPERAND_BRANCH, 2, 0},
+        {OP_IF_ACMPNE, "if_acmpne", 3, OPERAND_BRANCH, 2, 0},
+        {OP_GOTO, "goto", 3, OPERAND_BRANCH, 0, 0},
+        {OP_JSR, "jsr", 3, OPERAND_BRANCH, 0, 1},
+        {OP_RET, "ret", 2, OPERAND_LOCAL, 0, 0},
+        {OP_TABLESWITCH, "tableswitch", 0, OPERAND_TABLESWITCH, 1, 0},
+        {OP_LOOKUPSWITCH, "lookupswitch", 0, OPERAND_LOOKUPSWITCH, 1, 0},
+        {OP_IRETURN, "ireturn", 1, OPERAND_NONE, 1, 0},
+        {OP_LRETURN, "lreturn", 1, OPERAND_NONE, 2, 0},
+        {OP_FRETURN, "freturn", 1, OPERAND_NONE, 1, 0},
+        {OP_DRETURN, "dreturn", 1, OPERAND_NONE, 2, 0},
+        {OP_ARETURN, "areturn", 1, OPERAND_NONE, 1, 0},
+        {OP_RETURN, "return", 1, OPERAND_NONE, 0, 0},
+        {OP_GETSTATIC, "getstatic", 3, OPERAND_FIELD, STACK_VARIABLE, STACK_VARIABLE},
+        {OP_PUTSTATIC, "putstatic", 3, OPERAND_FIELD, STACK_VARIABLE, STACK_VARIABLE},
+        {OP_GETFIELD, "getfield", 3, OPERAND_FIELD, STACK_VARIABLE, STACK_VARIABLE},
+        {OP_PUTFIELD, "putfield", 3, OPERAND_FIELD, STACK_VARIABLE, STACK_VARIABLE},
+        {OP_INVOKEVIRTUAL, "invokevirtual", 3, OPERAND_METHOD, STACK_VARIABLE, STACK_VARIABLE},
+        {OP_INVOKESPECIAL, "invokespecial", 3, OPERAND_METHOD, STACK_VARIABLE, STACK_VARIABLE},
+        {OP_INVOKESTATIC, "invokestatic", 3, OPERAND_METHOD, STACK_VARIABLE, STACK_VARIABLE},
+        {OP_INVOKEINTERFACE, "invokeinterface", 5, OPERAND_INVOKEINTERFACE, STACK_VARIABLE, STACK_VARIABLE},
+        {OP_INVOKEDYNAMIC, "invokedynamic", 5, OPERAND_INVOKEDYNAMIC, STACK_VARIABLE, STACK_VARIABLE},
+        {OP_NEW, "new", 3, OPERAND_CLASS, 0, 1},
+        {OP_NEWARRAY, "newarray", 2, OPERAND_ARRAY_TYPE, 1, 1},
+        {OP_ANEWARRAY, "anewarray", 3, OPERAND_CLASS, 1, 1},
+        {OP_ARRAYLENGTH, "arraylength", 1, OPERAND_NONE, 1, 1},
+        {OP_ATHROW, "athrow", 1, OPERAND_NONE, 1, 0},
+        {OP_CHECKCAST, "checkcast", 3, OPERAND_CLASS, 1, 1},
+        {OP_INSTANCEOF, "instanceof", 3, OPERAND_CLASS, 1, 1},
+        {OP_MONITORENTER, "monitorenter", 1, OPERAND_NONE, 1, 0},
+        {OP_MONITOREXIT, "monitorexit", 1, OPERAND_NONE, 1, 0},
+        {OP_WIDE, "wide", 0, OPERAND_WIDE, 0, 0},
+        {OP_MULTIANEWARRAY, "multianewarray", 4, OPERAND_MULTIANEWARRAY, STACK_VARIABLE, 1},
+        {OP_IFNULL, "ifnull", 3, OPERAND_BRANCH, 1, 0},
+        {OP_IFNONNULL, "ifnonnull", 3, OPERAND_BRANCH, 1, 0},
+        {OP_GOTO_W, "goto_w", 5, OPERAND_BRANCH_WIDE, 0, 0},
+        {OP_JSR_W, "jsr_w", 5, OPERAND_BRANCH_WIDE, 0, 1},
+        {OP_BREAKPOINT, "breakpoint", 1, OPERAND_NONE, 0, 0},
+        {OP_IMPDEP1, "impdep1", 1, OPERAND_NONE, 0, 0},
+        {OP_IMPDEP2, "impdep2", 1, OPERAND_NONE, 0, 0},
+    };
+    std::array<OpcodeInfo, 256> table{};
+    for (const OpcodeInfo &info: LIST) {
+        table[info.opcode] = info;
+    }
+    return table;
+}();
+
+inline Bytecode::Iterator::Iterator(const uint8_t *code, const uint32_t size, const uint32_t pc) : size(size) {
+    current.code = code;
+    advance(pc);
+}
+
+inline void Bytecode::Iterator::advance(const uint32_t pc) {
+    current.pc = pc;
+    if (pc >= size) {
+        current.pc = size;
+        current.length = 0;
+        return;
+    }
+    const OpcodeInfo &info = OPCODES[current.code[pc]];
+    current.length = info.length != 0 && pc + info.length <= size
+                         ? info.length
+                         : instruction_length({current.code, size}, pc);
+}
@@ -0,0 +1,33 @@
+#include "class_file.h"
+
+#include <utility>
+
+ClassFile::ClassFile(Token, std::vector<uint8_t> &&data, const ParseOptions options, SymbolTable *symbols)
+    : parser(std::move(data)) {
+    parser.set_symbol_table(symbols);
+    parser.parse(options);
+    parser.freeze();
+}
+
+ClassFile::ClassFile(Token, const std::string &filename, const ClassParser::LoadMode mode, const ParseOptions options,
+                     SymbolTable *symbols)
+    : parser(filename, mode) {
+    parser.set_symbol_table(symbols);
+    parser.parse(options);
+    parser.freeze();
+}
+
+std::shared_ptr<const ClassFile> ClassFile::parse(std::vector<uint8_t> &&data, const ParseOptions options,
+                                                  SymbolTable *symbols) {
+    return std::make_shared<const ClassFile>(Token{}, std::move(data), options, symbols);
+}
+
+std::shared_ptr<const ClassFile> ClassFile::parse(const std::span<const uint8_t> data, const ParseOptions options,
+                                                  SymbolTable *symbols) {
+    return parse(std::vector<uint8_t>(data.begin(), data.end()), options, symbols);
+}
+
+std::shared_ptr<const ClassFile> ClassFile::load(const std::string &filename, const ClassParser::LoadMode mode,
+                                                 const ParseOptions options, SymbolTable *symbols) {
+    return std::make_shared<const ClassFile>(Token{}, filename, mode, options, symbols);
+}
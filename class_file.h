@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "class_parser.h"
+
+// Immutable result of parsing one class. It owns the class bytes and a frozen parser, so every
+// accessor is const, performs no lazy work behind a lock, and may be called from any thread.
+// Instances are only handed out through shared_ptr<const ClassFile>.
+class ClassFile {
+    struct Token {};
+
+public:
+    typedef ClassParser::ParseOptions ParseOptions;
+    typedef ClassParser::MethodInfo MethodInfo;
+    typedef ClassParser::FieldInfo FieldInfo;
+    typedef ClassParser::ConstantPool ConstantPool;
+    typedef ClassParser::SpecializedAttribute SpecializedAttribute;
+    typedef ClassParser::CodeAttribute::AttributeInfo AttributeInfo;
+
+    static std::shared_ptr<const ClassFile> parse(std::vector<uint8_t> &&data,
+                                                  ParseOptions options = ClassParser::PARSE_DEFAULT,
+                                                  SymbolTable *symbols = nullptr);
+    static std::shared_ptr<const ClassFile> parse(std::span<const uint8_t> data,
+                                                  ParseOptions options = ClassParser::PARSE_DEFAULT,
+                                                  SymbolTable *symbols = nullptr);
+    static std::shared_ptr<const ClassFile> load(const std::string &filename,
+                                                 ClassParser::LoadMode mode = ClassParser::LOAD_MMAP,
+                                                 ParseOptions options = ClassParser::PARSE_DEFAULT,
+                                                 SymbolTable *symbols = nullptr);
+
+    ClassFile(Token, std::vector<uint8_t> &&data, ParseOptions options, SymbolTable *symbols);
+    ClassFile(Token, const std::string &filename, ClassParser::LoadMode mode, ParseOptions options,
+              SymbolTable *symbols);
+
+    ClassFile(const ClassFile &) = delete;
+    ClassFile &operator=(const ClassFile &) = delete;
+
+    uint16_t get_major_version() const { return parser.get_major_version(); }
+    uint16_t get_minor_version() const { return parser.get_minor_version(); }
+    uint16_t get_access_flags() const { return parser.get_access_flags(); }
+    std::string_view get_class_name() const { return parser.get_class_name(); }
+    std::string_view get_super_class_name() const { return parser.get_super_class_name(); }
+    SymbolTable::Symbol get_class_symbol() const { return parser.get_class_symbol(); }
+    SymbolTable::Symbol get_super_class_symbol() const { return parser.get_super_class_symbol(); }
+    SymbolTable *get_symbol_table() const { return parser.get_symbol_table(); }
+
+    const ConstantPool &get_constant_pool() const { return parser.get_constant_pool(); }
+    const std::pmr::vector<uint16_t> &get_interfaces() const { return parser.get_interfaces(); }
+    const std::pmr::vector<FieldInfo> &get_fields() const { return parser.get_fields(); }
+    const std::pmr::vector<MethodInfo> &get_methods() const { return parser.get_methods(); }
+    const std::pmr::vector<AttributeInfo> &get_class_attributes() const { return parser.get_class_attributes(); }
+
+    std::string_view get_utf8_view(uint16_t index) const { return parser.get_utf8_view(index); }
+    std::string_view get_class_name_view(uint16_t index) const { return parser.get_class_name_view(index); }
+
+    const MethodInfo *find_method(std::string_view name) const { return parser.find_method(name); }
+    const MethodInfo *find_method(std::string_view name, std::string_view descriptor) const {
+        return parser.find_method(name, descriptor);
+    }
+    const FieldInfo *find_field(std::string_view name) const { return parser.find_field(name); }
+    const FieldInfo *find_field(std::string_view name, std::string_view descriptor) const {
+        return parser.find_field(name, descriptor);
+    }
+
+    // Decoded on first use; concurrent callers agree on a single cached result.
+    const SpecializedAttribute &decode_attribute(const AttributeInfo &attribute) const {
+        return parser.decode_attribute(attribute);
+    }
+
+    std::string to_string() const { return parser.to_string(); }
+
+private:
+    ClassParser parser;
+};
@@ -1,10 +1,80 @@
 #include "class_parser.h"
+#include "class_visitor.h"
+#include "control_flow_graph.h"
+#include "modified_utf8.h"
 #include <iostream>
 #include <fstream>
 #include <cstring>
 #include <stdexcept>
 #include <sstream>
 #include <iomanip>
+#include <utility>
+
+typedef ClassParser::SpecializedAttribute Attr;
+
+static Attr::Type classify_attribute(const std::string_view name) {
+    static constexpr std::pair<std::string_view, Attr::Type> attribute_names[] = {
+        {"Code", Attr::CODE},
+        {"StackMapTable", Attr::STACK_MAP_TABLE},
+        {"LineNumberTable", Attr::LINE_NUMBER_TABLE},
+        {"LocalVariableTable", Attr::LOCAL_VARIABLE_TABLE},
+        {"LocalVariableTypeTable", Attr::LOCAL_VARIABLE_TYPE_TABLE},
+        {"Exceptions", Attr::EXCEPTIONS},
+        {"Signature", Attr::SIGNATURE},
+        {"RuntimeVisibleAnnotations", Attr::RUNTIME_VISIBLE_ANNOTATIONS},
+        {"RuntimeInvisibleAnnotations", Attr::RUNTIME_INVISIBLE_ANNOTATIONS},
+        {"RuntimeVisibleParameterAnnotations", Attr::RUNTIME_VISIBLE_PARAMETER_ANNOTATIONS},
+        {"RuntimeInvisibleParameterAnnotations", Attr::RUNTIME_INVISIBLE_PARAMETER_ANNOTATIONS},
+        {"RuntimeVisibleTypeAnnotations", Attr::RUNTIME_VISIBLE_TYPE_ANNOTATIONS},
+        {"RuntimeInvisibleTypeAnnotations", Attr::RUNTIME_INVISIBLE_TYPE_ANNOTATIONS},
+        {"AnnotationDefault", Attr::ANNOTATION_DEFAULT},
+        {"MethodParameters", Attr::METHOD_PARAMETERS},
+        {"ConstantValue", Attr::CONSTANT_VALUE},
+        {"SourceFile", Attr::SOURCE_FILE},
+        {"SourceDebugExtension", Attr::SOURCE_DEBUG_EXTENSION},
+        {"InnerClasses", Attr::INNER_CLASSES},
+        {"EnclosingMethod", Attr::ENCLOSING_METHOD},
+        {"BootstrapMethods", Attr::BOOTSTRAP_METHODS},
+        {"NestHost", Attr::NEST_HOST},
+        {"NestMembers", Attr::NEST_MEMBERS},
+        {"PermittedSubclasses", Attr::PERMITTED_SUBCLASSES},
+        {"Record", Attr::RECORD},
+        {"Deprecated", Attr::DEPRECATED},
+        {"Synthetic", Attr::SYNTHETIC},
+        {"Module", Attr::MODULE},
+        {"ModulePackages", Attr::MODULE_PACKAGES},
+        {"ModuleMainClass", Attr::MODULE_MAIN_CLASS},
+    };
+    for (const auto &[candidate, type]: attribute_names) {
+        if (candidate == name) {
+            return type;
+        }
+    }
+    return Attr::UNKNOWN;
+}
+
+static uint64_t skipped_attribute_kinds_for(const ClassParser::ParseOptions options) {
+    uint64_t kinds = 0;
+    const auto add = [&kinds](const std::initializer_list<Attr::Type> types) {
+        for (const Attr::Type type: types) {
+            kinds |= uint64_t{1} << type;
+        }
+    };
+    if (options & ClassParser::PARSE_SKIP_DEBUG) {
+        add({Attr::LINE_NUMBER_TABLE, Attr::LOCAL_VARIABLE_TABLE, Attr::LOCAL_VARIABLE_TYPE_TABLE,
+             Attr::SOURCE_FILE, Attr::SOURCE_DEBUG_EXTENSION, Attr::METHOD_PARAMETERS});
+    }
+    if (options & ClassParser::PARSE_SKIP_FRAMES) {
+        add({Attr::STACK_MAP_TABLE});
+    }
+    if (options & ClassParser::PARSE_SKIP_ANNOTATIONS) {
+        add({Attr::RUNTIME_VISIBLE_ANNOTATIONS, Attr::RUNTIME_INVISIBLE_ANNOTATIONS,
+             Attr::RUNTIME_VISIBLE_PARAMETER_ANNOTATIONS, Attr::RUNTIME_INVISIBLE_PARAMETER_ANNOTATIONS,
+             Attr::RUNTIME_VISIBLE_TYPE_ANNOTATIONS, Attr::RUNTIME_INVISIBLE_TYPE_ANNOTATIONS,
+             Attr::ANNOTATION_DEFAULT});
+    }
+    return kinds;
+}
 
 static std::string access_flags_to_string(uint16_t flags, bool is_method) {
     std::string result;
@@ -78,14 +148,51 @@ std::string ClassParser::ExceptionTableEntry::to_string() const {
     return oss.str();
 }
 
+ClassParser::CodeAttribute::AttributeInfo &ClassParser::CodeAttribute::AttributeInfo::operator=(
+    const AttributeInfo &other) {
+    if (this != &other) {
+        name_index = other.name_index;
+        name = other.name;
+        info = other.info;
+        view = other.view;
+        delete specialized.exchange(nullptr);
+    }
+    return *this;
+}
+
+ClassParser::CodeAttribute::AttributeInfo &ClassParser::CodeAttribute::AttributeInfo::operator=(
+    AttributeInfo &&other) noexcept {
+    if (this != &other) {
+        name_index = other.name_index;
+        name = other.name;
+        info = std::move(other.info);
+        view = other.view;
+        delete specialized.exchange(other.specialized.exchange(nullptr));
+    }
+    return *this;
+}
+
+ClassParser::CodeAttribute::AttributeInfo::~AttributeInfo() {
+    delete specialized.load(std::memory_order_relaxed);
+}
+
 std::string ClassParser::CodeAttribute::AttributeInfo::to_string() const {
-    return name + " (" + std::to_string(info.size()) + " bytes)";
+    return std::string(name) + " (" + std::to_string(bytes().size()) + " bytes)";
+}
+
+void ClassParser::CodeAttribute::clear() {
+    max_stack = 0;
+    max_locals = 0;
+    code.clear();
+    code_view = {};
+    exception_table.clear();
+    attributes.clear();
 }
 
 std::string ClassParser::CodeAttribute::to_string() const {
     std::ostringstream oss;
     oss << "Code[max_stack=" << max_stack << ", max_locals=" << max_locals
-            << ", code_size=" << code.size() << " bytes, exceptions=" << exception_table.size()
+            << ", code_size=" << bytecode().size() << " bytes, exceptions=" << exception_table.size()
             << ", attributes=" << attributes.size() << "]";
     return oss.str();
 }
@@ -268,41 +375,117 @@ std::string ClassParser::PermittedSubclassesAttribute::to_string() const {
 }
 
 std::string ClassParser::SpecializedAttribute::to_string() const {
-    switch (type) {
-        case SOURCE_FILE: return source_file.to_string();
-        case LINE_NUMBER_TABLE: return line_number_table.to_string();
-        case LOCAL_VARIABLE_TABLE: return local_variable_table.to_string();
-        case EXCEPTIONS: return exceptions.to_string();
-        case CONSTANT_VALUE: return constant_value.to_string();
-        case BOOTSTRAP_METHODS: return bootstrap_methods.to_string();
-        case SIGNATURE: return signature.to_string();
-        case DEPRECATED: return deprecated.to_string();
-        case SYNTHETIC: return synthetic.to_string();
-        case INNER_CLASSES: return inner_classes.to_string();
-        case ENCLOSING_METHOD: return enclosing_method.to_string();
-        case SOURCE_DEBUG_EXTENSION: return source_debug_extension.to_string();
-        case LOCAL_VARIABLE_TYPE_TABLE: return local_variable_type_table.to_string();
-        case METHOD_PARAMETERS: return method_parameters.to_string();
-        case RUNTIME_VISIBLE_ANNOTATIONS: return runtime_visible_annotations.to_string();
-        case RUNTIME_INVISIBLE_ANNOTATIONS: return runtime_invisible_annotations.to_string();
-        case RUNTIME_VISIBLE_PARAMETER_ANNOTATIONS: return runtime_visible_parameter_annotations.to_string();
-        case RUNTIME_INVISIBLE_PARAMETER_ANNOTATIONS: return runtime_invisible_parameter_annotations.to_string();
-        case RUNTIME_VISIBLE_TYPE_ANNOTATIONS: return runtime_visible_type_annotations.to_string();
-        case RUNTIME_INVISIBLE_TYPE_ANNOTATIONS: return runtime_invisible_type_annotations.to_string();
-        case ANNOTATION_DEFAULT: return annotation_default.to_string();
-        case MODULE: return module_attr.to_string();
-        case MODULE_PACKAGES: return module_packages.to_string();
-        case MODULE_MAIN_CLASS: return module_main_class.to_string();
-        case NEST_HOST: return nest_host.to_string();
-        case NEST_MEMBERS: return nest_members.to_string();
-        case RECORD: return record.to_string();
-        case PERMITTED_SUBCLASSES: return permitted_subclasses.to_string();
-        default: return "UnknownAttribute[" + name + ", " + std::to_string(raw_data.size()) + " bytes]";
+    return std::visit([this](const auto &attr) -> std::string {
+        if constexpr (std::is_same_v<std::decay_t<decltype(attr)>, std::monostate>) {
+            return "UnknownAttribute[" + std::string(name) + ", " + std::to_string(length) + " bytes]";
+        } else {
+            return attr.to_string();
+        }
+    }, value);
+}
+
+ClassParser::MethodInfo::MethodInfo(const MethodInfo &other, const allocator_type &allocator)
+    : access_flags(other.access_flags), name_index(other.name_index), descriptor_index(other.descriptor_index),
+      attributes_count(other.attributes_count), name(other.name), descriptor(other.descriptor),
+      name_symbol(other.name_symbol), descriptor_symbol(other.descriptor_symbol),
+      attributes(other.attributes, allocator) {
+    if (other.code_attribute) {
+        code_attribute.emplace(*other.code_attribute, allocator);
+    }
+}
+
+ClassParser::MethodInfo::MethodInfo(MethodInfo &&other, const allocator_type &allocator)
+    : access_flags(other.access_flags), name_index(other.name_index), descriptor_index(other.descriptor_index),
+      attributes_count(other.attributes_count), name(other.name), descriptor(other.descriptor),
+      name_symbol(other.name_symbol), descriptor_symbol(other.descriptor_symbol),
+      attributes(std::move(other.attributes), allocator),
+      control_flow_graph(other.control_flow_graph.exchange(nullptr)) {
+    if (other.code_attribute) {
+        code_attribute.emplace(std::move(*other.code_attribute), allocator);
+    }
+}
+
+ClassParser::MethodInfo::MethodInfo(const MethodInfo &other)
+    : access_flags(other.access_flags), name_index(other.name_index), descriptor_index(other.descriptor_index),
+      attributes_count(other.attributes_count), code_attribute(other.code_attribute), name(other.name),
+      descriptor(other.descriptor), name_symbol(other.name_symbol), descriptor_symbol(other.descriptor_symbol),
+      attributes(other.attributes) {
+}
+
+ClassParser::MethodInfo::MethodInfo(MethodInfo &&other) noexcept
+    : access_flags(other.access_flags), name_index(other.name_index), descriptor_index(other.descriptor_index),
+      attributes_count(other.attributes_count), code_attribute(std::move(other.code_attribute)), name(other.name),
+      descriptor(other.descriptor), name_symbol(other.name_symbol), descriptor_symbol(other.descriptor_symbol),
+      attributes(std::move(other.attributes)), control_flow_graph(other.control_flow_graph.exchange(nullptr)) {
+}
+
+ClassParser::MethodInfo &ClassParser::MethodInfo::operator=(const MethodInfo &other) {
+    if (this != &other) {
+        access_flags = other.access_flags;
+        name_index = other.name_index;
+        descriptor_index = other.descriptor_index;
+        attributes_count = other.attributes_count;
+        code_attribute = other.code_attribute;
+        name = other.name;
+        descriptor = other.descriptor;
+        name_symbol = other.name_symbol;
+        descriptor_symbol = other.descriptor_symbol;
+        attributes = other.attributes;
+        delete control_flow_graph.exchange(nullptr);
+    }
+    return *this;
+}
+
+ClassParser::MethodInfo &ClassParser::MethodInfo::operator=(MethodInfo &&other) noexcept {
+    if (this != &other) {
+        access_flags = other.access_flags;
+        name_index = other.name_index;
+        descriptor_index = other.descriptor_index;
+        attributes_count = other.attributes_count;
+        code_attribute = std::move(other.code_attribute);
+        name = other.name;
+        descriptor = other.descriptor;
+        name_symbol = other.name_symbol;
+        descriptor_symbol = other.descriptor_symbol;
+        attributes = std::move(other.attributes);
+        delete control_flow_graph.exchange(other.control_flow_graph.exchange(nullptr));
     }
+    return *this;
 }
 
 ClassParser::MethodInfo::~MethodInfo() {
-    delete code_attribute;
+    delete control_flow_graph.load(std::memory_order_relaxed);
+}
+
+// Reuses the existing CodeAttribute, and its capacity, when the method is parsed again.
+ClassParser::CodeAttribute *ClassParser::MethodInfo::new_code_attribute() {
+    delete control_flow_graph.exchange(nullptr);
+    if (code_attribute) {
+        code_attribute->clear();
+    } else {
+        code_attribute.emplace(attributes.get_allocator());
+    }
+    return &*code_attribute;
+}
+
+void ClassParser::MethodInfo::reset_code_attribute() {
+    delete control_flow_graph.exchange(nullptr);
+    code_attribute.reset();
+}
+
+const ControlFlowGraph &ClassParser::MethodInfo::get_control_flow_graph() const {
+    const ControlFlowGraph *graph = control_flow_graph.load(std::memory_order_acquire);
+    if (graph == nullptr) {
+        if (!code_attribute) {
+            throw std::runtime_error("Method has no Code attribute: " + std::string(name) + std::string(descriptor));
+        }
+        auto fresh = std::make_unique<const ControlFlowGraph>(*code_attribute);
+        if (control_flow_graph.compare_exchange_strong(graph, fresh.get(), std::memory_order_acq_rel,
+                                                       std::memory_order_acquire)) {
+            graph = fresh.release();
+        }
+    }
+    return *graph;
 }
 
 std::string ClassParser::MethodInfo::to_string() const {
@@ -314,27 +497,132 @@ std::string ClassParser::MethodInfo::to_string() const {
     return oss.str();
 }
 
+std::string ClassParser::ClassSummary::to_string() const {
+    std::string result = access_flags_to_string(access_flags, false) + " " + class_name;
+    if (!super_class_name.empty()) {
+        result += " extends " + super_class_name;
+    }
+    for (size_t i = 0; i < interfaces.size(); ++i) {
+        result += (i == 0 ? " implements " : ", ") + interfaces[i];
+    }
+    return result + " (version " + std::to_string(major_version) + "." + std::to_string(minor_version) + ")";
+}
+
 std::string ClassParser::FieldInfo::to_string() const {
     return "Field[" + access_flags_to_string(access_flags, false) + " " +
-           name + " " + descriptor +
+           std::string(name) + " " + std::string(descriptor) +
            ", attributes=" + std::to_string(attributes.size()) + "]";
 }
 
-ClassParser::ClassParser(const std::string &filename) : filename(filename), file_data(nullptr) {
-    if (!load_file()) {
+void ClassParser::ConstantPool::reset(const uint16_t count, const uint8_t *class_data) {
+    tags.assign(count, 0);
+    slots.assign(count, 0);
+    text.clear();
+    source = class_data;
+    pending_bytes = 0;
+}
+
+std::string_view ClassParser::ConstantPool::resolve_utf8(const uint16_t index) const {
+    uint64_t &slot = slots[index];
+    const size_t length = slot & UTF8_LENGTH_MASK;
+    const uint8_t *bytes = source + (slot >> 32);
+
+    if (modified_utf8_ascii_prefix(bytes, length) == length) {
+        slot = (slot & ~UTF8_PENDING) | UTF8_SOURCE;
+        return {reinterpret_cast<const char *>(bytes), length};
+    }
+
+    // Reserving every pending byte up front keeps views into text valid as more entries decode.
+    if (text.empty()) {
+        text.reserve(pending_bytes);
+    }
+    const size_t offset = text.size();
+    text.resize(offset + length);
+    const size_t written = modified_utf8_decode(bytes, length, text.data() + offset);
+    text.resize(offset + written);
+    slot = static_cast<uint64_t>(offset) << 32 | written;
+    return {text.data() + offset, written};
+}
+
+void ClassParser::ConstantPool::resolve_all() const {
+    for (size_t i = 1; i < tags.size(); ++i) {
+        if (tags[i] == CONSTANT_Utf8 && (slots[i] & UTF8_PENDING)) {
+            resolve_utf8(static_cast<uint16_t>(i));
+        }
+    }
+}
+
+ClassParser::ConstantPoolInfo ClassParser::ConstantPool::operator[](const uint16_t index) const {
+    ConstantPoolInfo info;
+    info.tag = tag(index);
+    switch (info.tag) {
+        case CONSTANT_Utf8:
+            info.s_val = utf8(index);
+            break;
+        case CONSTANT_Integer:
+        case CONSTANT_Float:
+            info.i_val = int_bits(index);
+            break;
+        case CONSTANT_Long:
+        case CONSTANT_Double:
+            info.l_val = long_bits(index);
+            break;
+        case CONSTANT_MethodHandle:
+            info.reference_kind = reference_kind(index);
+            info.index2 = index2(index);
+            break;
+        case 0:
+            break;
+        default:
+            info.index1 = index1(index);
+            info.index2 = index2(index);
+            break;
+    }
+    return info;
+}
+
+ClassParser::ClassParser(std::pmr::memory_resource *resource) : allocator(resource), filename("<memory>") {
+}
+
+ClassParser::ClassParser(const std::string &filename, const LoadMode mode, std::pmr::memory_resource *resource)
+    : allocator(resource), filename(filename) {
+    if (!(mode == LOAD_MMAP ? map_file() : load_file())) {
         throw std::runtime_error("Failed to load file: " + filename);
     }
 }
 
+ClassParser::ClassParser(const std::span<const uint8_t> data, std::pmr::memory_resource *resource)
+    : allocator(resource), filename("<memory>"), file_data(data.data()), file_size(data.size()) {
+}
+
+ClassParser::ClassParser(std::vector<uint8_t> &&data, std::pmr::memory_resource *resource)
+    : allocator(resource), filename("<memory>"), owned_data(std::move(data)) {
+    file_data = owned_data.data();
+    file_size = owned_data.size();
+}
+
 ClassParser::~ClassParser() {
-    for (auto p: constant_pool) {
-        delete p;
-    }
-    constant_pool.clear();
+    file_data = nullptr;
+}
+
+void ClassParser::reset(const std::span<const uint8_t> data) {
+    mapped_file.close();
+    owned_data.clear();
+    filename = "<memory>";
+    file_data = data.data();
+    file_size = data.size();
+    cursor = 0;
+}
 
-    if (file_data) {
-        delete[] file_data;
-        file_data = nullptr;
+void ClassParser::reset(const std::string &filename, const LoadMode mode) {
+    mapped_file.close();
+    owned_data.clear();
+    this->filename = filename;
+    file_data = nullptr;
+    file_size = 0;
+    cursor = 0;
+    if (!(mode == LOAD_MMAP ? map_file() : load_file())) {
+        throw std::runtime_error("Failed to load file: " + filename);
     }
 }
 
@@ -345,9 +633,19 @@ bool ClassParser::load_file() {
     }
     file_size = file.tellg();
     file.seekg(0, std::ios::beg);
-    file_data = new uint8_t[file_size];
-    file.read(reinterpret_cast<char *>(file_data), file_size);
+    owned_data.resize(file_size);
+    file.read(reinterpret_cast<char *>(owned_data.data()), file_size);
     file.close();
+    file_data = owned_data.data();
+    return true;
+}
+
+bool ClassParser::map_file() {
+    if (!mapped_file.open(filename, MappedFile::ACCESS_SEQUENTIAL)) {
+        return false;
+    }
+    file_data = mapped_file.data();
+    file_size = mapped_file.size();
     return true;
 }
 
@@ -359,6 +657,11 @@ void ClassParser::ensure_available(const size_t bytes) const {
     }
 }
 
+void ClassParser::skip(const size_t bytes) {
+    ensure_available(bytes);
+    cursor += bytes;
+}
+
 uint8_t ClassParser::read_uint8() {
     ensure_available(1);
     return file_data[cursor++];
@@ -395,43 +698,112 @@ uint64_t ClassParser::read_uint64() {
     return value;
 }
 
-std::string ClassParser::read_modified_utf8(uint16_t length) {
+size_t ClassParser::read_modified_utf8(const uint16_t length, char *out) {
     ensure_available(length);
-    std::string result;
-    result.reserve(length);
-
-    for (uint16_t i = 0; i < length; ++i) {
-        if (const uint8_t b1 = file_data[cursor + i]; b1 == 0) {
-            result += '\0';
-        } else if ((b1 & 0x80) == 0) {
-            result += static_cast<char>(b1);
-        } else if ((b1 & 0xE0) == 0xC0) {
-            if (i + 1 >= length) break;
-            const uint8_t b2 = file_data[cursor + i + 1];
-            if ((b2 & 0xC0) != 0x80) break;
-
-            const uint16_t code_point = ((b1 & 0x1F) << 6) | (b2 & 0x3F);
-            result += static_cast<char>(code_point);
-            i += 1;
-        } else if ((b1 & 0xF0) == 0xE0) {
-            if (i + 2 >= length) break;
-            const uint8_t b2 = file_data[cursor + i + 1];
-            const uint8_t b3 = file_data[cursor + i + 2];
-            if ((b2 & 0xC0) != 0x80 || (b3 & 0xC0) != 0x80) break;
-
-            const uint16_t code_point = ((b1 & 0x0F) << 12) | ((b2 & 0x3F) << 6) | (b3 & 0x3F);
-            result += static_cast<char>(code_point);
-            i += 2;
-        } else {
-            result += '?';
+    const size_t written = modified_utf8_decode(file_data + cursor, length, out);
+    cursor += length;
+    return written;
+}
+
+void ClassParser::parse(const ParseOptions options) {
+    parse_header(options);
+    parse_fields();
+    parse_methods();
+
+    class_attributes.clear();
+    parse_attributes(read_uint16(), nullptr, nullptr, &class_attributes);
+}
+
+void ClassParser::parse(ClassVisitor &visitor, const ParseOptions options) {
+    parse_header(options);
+    fields.clear();
+    methods.clear();
+    class_attributes.clear();
+
+    visitor.visit_header(*this);
+    if (visitor.visit_constant_pool(constant_pool.size()) == ClassVisitor::CONTINUE) {
+        for (uint16_t i = 1; i < constant_pool.size(); ++i) {
+            if (constant_pool.tag(i) != 0) {
+                visitor.visit_constant(i, constant_pool[i]);
+            }
         }
     }
 
-    cursor += length;
-    return result;
+    const uint16_t fields_count = read_uint16();
+    for (int i = 0; i < fields_count; ++i) {
+        const uint16_t field_access_flags = read_uint16();
+        const uint16_t name_index = read_uint16();
+        const uint16_t descriptor_index = read_uint16();
+        const uint16_t attributes_count = read_uint16();
+        if ((options & PARSE_SKIP_FIELDS) ||
+            visitor.visit_field(field_access_flags, get_utf8_view(name_index),
+                                get_utf8_view(descriptor_index)) == ClassVisitor::SKIP) {
+            skip_attributes(attributes_count);
+            continue;
+        }
+        visit_attributes(visitor, ClassVisitor::ATTRIBUTE_FIELD, attributes_count);
+        visitor.visit_field_end();
+    }
+
+    const uint16_t methods_count = read_uint16();
+    for (int i = 0; i < methods_count; ++i) {
+        const uint16_t method_access_flags = read_uint16();
+        const uint16_t name_index = read_uint16();
+        const uint16_t descriptor_index = read_uint16();
+        const uint16_t attributes_count = read_uint16();
+        if ((options & PARSE_SKIP_METHODS) ||
+            visitor.visit_method(method_access_flags, get_utf8_view(name_index),
+                                 get_utf8_view(descriptor_index)) == ClassVisitor::SKIP) {
+            skip_attributes(attributes_count);
+            continue;
+        }
+        visit_attributes(visitor, ClassVisitor::ATTRIBUTE_METHOD, attributes_count);
+        visitor.visit_method_end();
+    }
+
+    visit_attributes(visitor, ClassVisitor::ATTRIBUTE_CLASS, read_uint16());
+    visitor.visit_end();
+}
+
+void ClassParser::parse(const std::span<const uint8_t> data, const ParseOptions options) {
+    reset(data);
+    parse(options);
+}
+
+ClassParser::ClassSummary ClassParser::scan_header(const std::span<const uint8_t> data) {
+    ClassParser parser(data);
+    parser.parse_header(PARSE_LAZY_UTF8);
+    return parser.summarize();
+}
+
+ClassParser::ClassSummary ClassParser::scan_header(const std::string &filename) {
+    ClassParser parser(filename, LOAD_MMAP);
+    parser.parse_header(PARSE_LAZY_UTF8);
+    return parser.summarize();
+}
+
+ClassParser::ClassSummary ClassParser::summarize() const {
+    ClassSummary summary;
+    summary.minor_version = minor_version;
+    summary.major_version = major_version;
+    summary.access_flags = access_flags;
+    summary.class_name = class_name;
+    if (super_class_index != 0) {
+        summary.super_class_name = super_class_name;
+    }
+    summary.interfaces.reserve(interfaces.size());
+    for (const uint16_t interface: interfaces) {
+        summary.interfaces.push_back(get_class_name(interface));
+    }
+    return summary;
 }
 
-void ClassParser::parse() {
+void ClassParser::parse_header(const ParseOptions options) {
+    this->options = options;
+    skipped_attribute_kinds = skipped_attribute_kinds_for(options);
+    method_index.clear();
+    field_index.clear();
+    member_references.clear();
     cursor = 0;
 
     magic = read_uint32();
@@ -453,79 +825,87 @@ void ClassParser::parse() {
     this_class_index = read_uint16();
     super_class_index = read_uint16();
 
-    class_name = get_class_name(this_class_index);
-    super_class_name = get_super_class_name(super_class_index);
+    class_name = get_class_name_view(this_class_index);
+    super_class_name = super_class_index != 0 ? get_class_name_view(super_class_index) : "java/lang/Object";
+    class_symbol = symbols ? symbols->intern(class_name) : SymbolTable::NO_SYMBOL;
+    super_class_symbol = symbols && super_class_index != 0 ? symbols->intern(super_class_name) : SymbolTable::NO_SYMBOL;
 
     parse_interfaces();
-    parse_fields();
-    parse_methods();
-
-    class_attributes.clear();
-    parse_attributes(read_uint16(), nullptr, nullptr, &class_attributes);
 }
 
 void ClassParser::parse_constant_pool() {
     const uint16_t cp_count = read_uint16();
-    constant_pool.resize(cp_count, nullptr);
+    const bool lazy_utf8 = options & PARSE_LAZY_UTF8;
+    constant_pool.reset(cp_count, file_data);
+    attribute_kinds.assign(cp_count, ATTRIBUTE_KIND_UNRESOLVED);
+    if (symbols) {
+        pool_symbols.assign(cp_count, SymbolTable::NO_SYMBOL);
+    }
+    if (!lazy_utf8) {
+        constant_pool.text.reserve(file_size - cursor);
+    }
 
     for (int i = 1; i < cp_count; ++i) {
         const uint8_t tag = read_uint8();
-        ConstantPoolInfo *info = new ConstantPoolInfo();
-        info->tag = tag;
+        uint64_t slot = 0;
 
         switch (tag) {
             case CONSTANT_Utf8: {
                 const uint16_t length = read_uint16();
-                info->s_val = read_modified_utf8(length);
+                if (lazy_utf8) {
+                    ensure_available(length);
+                    slot = static_cast<uint64_t>(cursor) << 32 | ConstantPool::UTF8_PENDING | length;
+                    constant_pool.pending_bytes += length;
+                    cursor += length;
+                    break;
+                }
+                std::pmr::vector<char> &text = constant_pool.text;
+                const size_t offset = text.size();
+                text.resize(offset + length);
+                const size_t written = read_modified_utf8(length, text.data() + offset);
+                text.resize(offset + written);
+                slot = static_cast<uint64_t>(offset) << 32 | written;
                 break;
             }
             case CONSTANT_Integer:
-                info->i_val = read_uint32();
-                break;
             case CONSTANT_Float:
-                info->i_val = read_uint32();
+                slot = read_uint32();
                 break;
             case CONSTANT_Long:
-                info->l_val = read_uint64();
-                i++;
-                break;
             case CONSTANT_Double:
-                info->l_val = read_uint64();
-                i++;
+                slot = read_uint64();
                 break;
             case CONSTANT_Class:
             case CONSTANT_String:
-                info->index1 = read_uint16();
+            case CONSTANT_MethodType:
+            case CONSTANT_Module:
+            case CONSTANT_Package:
+                slot = static_cast<uint64_t>(read_uint16()) << 16;
                 break;
             case CONSTANT_Fieldref:
             case CONSTANT_Methodref:
             case CONSTANT_InterfaceMethodref:
             case CONSTANT_NameAndType:
-                info->index1 = read_uint16();
-                info->index2 = read_uint16();
-                break;
-            case CONSTANT_MethodHandle:
-                info->reference_kind = read_uint8();
-                info->index2 = read_uint16();
-                break;
-            case CONSTANT_MethodType:
-                info->index1 = read_uint16();
-                break;
             case CONSTANT_InvokeDynamic:
-            case CONSTANT_Dynamic:
-                info->index1 = read_uint16();
-                info->index2 = read_uint16();
+            case CONSTANT_Dynamic: {
+                const uint16_t index1 = read_uint16();
+                slot = static_cast<uint64_t>(index1) << 16 | read_uint16();
                 break;
-            case CONSTANT_Module:
-            case CONSTANT_Package:
-                info->index1 = read_uint16();
+            }
+            case CONSTANT_MethodHandle: {
+                const uint8_t reference_kind = read_uint8();
+                slot = static_cast<uint64_t>(reference_kind) << 16 | read_uint16();
                 break;
+            }
             default:
-                delete info;
                 throw std::runtime_error("Unsupported constant pool tag: " +
                                          std::to_string(tag));
         }
-        constant_pool[i] = info;
+        constant_pool.tags[i] = tag;
+        constant_pool.slots[i] = slot;
+        if (tag == CONSTANT_Long || tag == CONSTANT_Double) {
+            i++;
+        }
     }
 }
 
@@ -539,6 +919,14 @@ void ClassParser::parse_interfaces() {
 
 void ClassParser::parse_fields() {
     const uint16_t fields_count = read_uint16();
+    if (options & PARSE_SKIP_FIELDS) {
+        fields.clear();
+        for (int i = 0; i < fields_count; ++i) {
+            skip(6);
+            skip_attributes(read_uint16());
+        }
+        return;
+    }
     fields.resize(fields_count);
     for (int i = 0; i < fields_count; ++i) {
         fields[i].access_flags = read_uint16();
@@ -546,8 +934,12 @@ void ClassParser::parse_fields() {
         fields[i].descriptor_index = read_uint16();
         fields[i].attributes_count = read_uint16();
 
-        fields[i].name = get_utf8_string(fields[i].name_index);
-        fields[i].descriptor = get_utf8_string(fields[i].descriptor_index);
+        fields[i].name = get_utf8_view(fields[i].name_index);
+        fields[i].descriptor = get_utf8_view(fields[i].descriptor_index);
+        if (symbols) {
+            fields[i].name_symbol = intern_utf8(fields[i].name_index);
+            fields[i].descriptor_symbol = intern_utf8(fields[i].descriptor_index);
+        }
 
         fields[i].attributes.clear();
         parse_attributes(fields[i].attributes_count, nullptr, &fields[i],
@@ -557,6 +949,14 @@ void ClassParser::parse_fields() {
 
 void ClassParser::parse_methods() {
     const uint16_t methods_count = read_uint16();
+    if (options & PARSE_SKIP_METHODS) {
+        methods.clear();
+        for (int i = 0; i < methods_count; ++i) {
+            skip(6);
+            skip_attributes(read_uint16());
+        }
+        return;
+    }
     methods.resize(methods_count);
     for (int i = 0; i < methods_count; ++i) {
         methods[i].access_flags = read_uint16();
@@ -564,34 +964,50 @@ void ClassParser::parse_methods() {
         methods[i].descriptor_index = read_uint16();
         methods[i].attributes_count = read_uint16();
 
-        methods[i].name = get_utf8_string(methods[i].name_index);
-        methods[i].descriptor = get_utf8_string(methods[i].descriptor_index);
+        methods[i].name = get_utf8_view(methods[i].name_index);
+        methods[i].descriptor = get_utf8_view(methods[i].descriptor_index);
+        if (symbols) {
+            methods[i].name_symbol = intern_utf8(methods[i].name_index);
+            methods[i].descriptor_symbol = intern_utf8(methods[i].descriptor_index);
+        }
 
         methods[i].attributes.clear();
-        methods[i].code_attribute = nullptr;
-        parse_attributes(methods[i].attributes_count, &methods[i], nullptr,
-                         &methods[i].attributes);
+        if (!parse_attributes(methods[i].attributes_count, &methods[i], nullptr,
+                              &methods[i].attributes)) {
+            methods[i].reset_code_attribute();
+        }
     }
 }
 
-void ClassParser::parse_attributes(const uint16_t count, MethodInfo *method,
+// Returns true when a Code attribute was read into method.
+bool ClassParser::parse_attributes(const uint16_t count, MethodInfo *method,
                                    FieldInfo *field,
-                                   std::vector<CodeAttribute::AttributeInfo> *out_attrs) {
+                                   std::pmr::vector<CodeAttribute::AttributeInfo> *out_attrs) {
+    bool found_code = false;
     for (int i = 0; i < count; ++i) {
         const uint16_t attribute_name_index = read_uint16();
         const uint32_t attribute_length = read_uint32();
 
-        std::string attribute_name = get_utf8_string(attribute_name_index);
+        const SpecializedAttribute::Type kind = attribute_kind(attribute_name_index);
+        const bool is_code = kind == SpecializedAttribute::CODE && method != nullptr;
 
-        if (attribute_name == "Code" && method != nullptr) {
-            CodeAttribute *code_attr = new CodeAttribute();
+        if ((out_attrs == nullptr && !is_code) || is_skipped_attribute(kind) ||
+            (is_code && (options & PARSE_SKIP_CODE))) {
+            skip(attribute_length);
+        } else if (is_code) {
+            CodeAttribute *code_attr = method->new_code_attribute();
+            found_code = true;
             code_attr->max_stack = read_uint16();
             code_attr->max_locals = read_uint16();
 
             uint32_t code_length = read_uint32();
             ensure_available(code_length);
-            code_attr->code.resize(code_length);
-            memcpy(code_attr->code.data(), file_data + cursor, code_length);
+            if (options & PARSE_BORROW_ATTRIBUTES) {
+                code_attr->code_view = {file_data + cursor, code_length};
+            } else {
+                code_attr->code.resize(code_length);
+                memcpy(code_attr->code.data(), file_data + cursor, code_length);
+            }
             cursor += code_length;
 
             const uint16_t exception_table_length = read_uint16();
@@ -608,39 +1024,183 @@ void ClassParser::parse_attributes(const uint16_t count, MethodInfo *method,
             for (uint16_t a = 0; a < code_attributes_count; ++a) {
                 const uint16_t ca_name_index = read_uint16();
                 const uint32_t ca_len = read_uint32();
-                const std::string ca_name = get_utf8_string(ca_name_index);
-
-                CodeAttribute::AttributeInfo ai;
-                ai.name = ca_name;
-                ai.info.resize(ca_len);
-                ensure_available(ca_len);
-                memcpy(ai.info.data(), file_data + cursor, ca_len);
-                cursor += ca_len;
-                code_attr->attributes.push_back(std::move(ai));
+                if (is_skipped_attribute(attribute_kind(ca_name_index))) {
+                    skip(ca_len);
+                    continue;
+                }
+
+                CodeAttribute::AttributeInfo &ai = code_attr->attributes.emplace_back();
+                ai.name_index = ca_name_index;
+                ai.name = get_utf8_view(ca_name_index);
+                read_attribute_payload(ca_len, ai);
             }
+        } else {
+            CodeAttribute::AttributeInfo &ai = out_attrs->emplace_back();
+            ai.name_index = attribute_name_index;
+            ai.name = get_utf8_view(attribute_name_index);
+            read_attribute_payload(attribute_length, ai);
+        }
+    }
+    return found_code;
+}
+
+void ClassParser::read_attribute_payload(const uint32_t length, CodeAttribute::AttributeInfo &attribute) {
+    ensure_available(length);
+    if (options & PARSE_BORROW_ATTRIBUTES) {
+        attribute.view = {file_data + cursor, length};
+    } else {
+        attribute.info.resize(length);
+        memcpy(attribute.info.data(), file_data + cursor, length);
+    }
+    cursor += length;
+}
+
+void ClassParser::skip_attributes(const uint16_t count) {
+    for (int i = 0; i < count; ++i) {
+        skip(2);
+        skip(read_uint32());
+    }
+}
 
-            method->code_attribute = code_attr;
+void ClassParser::visit_attributes(ClassVisitor &visitor, const int target, const uint16_t count) {
+    for (int i = 0; i < count; ++i) {
+        const uint16_t name_index = read_uint16();
+        const uint32_t length = read_uint32();
+        ensure_available(length);
+
+        const SpecializedAttribute::Type kind = attribute_kind(name_index);
+        if (is_skipped_attribute(kind)) {
+            cursor += length;
+        } else if (target == ClassVisitor::ATTRIBUTE_METHOD && kind == SpecializedAttribute::CODE) {
+            visit_code(visitor, length);
         } else {
-            CodeAttribute::AttributeInfo ai;
-            ai.name = attribute_name;
-            ai.info.resize(attribute_length);
-            ensure_available(attribute_length);
-            memcpy(ai.info.data(), file_data + cursor, attribute_length);
-            cursor += attribute_length;
-
-            if (out_attrs != nullptr) {
-                out_attrs->push_back(std::move(ai));
-            }
+            visitor.visit_attribute(static_cast<ClassVisitor::AttributeTarget>(target), get_utf8_view(name_index),
+                                    {file_data + cursor, length});
+            cursor += length;
         }
     }
 }
 
+void ClassParser::visit_code(ClassVisitor &visitor, const uint32_t length) {
+    const size_t end = cursor + length;
+    if (options & PARSE_SKIP_CODE) {
+        cursor = end;
+        return;
+    }
+
+    const uint16_t max_stack = read_uint16();
+    const uint16_t max_locals = read_uint16();
+    const uint32_t code_length = read_uint32();
+    ensure_available(code_length);
+    const std::span<const uint8_t> code(file_data + cursor, code_length);
+    cursor += code_length;
+    if (visitor.visit_code(max_stack, max_locals, code) == ClassVisitor::SKIP) {
+        cursor = end;
+        return;
+    }
+
+    const uint16_t exception_table_length = read_uint16();
+    for (uint16_t e = 0; e < exception_table_length; ++e) {
+        ExceptionTableEntry entry;
+        entry.start_pc = read_uint16();
+        entry.end_pc = read_uint16();
+        entry.handler_pc = read_uint16();
+        entry.catch_type = read_uint16();
+        visitor.visit_exception_handler(entry);
+    }
+    visit_attributes(visitor, ClassVisitor::ATTRIBUTE_CODE, read_uint16());
+    if (cursor != end) {
+        throw std::runtime_error("Code attribute length mismatch");
+    }
+}
+
+SymbolTable::Symbol ClassParser::intern_utf8(const uint16_t index) {
+    if (pool_symbols[index] == SymbolTable::NO_SYMBOL) {
+        pool_symbols[index] = symbols->intern(get_utf8_view(index));
+    }
+    return pool_symbols[index];
+}
+
+bool ClassParser::is_skipped_attribute(const SpecializedAttribute::Type kind) const {
+    return skipped_attribute_kinds >> kind & 1;
+}
+
+// Each attribute name is classified once per class; later lookups are a single table read.
+ClassParser::SpecializedAttribute::Type ClassParser::attribute_kind(const uint16_t name_index) const {
+    if (name_index < attribute_kinds.size() && attribute_kinds[name_index] != ATTRIBUTE_KIND_UNRESOLVED) {
+        return static_cast<SpecializedAttribute::Type>(attribute_kinds[name_index]);
+    }
+    const SpecializedAttribute::Type kind = classify_attribute(get_utf8_view(name_index));
+    attribute_kinds[name_index] = kind;
+    return kind;
+}
+
 ClassParser::MethodInfo *ClassParser::find_main_method() {
     return find_method("main", "([Ljava/lang/String;)V");
 }
 
-ClassParser::MethodInfo *ClassParser::find_method(const std::string &name) {
-    for (MethodInfo &m: methods) {
+const ClassParser::MethodInfo *ClassParser::find_main_method() const {
+    return find_method("main", "([Ljava/lang/String;)V");
+}
+
+size_t ClassParser::MemberKeyHash::operator()(const MemberKey &key) const {
+    const size_t h = std::hash<std::string_view>()(key.name);
+    return h ^ (std::hash<std::string_view>()(key.descriptor) + 0x9E3779B97F4A7C15ULL + (h << 6) + (h >> 2));
+}
+
+template<typename Member>
+void ClassParser::MemberIndex::build(const std::pmr::vector<Member> &members) {
+    by_name.reserve(members.size());
+    by_signature.reserve(members.size());
+    for (size_t i = 0; i < members.size(); ++i) {
+        by_name.emplace(members[i].name, i);
+        by_signature.emplace(MemberKey{members[i].name, members[i].descriptor}, i);
+    }
+    built = true;
+}
+
+void ClassParser::MemberIndex::clear() {
+    by_name.clear();
+    by_signature.clear();
+    built = false;
+}
+
+ClassParser::MethodInfo *ClassParser::find_method(const std::string_view name) {
+    if (!method_index.built) {
+        method_index.build(methods);
+    }
+    return const_cast<MethodInfo *>(std::as_const(*this).find_method(name));
+}
+
+ClassParser::MethodInfo *ClassParser::find_method(const std::string_view name, const std::string_view descriptor) {
+    if (!method_index.built) {
+        method_index.build(methods);
+    }
+    return const_cast<MethodInfo *>(std::as_const(*this).find_method(name, descriptor));
+}
+
+ClassParser::FieldInfo *ClassParser::find_field(const std::string_view name) {
+    if (!field_index.built) {
+        field_index.build(fields);
+    }
+    return const_cast<FieldInfo *>(std::as_const(*this).find_field(name));
+}
+
+ClassParser::FieldInfo *ClassParser::find_field(const std::string_view name, const std::string_view descriptor) {
+    if (!field_index.built) {
+        field_index.build(fields);
+    }
+    return const_cast<FieldInfo *>(std::as_const(*this).find_field(name, descriptor));
+}
+
+// The const lookups never build an index; they fall back to a linear scan until freeze() or a
+// non-const lookup has built one.
+const ClassParser::MethodInfo *ClassParser::find_method(const std::string_view name) const {
+    if (method_index.built) {
+        const auto it = method_index.by_name.find(name);
+        return it == method_index.by_name.end() ? nullptr : &methods[it->second];
+    }
+    for (const MethodInfo &m: methods) {
         if (m.name == name) {
             return &m;
         }
@@ -648,8 +1208,13 @@ ClassParser::MethodInfo *ClassParser::find_method(const std::string &name) {
     return nullptr;
 }
 
-ClassParser::MethodInfo *ClassParser::find_method(const std::string &name, const std::string &descriptor) {
-    for (MethodInfo &m: methods) {
+const ClassParser::MethodInfo *ClassParser::find_method(const std::string_view name,
+                                                        const std::string_view descriptor) const {
+    if (method_index.built) {
+        const auto it = method_index.by_signature.find({name, descriptor});
+        return it == method_index.by_signature.end() ? nullptr : &methods[it->second];
+    }
+    for (const MethodInfo &m: methods) {
         if (m.name == name && m.descriptor == descriptor) {
             return &m;
         }
@@ -657,36 +1222,181 @@ ClassParser::MethodInfo *ClassParser::find_method(const std::string &name, const
     return nullptr;
 }
 
-const std::vector<ClassParser::ConstantPoolInfo *> &ClassParser::get_constant_pool() const {
-    return constant_pool;
+const ClassParser::FieldInfo *ClassParser::find_field(const std::string_view name) const {
+    if (field_index.built) {
+        const auto it = field_index.by_name.find(name);
+        return it == field_index.by_name.end() ? nullptr : &fields[it->second];
+    }
+    for (const FieldInfo &f: fields) {
+        if (f.name == name) {
+            return &f;
+        }
+    }
+    return nullptr;
+}
+
+const ClassParser::FieldInfo *ClassParser::find_field(const std::string_view name,
+                                                      const std::string_view descriptor) const {
+    if (field_index.built) {
+        const auto it = field_index.by_signature.find({name, descriptor});
+        return it == field_index.by_signature.end() ? nullptr : &fields[it->second];
+    }
+    for (const FieldInfo &f: fields) {
+        if (f.name == name && f.descriptor == descriptor) {
+            return &f;
+        }
+    }
+    return nullptr;
 }
 
-const std::string &ClassParser::get_class_name() const {
-    return class_name;
+// Attribute kinds need no work here: parsing classifies the name of every attribute it keeps.
+void ClassParser::freeze() {
+    constant_pool.resolve_all();
+    if (!method_index.built) {
+        method_index.build(methods);
+    }
+    if (!field_index.built) {
+        field_index.build(fields);
+    }
+    member_reference_table();
 }
 
-const std::string &ClassParser::get_super_class_name() const {
-    return super_class_name;
+const ClassParser::ConstantPool &ClassParser::get_constant_pool() const {
+    return constant_pool;
+}
+
+const ClassParser::SpecializedAttribute &ClassParser::decode_attribute(
+    const CodeAttribute::AttributeInfo &attribute) const {
+    const SpecializedAttribute *decoded = attribute.specialized.load(std::memory_order_acquire);
+    if (decoded == nullptr) {
+        auto fresh = std::make_unique<const SpecializedAttribute>(
+            parse_specialized_attribute(attribute.name_index, attribute.bytes()));
+        // A losing thread keeps the winner's result and frees its own.
+        if (attribute.specialized.compare_exchange_strong(decoded, fresh.get(), std::memory_order_acq_rel,
+                                                          std::memory_order_acquire)) {
+            decoded = fresh.release();
+        }
+    }
+    return *decoded;
 }
 
 std::string ClassParser::get_utf8_string(const uint16_t index) const {
-    if (index == 0 || index >= constant_pool.size() ||
-        constant_pool[index] == nullptr ||
-        constant_pool[index]->tag != CONSTANT_Utf8) {
+    return std::string(get_utf8_view(index));
+}
+
+std::string_view ClassParser::get_utf8_view(const uint16_t index) const {
+    if (!constant_pool.is(index, CONSTANT_Utf8)) {
         throw std::runtime_error("Invalid Utf8 index in constant pool: " +
                                  std::to_string(index));
     }
-    return constant_pool[index]->s_val;
+    return constant_pool.utf8(index);
 }
 
 std::string ClassParser::get_class_name(const uint16_t index) const {
-    if (index == 0 || index >= constant_pool.size() ||
-        constant_pool[index] == nullptr ||
-        constant_pool[index]->tag != CONSTANT_Class) {
+    return std::string(get_class_name_view(index));
+}
+
+std::string_view ClassParser::get_class_name_view(const uint16_t index) const {
+    if (!constant_pool.is(index, CONSTANT_Class)) {
         throw std::runtime_error("Invalid Class index in constant pool: " +
                                  std::to_string(index));
     }
-    return get_utf8_string(constant_pool[index]->index1);
+    return get_utf8_view(constant_pool.index1(index));
+}
+
+struct ClassParser::MemberReferenceTable {
+    // One past the entry for each pool index, or 0 when the index holds no valid reference.
+    std::vector<uint16_t> entry_of;
+    std::vector<MemberReference> entries;
+};
+
+void ClassParser::MemberReferenceCache::clear() {
+    delete table.exchange(nullptr, std::memory_order_acq_rel);
+}
+
+ClassParser::MemberReference ClassParser::read_member_reference(const uint16_t index) const {
+    MemberReference reference;
+    reference.tag = constant_pool.tag(index);
+    uint16_t name_and_type = index;
+    switch (reference.tag) {
+        case CONSTANT_Fieldref:
+        case CONSTANT_Methodref:
+        case CONSTANT_InterfaceMethodref:
+            reference.owner = get_class_name_view(constant_pool.index1(index));
+            name_and_type = constant_pool.index2(index);
+            break;
+        case CONSTANT_NameAndType:
+            break;
+        default:
+            throw std::runtime_error("Invalid member reference in constant pool: " + std::to_string(index));
+    }
+    if (!constant_pool.is(name_and_type, CONSTANT_NameAndType)) {
+        throw std::runtime_error("Invalid NameAndType index in constant pool: " + std::to_string(name_and_type));
+    }
+    const uint16_t name_index = constant_pool.index1(name_and_type);
+    const uint16_t descriptor_index = constant_pool.index2(name_and_type);
+    reference.name = get_utf8_view(name_index);
+    reference.descriptor = get_utf8_view(descriptor_index);
+
+    if (symbols) {
+        // Reuses the symbols interned while parsing members; pool_symbols is not written after that.
+        const auto intern = [&](const uint16_t utf8_index, const std::string_view text) {
+            const SymbolTable::Symbol known = utf8_index < pool_symbols.size()
+                                                  ? pool_symbols[utf8_index]
+                                                  : SymbolTable::NO_SYMBOL;
+            return known != SymbolTable::NO_SYMBOL ? known : symbols->intern(text);
+        };
+        if (!reference.owner.empty()) {
+            reference.owner_symbol = intern(constant_pool.index1(constant_pool.index1(index)), reference.owner);
+        }
+        reference.name_symbol = intern(name_index, reference.name);
+        reference.descriptor_symbol = intern(descriptor_index, reference.descriptor);
+    }
+    return reference;
+}
+
+// The first lookup resolves every reference in one pass; later ones are two array reads.
+const ClassParser::MemberReferenceTable &ClassParser::member_reference_table() const {
+    const MemberReferenceTable *table = member_references.table.load(std::memory_order_acquire);
+    if (table != nullptr) {
+        return *table;
+    }
+    auto fresh = std::make_unique<MemberReferenceTable>();
+    fresh->entry_of.assign(constant_pool.size(), 0);
+    for (size_t i = 1; i < constant_pool.size(); ++i) {
+        switch (constant_pool.tag(static_cast<uint16_t>(i))) {
+            case CONSTANT_Fieldref:
+            case CONSTANT_Methodref:
+            case CONSTANT_InterfaceMethodref:
+            case CONSTANT_NameAndType:
+                break;
+            default:
+                continue;
+        }
+        // Malformed entries stay unresolved so that only their own lookups fail.
+        try {
+            fresh->entries.push_back(read_member_reference(static_cast<uint16_t>(i)));
+            fresh->entry_of[i] = static_cast<uint16_t>(fresh->entries.size());
+        } catch (const std::runtime_error &) {
+        }
+    }
+    // A losing thread keeps the winner's table and frees its own.
+    if (member_references.table.compare_exchange_strong(table, fresh.get(), std::memory_order_acq_rel,
+                                                        std::memory_order_acquire)) {
+        table = fresh.release();
+    }
+    return *table;
+}
+
+const ClassParser::MemberReference &ClassParser::resolve_member_reference(const uint16_t index) const {
+    const MemberReferenceTable &table = member_reference_table();
+    const uint16_t entry = index < table.entry_of.size() ? table.entry_of[index] : 0;
+    if (entry == 0) {
+        // Resolving by hand reports why the entry is invalid.
+        read_member_reference(index);
+        throw std::runtime_error("Invalid member reference in constant pool: " + std::to_string(index));
+    }
+    return table.entries[entry - 1];
 }
 
 std::string ClassParser::get_super_class_name(const uint16_t index) const {
@@ -705,11 +1415,11 @@ std::string ClassParser::get_field_descriptor(const uint16_t index) const {
 }
 
 std::string ClassParser::get_method_name(const MethodInfo &method) const {
-    return method.name;
+    return std::string(method.name);
 }
 
 std::string ClassParser::get_field_name(const FieldInfo &field) const {
-    return field.name;
+    return std::string(field.name);
 }
 
 std::string ClassParser::get_access_flags_string(const uint16_t flags, const bool is_method) const {
@@ -735,110 +1445,112 @@ std::string ClassParser::to_string() const {
     return oss.str();
 }
 
-void ClassParser::parse_source_file_attribute(SourceFileAttribute &attr, const std::vector<uint8_t> &data) {
+void ClassParser::parse_source_file_attribute(SourceFileAttribute &attr, const std::span<const uint8_t> data) const {
     if (data.size() >= 2) {
         attr.sourcefile_index = (static_cast<uint16_t>(data[0]) << 8) | data[1];
     }
 }
 
 ClassParser::SpecializedAttribute ClassParser::parse_specialized_attribute(
-    const std::string &name, const std::vector<uint8_t> &data) {
+    const uint16_t name_index, const std::span<const uint8_t> data) const {
     SpecializedAttribute attr;
-    attr.name = name;
-    attr.raw_data = data;
-
-    if (name == "SourceFile") {
-        attr.type = SpecializedAttribute::SOURCE_FILE;
-        parse_source_file_attribute(attr.source_file, data);
-    } else if (name == "LineNumberTable") {
-        attr.type = SpecializedAttribute::LINE_NUMBER_TABLE;
-        parse_line_number_table_attribute(attr.line_number_table, data);
-    } else if (name == "LocalVariableTable") {
-        attr.type = SpecializedAttribute::LOCAL_VARIABLE_TABLE;
-        parse_local_variable_table_attribute(attr.local_variable_table, data);
-    } else if (name == "Exceptions") {
-        attr.type = SpecializedAttribute::EXCEPTIONS;
-        parse_exceptions_attribute(attr.exceptions, data);
-    } else if (name == "ConstantValue") {
-        attr.type = SpecializedAttribute::CONSTANT_VALUE;
-        parse_constant_value_attribute(attr.constant_value, data);
-    } else if (name == "BootstrapMethods") {
-        attr.type = SpecializedAttribute::BOOTSTRAP_METHODS;
-        parse_bootstrap_methods_attribute(attr.bootstrap_methods, data);
-    } else if (name == "Signature") {
-        attr.type = SpecializedAttribute::SIGNATURE;
-        parse_signature_attribute(attr.signature, data);
-    } else if (name == "Deprecated") {
-        attr.type = SpecializedAttribute::DEPRECATED;
-        parse_deprecated_attribute(attr.deprecated, data);
-    } else if (name == "Synthetic") {
-        attr.type = SpecializedAttribute::SYNTHETIC;
-        parse_synthetic_attribute(attr.synthetic, data);
-    } else if (name == "InnerClasses") {
-        attr.type = SpecializedAttribute::INNER_CLASSES;
-        parse_inner_classes_attribute(attr.inner_classes, data);
-    } else if (name == "EnclosingMethod") {
-        attr.type = SpecializedAttribute::ENCLOSING_METHOD;
-        parse_enclosing_method_attribute(attr.enclosing_method, data);
-    } else if (name == "SourceDebugExtension") {
-        attr.type = SpecializedAttribute::SOURCE_DEBUG_EXTENSION;
-        parse_source_debug_extension_attribute(attr.source_debug_extension, data);
-    } else if (name == "LocalVariableTypeTable") {
-        attr.type = SpecializedAttribute::LOCAL_VARIABLE_TYPE_TABLE;
-        parse_local_variable_type_table_attribute(attr.local_variable_type_table, data);
-    } else if (name == "MethodParameters") {
-        attr.type = SpecializedAttribute::METHOD_PARAMETERS;
-        parse_method_parameters_attribute(attr.method_parameters, data);
-    } else if (name == "RuntimeVisibleAnnotations") {
-        attr.type = SpecializedAttribute::RUNTIME_VISIBLE_ANNOTATIONS;
-        parse_runtime_visible_annotations_attribute(attr.runtime_visible_annotations, data);
-    } else if (name == "RuntimeInvisibleAnnotations") {
-        attr.type = SpecializedAttribute::RUNTIME_INVISIBLE_ANNOTATIONS;
-        parse_runtime_invisible_annotations_attribute(attr.runtime_invisible_annotations, data);
-    } else if (name == "RuntimeVisibleParameterAnnotations") {
-        attr.type = SpecializedAttribute::RUNTIME_VISIBLE_PARAMETER_ANNOTATIONS;
-        parse_runtime_visible_parameter_annotations_attribute(attr.runtime_visible_parameter_annotations, data);
-    } else if (name == "RuntimeInvisibleParameterAnnotations") {
-        attr.type = SpecializedAttribute::RUNTIME_INVISIBLE_PARAMETER_ANNOTATIONS;
-        parse_runtime_invisible_parameter_annotations_attribute(attr.runtime_invisible_parameter_annotations, data);
-    } else if (name == "RuntimeVisibleTypeAnnotations") {
-        attr.type = SpecializedAttribute::RUNTIME_VISIBLE_TYPE_ANNOTATIONS;
-        parse_runtime_visible_type_annotations_attribute(attr.runtime_visible_type_annotations, data);
-    } else if (name == "RuntimeInvisibleTypeAnnotations") {
-        attr.type = SpecializedAttribute::RUNTIME_INVISIBLE_TYPE_ANNOTATIONS;
-        parse_runtime_invisible_type_annotations_attribute(attr.runtime_invisible_type_annotations, data);
-    } else if (name == "AnnotationDefault") {
-        attr.type = SpecializedAttribute::ANNOTATION_DEFAULT;
-        parse_annotation_default_attribute(attr.annotation_default, data);
-    } else if (name == "Module") {
-        attr.type = SpecializedAttribute::MODULE;
-        parse_module_attribute(attr.module_attr, data);
-    } else if (name == "ModulePackages") {
-        attr.type = SpecializedAttribute::MODULE_PACKAGES;
-        parse_module_packages_attribute(attr.module_packages, data);
-    } else if (name == "ModuleMainClass") {
-        attr.type = SpecializedAttribute::MODULE_MAIN_CLASS;
-        parse_module_main_class_attribute(attr.module_main_class, data);
-    } else if (name == "NestHost") {
-        attr.type = SpecializedAttribute::NEST_HOST;
-        parse_nest_host_attribute(attr.nest_host, data);
-    } else if (name == "NestMembers") {
-        attr.type = SpecializedAttribute::NEST_MEMBERS;
-        parse_nest_members_attribute(attr.nest_members, data);
-    } else if (name == "Record") {
-        attr.type = SpecializedAttribute::RECORD;
-        parse_record_attribute(attr.record, data);
-    } else if (name == "PermittedSubclasses") {
-        attr.type = SpecializedAttribute::PERMITTED_SUBCLASSES;
-        parse_permitted_subclasses_attribute(attr.permitted_subclasses, data);
-    } else {
-        attr.type = SpecializedAttribute::UNKNOWN;
+    attr.name = get_utf8_view(name_index);
+    attr.length = static_cast<uint32_t>(data.size());
+    attr.type = attribute_kind(name_index);
+
+    switch (attr.type) {
+        case SpecializedAttribute::SOURCE_FILE:
+            parse_source_file_attribute(attr.value.emplace<SourceFileAttribute>(), data);
+            break;
+        case SpecializedAttribute::LINE_NUMBER_TABLE:
+            parse_line_number_table_attribute(attr.value.emplace<LineNumberTableAttribute>(), data);
+            break;
+        case SpecializedAttribute::LOCAL_VARIABLE_TABLE:
+            parse_local_variable_table_attribute(attr.value.emplace<LocalVariableTableAttribute>(), data);
+            break;
+        case SpecializedAttribute::EXCEPTIONS:
+            parse_exceptions_attribute(attr.value.emplace<ExceptionsAttribute>(), data);
+            break;
+        case SpecializedAttribute::CONSTANT_VALUE:
+            parse_constant_value_attribute(attr.value.emplace<ConstantValueAttribute>(), data);
+            break;
+        case SpecializedAttribute::BOOTSTRAP_METHODS:
+            parse_bootstrap_methods_attribute(attr.value.emplace<BootstrapMethodsAttribute>(), data);
+            break;
+        case SpecializedAttribute::SIGNATURE:
+            parse_signature_attribute(attr.value.emplace<SignatureAttribute>(), data);
+            break;
+        case SpecializedAttribute::DEPRECATED:
+            parse_deprecated_attribute(attr.value.emplace<DeprecatedAttribute>(), data);
+            break;
+        case SpecializedAttribute::SYNTHETIC:
+            parse_synthetic_attribute(attr.value.emplace<SyntheticAttribute>(), data);
+            break;
+        case SpecializedAttribute::INNER_CLASSES:
+            parse_inner_classes_attribute(attr.value.emplace<InnerClassesAttribute>(), data);
+            break;
+        case SpecializedAttribute::ENCLOSING_METHOD:
+            parse_enclosing_method_attribute(attr.value.emplace<EnclosingMethodAttribute>(), data);
+            break;
+        case SpecializedAttribute::SOURCE_DEBUG_EXTENSION:
+            parse_source_debug_extension_attribute(attr.value.emplace<SourceDebugExtensionAttribute>(), data);
+            break;
+        case SpecializedAttribute::LOCAL_VARIABLE_TYPE_TABLE:
+            parse_local_variable_type_table_attribute(attr.value.emplace<LocalVariableTypeTableAttribute>(), data);
+            break;
+        case SpecializedAttribute::METHOD_PARAMETERS:
+            parse_method_parameters_attribute(attr.value.emplace<MethodParametersAttribute>(), data);
+            break;
+        case SpecializedAttribute::RUNTIME_VISIBLE_ANNOTATIONS:
+            parse_runtime_visible_annotations_attribute(attr.value.emplace<RuntimeVisibleAnnotationsAttribute>(), data);
+            break;
+        case SpecializedAttribute::RUNTIME_INVISIBLE_ANNOTATIONS:
+            parse_runtime_invisible_annotations_attribute(attr.value.emplace<RuntimeInvisibleAnnotationsAttribute>(), data);
+            break;
+        case SpecializedAttribute::RUNTIME_VISIBLE_PARAMETER_ANNOTATIONS:
+            parse_runtime_visible_parameter_annotations_attribute(attr.value.emplace<RuntimeVisibleParameterAnnotationsAttribute>(), data);
+            break;
+        case SpecializedAttribute::RUNTIME_INVISIBLE_PARAMETER_ANNOTATIONS:
+            parse_runtime_invisible_parameter_annotations_attribute(attr.value.emplace<RuntimeInvisibleParameterAnnotationsAttribute>(), data);
+            break;
+        case SpecializedAttribute::RUNTIME_VISIBLE_TYPE_ANNOTATIONS:
+            parse_runtime_visible_type_annotations_attribute(attr.value.emplace<RuntimeVisibleTypeAnnotationsAttribute>(), data);
+            break;
+        case SpecializedAttribute::RUNTIME_INVISIBLE_TYPE_ANNOTATIONS:
+            parse_runtime_invisible_type_annotations_attribute(attr.value.emplace<RuntimeInvisibleTypeAnnotationsAttribute>(), data);
+            break;
+        case SpecializedAttribute::ANNOTATION_DEFAULT:
+            parse_annotation_default_attribute(attr.value.emplace<AnnotationDefaultAttribute>(), data);
+            break;
+        case SpecializedAttribute::MODULE:
+            parse_module_attribute(attr.value.emplace<ModuleAttribute>(), data);
+            break;
+        case SpecializedAttribute::MODULE_PACKAGES:
+            parse_module_packages_attribute(attr.value.emplace<ModulePackagesAttribute>(), data);
+            break;
+        case SpecializedAttribute::MODULE_MAIN_CLASS:
+            parse_module_main_class_attribute(attr.value.emplace<ModuleMainClassAttribute>(), data);
+            break;
+        case SpecializedAttribute::NEST_HOST:
+            parse_nest_host_attribute(attr.value.emplace<NestHostAttribute>(), data);
+            break;
+        case SpecializedAttribute::NEST_MEMBERS:
+            parse_nest_members_attribute(attr.value.emplace<NestMembersAttribute>(), data);
+            break;
+        case SpecializedAttribute::RECORD:
+            parse_record_attribute(attr.value.emplace<RecordAttribute>(), data);
+            break;
+        case SpecializedAttribute::PERMITTED_SUBCLASSES:
+            parse_permitted_subclasses_attribute(attr.value.emplace<PermittedSubclassesAttribute>(), data);
+            break;
+        default:
+            break;
     }
 
     return attr;
 }
 
-void ClassParser::parse_line_number_table_attribute(LineNumberTableAttribute &attr, const std::vector<uint8_t> &data) {
+void ClassParser::parse_line_number_table_attribute(LineNumberTableAttribute &attr, const std::span<const uint8_t> data) const {
     if (data.size() >= 2) {
         const uint16_t line_number_table_length = (static_cast<uint16_t>(data[0]) << 8) | data[1];
         attr.line_number_table.resize(line_number_table_length);
@@ -853,7 +1565,7 @@ void ClassParser::parse_line_number_table_attribute(LineNumberTableAttribute &at
 }
 
 void ClassParser::parse_local_variable_table_attribute(LocalVariableTableAttribute &attr,
-                                                       const std::vector<uint8_t> &data) {
+                                                       const std::span<const uint8_t> data) const {
     if (data.size() >= 2) {
         const uint16_t local_variable_table_length = (static_cast<uint16_t>(data[0]) << 8) | data[1];
         attr.local_variable_table.resize(local_variable_table_length);
@@ -871,7 +1583,7 @@ void ClassParser::parse_local_variable_table_attribute(LocalVariableTableAttribu
     }
 }
 
-void ClassParser::parse_exceptions_attribute(ExceptionsAttribute &attr, const std::vector<uint8_t> &data) {
+void ClassParser::parse_exceptions_attribute(ExceptionsAttribute &attr, const std::span<const uint8_t> data) const {
     if (data.size() >= 2) {
         const uint16_t number_of_exceptions = (static_cast<uint16_t>(data[0]) << 8) | data[1];
         attr.exception_index_table.resize(number_of_exceptions);
@@ -884,13 +1596,13 @@ void ClassParser::parse_exceptions_attribute(ExceptionsAttribute &attr, const st
     }
 }
 
-void ClassParser::parse_constant_value_attribute(ConstantValueAttribute &attr, const std::vector<uint8_t> &data) {
+void ClassParser::parse_constant_value_attribute(ConstantValueAttribute &attr, const std::span<const uint8_t> data) const {
     if (data.size() >= 2) {
         attr.constantvalue_index = (static_cast<uint16_t>(data[0]) << 8) | data[1];
     }
 }
 
-void ClassParser::parse_bootstrap_methods_attribute(BootstrapMethodsAttribute &attr, const std::vector<uint8_t> &data) {
+void ClassParser::parse_bootstrap_methods_attribute(BootstrapMethodsAttribute &attr, const std::span<const uint8_t> data) const {
     if (data.size() >= 2) {
         const uint16_t num_bootstrap_methods = (static_cast<uint16_t>(data[0]) << 8) | data[1];
         attr.bootstrap_methods.resize(num_bootstrap_methods);
@@ -912,19 +1624,19 @@ void ClassParser::parse_bootstrap_methods_attribute(BootstrapMethodsAttribute &a
     }
 }
 
-void ClassParser::parse_signature_attribute(SignatureAttribute &attr, const std::vector<uint8_t> &data) {
+void ClassParser::parse_signature_attribute(SignatureAttribute &attr, const std::span<const uint8_t> data) const {
     if (data.size() >= 2) {
         attr.signature_index = (static_cast<uint16_t>(data[0]) << 8) | data[1];
     }
 }
 
-void ClassParser::parse_deprecated_attribute(DeprecatedAttribute &attr, const std::vector<uint8_t> &data) {
+void ClassParser::parse_deprecated_attribute(DeprecatedAttribute &attr, const std::span<const uint8_t> data) const {
 }
 
-void ClassParser::parse_synthetic_attribute(SyntheticAttribute &attr, const std::vector<uint8_t> &data) {
+void ClassParser::parse_synthetic_attribute(SyntheticAttribute &attr, const std::span<const uint8_t> data) const {
 }
 
-void ClassParser::parse_inner_classes_attribute(InnerClassesAttribute &attr, const std::vector<uint8_t> &data) {
+void ClassParser::parse_inner_classes_attribute(InnerClassesAttribute &attr, const std::span<const uint8_t> data) const {
     if (data.size() >= 2) {
         const uint16_t number_of_classes = (static_cast<uint16_t>(data[0]) << 8) | data[1];
         attr.classes.resize(number_of_classes);
@@ -941,7 +1653,7 @@ void ClassParser::parse_inner_classes_attribute(InnerClassesAttribute &attr, con
     }
 }
 
-void ClassParser::parse_enclosing_method_attribute(EnclosingMethodAttribute &attr, const std::vector<uint8_t> &data) {
+void ClassParser::parse_enclosing_method_attribute(EnclosingMethodAttribute &attr, const std::span<const uint8_t> data) const {
     if (data.size() >= 4) {
         attr.class_index = (static_cast<uint16_t>(data[0]) << 8) | data[1];
         attr.method_index = (static_cast<uint16_t>(data[2]) << 8) | data[3];
@@ -949,12 +1661,12 @@ void ClassParser::parse_enclosing_method_attribute(EnclosingMethodAttribute &att
 }
 
 void ClassParser::parse_source_debug_extension_attribute(SourceDebugExtensionAttribute &attr,
-                                                         const std::vector<uint8_t> &data) {
-    attr.debug_extension = data;
+                                                         const std::span<const uint8_t> data) const {
+    attr.debug_extension.assign(data.begin(), data.end());
 }
 
 void ClassParser::parse_local_variable_type_table_attribute(LocalVariableTypeTableAttribute &attr,
-                                                            const std::vector<uint8_t> &data) {
+                                                            const std::span<const uint8_t> data) const {
     if (data.size() >= 2) {
         const uint16_t local_variable_type_table_length = (static_cast<uint16_t>(data[0]) << 8) | data[1];
         attr.local_variable_type_table.resize(local_variable_type_table_length);
@@ -974,7 +1686,7 @@ void ClassParser::parse_local_variable_type_table_attribute(LocalVariableTypeTab
     }
 }
 
-void ClassParser::parse_method_parameters_attribute(MethodParametersAttribute &attr, const std::vector<uint8_t> &data) {
+void ClassParser::parse_method_parameters_attribute(MethodParametersAttribute &attr, const std::span<const uint8_t> data) const {
     if (!data.empty()) {
         const uint8_t parameters_count = data[0];
         attr.parameters.resize(parameters_count);
@@ -989,23 +1701,23 @@ void ClassParser::parse_method_parameters_attribute(MethodParametersAttribute &a
 }
 
 void ClassParser::parse_runtime_visible_annotations_attribute(RuntimeVisibleAnnotationsAttribute &attr,
-                                                              const std::vector<uint8_t> &data) {
-    attr.annotations = data;
+                                                              const std::span<const uint8_t> data) const {
+    attr.annotations.assign(data.begin(), data.end());
     if (data.size() >= 2) {
         attr.num_annotations = (static_cast<uint16_t>(data[0]) << 8) | data[1];
     }
 }
 
 void ClassParser::parse_runtime_invisible_annotations_attribute(RuntimeInvisibleAnnotationsAttribute &attr,
-                                                                const std::vector<uint8_t> &data) {
-    attr.annotations = data;
+                                                                const std::span<const uint8_t> data) const {
+    attr.annotations.assign(data.begin(), data.end());
     if (data.size() >= 2) {
         attr.num_annotations = (static_cast<uint16_t>(data[0]) << 8) | data[1];
     }
 }
 
 void ClassParser::parse_runtime_visible_parameter_annotations_attribute(
-    RuntimeVisibleParameterAnnotationsAttribute &attr, const std::vector<uint8_t> &data) {
+    RuntimeVisibleParameterAnnotationsAttribute &attr, const std::span<const uint8_t> data) const {
     if (!data.empty()) {
         attr.num_parameters = data[0];
         attr.parameter_annotations.resize(attr.num_parameters);
@@ -1022,7 +1734,7 @@ void ClassParser::parse_runtime_visible_parameter_annotations_attribute(
 }
 
 void ClassParser::parse_runtime_invisible_parameter_annotations_attribute(
-    RuntimeInvisibleParameterAnnotationsAttribute &attr, const std::vector<uint8_t> &data) {
+    RuntimeInvisibleParameterAnnotationsAttribute &attr, const std::span<const uint8_t> data) const {
     if (!data.empty()) {
         attr.num_parameters = data[0];
         attr.parameter_annotations.resize(attr.num_parameters);
@@ -1039,27 +1751,27 @@ void ClassParser::parse_runtime_invisible_parameter_annotations_attribute(
 }
 
 void ClassParser::parse_runtime_visible_type_annotations_attribute(RuntimeVisibleTypeAnnotationsAttribute &attr,
-                                                                   const std::vector<uint8_t> &data) {
-    attr.type_annotations = data;
+                                                                   const std::span<const uint8_t> data) const {
+    attr.type_annotations.assign(data.begin(), data.end());
     if (data.size() >= 2) {
         attr.num_annotations = (static_cast<uint16_t>(data[0]) << 8) | data[1];
     }
 }
 
 void ClassParser::parse_runtime_invisible_type_annotations_attribute(RuntimeInvisibleTypeAnnotationsAttribute &attr,
-                                                                     const std::vector<uint8_t> &data) {
-    attr.type_annotations = data;
+                                                                     const std::span<const uint8_t> data) const {
+    attr.type_annotations.assign(data.begin(), data.end());
     if (data.size() >= 2) {
         attr.num_annotations = (static_cast<uint16_t>(data[0]) << 8) | data[1];
     }
 }
 
 void ClassParser::parse_annotation_default_attribute(AnnotationDefaultAttribute &attr,
-                                                     const std::vector<uint8_t> &data) {
-    attr.default_value = data;
+                                                     const std::span<const uint8_t> data) const {
+    attr.default_value.assign(data.begin(), data.end());
 }
 
-void ClassParser::parse_module_attribute(ModuleAttribute &attr, const std::vector<uint8_t> &data) {
+void ClassParser::parse_module_attribute(ModuleAttribute &attr, const std::span<const uint8_t> data) const {
     size_t offset = 0;
     auto read_u2 = [&](uint16_t &out) {
         if (offset + 2 > data.size()) return false;
@@ -1129,7 +1841,7 @@ void ClassParser::parse_module_attribute(ModuleAttribute &attr, const std::vecto
     }
 }
 
-void ClassParser::parse_module_packages_attribute(ModulePackagesAttribute &attr, const std::vector<uint8_t> &data) {
+void ClassParser::parse_module_packages_attribute(ModulePackagesAttribute &attr, const std::span<const uint8_t> data) const {
     if (data.size() >= 2) {
         const uint16_t package_count = (static_cast<uint16_t>(data[0]) << 8) | data[1];
         attr.package_index.resize(package_count);
@@ -1142,19 +1854,19 @@ void ClassParser::parse_module_packages_attribute(ModulePackagesAttribute &attr,
     }
 }
 
-void ClassParser::parse_module_main_class_attribute(ModuleMainClassAttribute &attr, const std::vector<uint8_t> &data) {
+void ClassParser::parse_module_main_class_attribute(ModuleMainClassAttribute &attr, const std::span<const uint8_t> data) const {
     if (data.size() >= 2) {
         attr.main_class_index = (static_cast<uint16_t>(data[0]) << 8) | data[1];
     }
 }
 
-void ClassParser::parse_nest_host_attribute(NestHostAttribute &attr, const std::vector<uint8_t> &data) {
+void ClassParser::parse_nest_host_attribute(NestHostAttribute &attr, const std::span<const uint8_t> data) const {
     if (data.size() >= 2) {
         attr.host_class_index = (static_cast<uint16_t>(data[0]) << 8) | data[1];
     }
 }
 
-void ClassParser::parse_nest_members_attribute(NestMembersAttribute &attr, const std::vector<uint8_t> &data) {
+void ClassParser::parse_nest_members_attribute(NestMembersAttribute &attr, const std::span<const uint8_t> data) const {
     if (data.size() >= 2) {
         const uint16_t number_of_classes = (static_cast<uint16_t>(data[0]) << 8) | data[1];
         attr.classes.resize(number_of_classes);
@@ -1167,7 +1879,7 @@ void ClassParser::parse_nest_members_attribute(NestMembersAttribute &attr, const
     }
 }
 
-void ClassParser::parse_record_attribute(RecordAttribute &attr, const std::vector<uint8_t> &data) {
+void ClassParser::parse_record_attribute(RecordAttribute &attr, const std::span<const uint8_t> data) const {
     size_t offset = 0;
     auto read_u2 = [&](uint16_t &out) {
         if (offset + 2 > data.size()) return false;
@@ -1193,10 +1905,10 @@ void ClassParser::parse_record_attribute(RecordAttribute &attr, const std::vecto
             offset += 6;
             if (offset + length > data.size()) return;
             CodeAttribute::AttributeInfo ai;
-            ai.name = (name_index < constant_pool.size() && constant_pool[name_index] && constant_pool[name_index]->tag
-                       == CONSTANT_Utf8)
-                          ? constant_pool[name_index]->s_val
-                          : std::string("unknown");
+            ai.name_index = name_index;
+            ai.name = constant_pool.is(name_index, CONSTANT_Utf8)
+                          ? constant_pool.utf8(name_index)
+                          : std::string_view("unknown");
             ai.info.assign(data.begin() + offset, data.begin() + offset + length);
             offset += length;
             attr.components[i].attributes.push_back(std::move(ai));
@@ -1205,7 +1917,7 @@ void ClassParser::parse_record_attribute(RecordAttribute &attr, const std::vecto
 }
 
 void ClassParser::parse_permitted_subclasses_attribute(PermittedSubclassesAttribute &attr,
-                                                       const std::vector<uint8_t> &data) {
+                                                       const std::span<const uint8_t> data) const {
     if (data.size() >= 2) {
         const uint16_t number_of_classes = (static_cast<uint16_t>(data[0]) << 8) | data[1];
         attr.classes.resize(number_of_classes);
@@ -1228,13 +1940,13 @@ void ClassParser::dump() const {
 
     std::cout << "Interfaces (" << interfaces.size() << "):" << std::endl;
     for (const unsigned short interface: interfaces) {
-        std::cout << "  #" << interface << " (" << get_utf8_string(interface) << ")" << std::endl;
+        std::cout << "  #" << interface << " (" << get_class_name(interface) << ")" << std::endl;
     }
 
     std::cout << "Constant pool (" << constant_pool.size() << " entries):" << std::endl;
     for (uint16_t i = 1; i < constant_pool.size(); i++) {
-        if (constant_pool[i]) {
-            std::cout << "  #" << i << " = " << constant_pool[i]->to_string() << std::endl;
+        if (constant_pool.tag(i) != 0) {
+            std::cout << "  #" << i << " = " << constant_pool[i].to_string() << std::endl;
         }
     }
 
@@ -1250,6 +1962,6 @@ void ClassParser::dump() const {
 
     std::cout << "Attributes (" << class_attributes.size() << "):" << std::endl;
     for (const auto &attr: class_attributes) {
-        std::cout << "  " << attr.to_string() << std::endl;
+        std::cout << "  " << decode_attribute(attr).to_string() << std::endl;
     }
 }
@@ -1,13 +1,27 @@
 #pragma once
 
 #include <string>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
+#include <atomic>
 #include <memory>
+#include <memory_resource>
+#include <optional>
+#include <span>
+#include <variant>
+
+#include "mapped_file.h"
+#include "symbol_table.h"
 
 class VirtualMachine;
+class ClassVisitor;
+class ControlFlowGraph;
 
 class ClassParser {
 public:
+    typedef std::pmr::polymorphic_allocator<> Allocator;
+
     enum {
         CONSTANT_Utf8 = 1,
         CONSTANT_Integer = 3,
@@ -29,8 +43,8 @@ public:
     };
 
     struct ConstantPoolInfo {
-        uint8_t tag;
-        std::string s_val;
+        uint8_t tag = 0;
+        std::string_view s_val;
         uint32_t i_val = 0;
         uint64_t l_val = 0;
         uint16_t index1 = 0;
@@ -40,6 +54,56 @@ public:
         std::string to_string() const;
     };
 
+    // Entries live in two parallel arrays indexed by pool slot: a tag byte and a 64-bit slot word.
+    // References are stored as (index1 << 16 | index2), MethodHandle as (kind << 16 | index2),
+    // numeric constants as their raw bits and Utf8 as (offset << 32 | flags | byte length).
+    // A Utf8 offset points into text, or into the class buffer when UTF8_SOURCE/UTF8_PENDING is set.
+    class ConstantPool {
+    public:
+        explicit ConstantPool(const Allocator &allocator = {}) : tags(allocator), slots(allocator), text(allocator) {}
+
+        size_t size() const { return tags.size(); }
+        bool empty() const { return tags.empty(); }
+
+        uint8_t tag(const uint16_t index) const { return index < tags.size() ? tags[index] : 0; }
+        bool is(const uint16_t index, const uint8_t expected_tag) const {
+            return index != 0 && tag(index) == expected_tag;
+        }
+
+        std::string_view utf8(const uint16_t index) const {
+            const uint64_t slot = slots[index];
+            if (slot & UTF8_PENDING) {
+                return resolve_utf8(index);
+            }
+            const char *base = slot & UTF8_SOURCE ? reinterpret_cast<const char *>(source) : text.data();
+            return {base + (slot >> 32), static_cast<size_t>(slot & UTF8_LENGTH_MASK)};
+        }
+        uint32_t int_bits(const uint16_t index) const { return static_cast<uint32_t>(slots[index]); }
+        uint64_t long_bits(const uint16_t index) const { return slots[index]; }
+        uint16_t index1(const uint16_t index) const { return static_cast<uint16_t>(slots[index] >> 16); }
+        uint16_t index2(const uint16_t index) const { return static_cast<uint16_t>(slots[index]); }
+        uint8_t reference_kind(const uint16_t index) const { return static_cast<uint8_t>(slots[index] >> 16); }
+
+        ConstantPoolInfo operator[](uint16_t index) const;
+
+    private:
+        friend class ClassParser;
+
+        static constexpr uint64_t UTF8_LENGTH_MASK = 0xFFFF;
+        static constexpr uint64_t UTF8_PENDING = 0x10000;
+        static constexpr uint64_t UTF8_SOURCE = 0x20000;
+
+        std::pmr::vector<uint8_t> tags;
+        mutable std::pmr::vector<uint64_t> slots;
+        mutable std::pmr::vector<char> text;
+        const uint8_t *source = nullptr;
+        size_t pending_bytes = 0;
+
+        void reset(uint16_t count, const uint8_t *class_data);
+        std::string_view resolve_utf8(uint16_t index) const;
+        void resolve_all() const;
+    };
+
     struct ExceptionTableEntry {
         uint16_t start_pc;
         uint16_t end_pc;
@@ -49,19 +113,68 @@ public:
         std::string to_string() const;
     };
 
+    struct SpecializedAttribute;
+
+    // Parse-time structs are allocator-aware, so containers of them draw from the parser's resource.
     struct CodeAttribute {
-        uint16_t max_stack;
-        uint16_t max_locals;
-        std::vector<uint8_t> code;
-        std::vector<ExceptionTableEntry> exception_table;
-        struct AttributeInfo {
-            std::string name;
-            std::vector<uint8_t> info;
+        typedef Allocator allocator_type;
 
+        uint16_t max_stack = 0;
+        uint16_t max_locals = 0;
+        std::pmr::vector<uint8_t> code;
+        std::span<const uint8_t> code_view;
+        std::pmr::vector<ExceptionTableEntry> exception_table;
+        struct AttributeInfo {
+            typedef Allocator allocator_type;
+
+            uint16_t name_index = 0;
+            std::string_view name;
+            std::pmr::vector<uint8_t> info;
+            std::span<const uint8_t> view;
+
+            // Owned; published once by ClassParser::decode_attribute() with a compare-exchange so
+            // frozen parsers decode from any thread. Copies start undecoded, moves take the result.
+            mutable std::atomic<const SpecializedAttribute *> specialized{nullptr};
+
+            AttributeInfo() = default;
+            explicit AttributeInfo(const allocator_type &allocator) : info(allocator) {}
+            AttributeInfo(const AttributeInfo &other, const allocator_type &allocator)
+                : name_index(other.name_index), name(other.name), info(other.info, allocator), view(other.view) {}
+            AttributeInfo(AttributeInfo &&other, const allocator_type &allocator)
+                : name_index(other.name_index), name(other.name), info(std::move(other.info), allocator),
+                  view(other.view), specialized(other.specialized.exchange(nullptr)) {}
+            AttributeInfo(const AttributeInfo &other)
+                : name_index(other.name_index), name(other.name), info(other.info), view(other.view) {}
+            AttributeInfo(AttributeInfo &&other) noexcept
+                : name_index(other.name_index), name(other.name), info(std::move(other.info)), view(other.view),
+                  specialized(other.specialized.exchange(nullptr)) {}
+            AttributeInfo &operator=(const AttributeInfo &other);
+            AttributeInfo &operator=(AttributeInfo &&other) noexcept;
+            ~AttributeInfo();
+
+            std::span<const uint8_t> bytes() const { return info.empty() ? view : std::span<const uint8_t>(info); }
             std::string to_string() const;
         };
-        std::vector<AttributeInfo> attributes;
+        std::pmr::vector<AttributeInfo> attributes;
 
+        CodeAttribute() = default;
+        explicit CodeAttribute(const allocator_type &allocator)
+            : code(allocator), exception_table(allocator), attributes(allocator) {}
+        CodeAttribute(const CodeAttribute &other, const allocator_type &allocator)
+            : max_stack(other.max_stack), max_locals(other.max_locals), code(other.code, allocator),
+              code_view(other.code_view), exception_table(other.exception_table, allocator),
+              attributes(other.attributes, allocator) {}
+        CodeAttribute(CodeAttribute &&other, const allocator_type &allocator)
+            : max_stack(other.max_stack), max_locals(other.max_locals), code(std::move(other.code), allocator),
+              code_view(other.code_view), exception_table(std::move(other.exception_table), allocator),
+              attributes(std::move(other.attributes), allocator) {}
+        CodeAttribute(const CodeAttribute &) = default;
+        CodeAttribute(CodeAttribute &&) noexcept = default;
+        CodeAttribute &operator=(const CodeAttribute &) = default;
+        CodeAttribute &operator=(CodeAttribute &&) noexcept = default;
+
+        std::span<const uint8_t> bytecode() const { return code.empty() ? code_view : std::span<const uint8_t>(code); }
+        void clear();
         std::string to_string() const;
     };
 
@@ -347,69 +460,141 @@ public:
             NEST_HOST,
             NEST_MEMBERS,
             RECORD,
-            PERMITTED_SUBCLASSES
+            PERMITTED_SUBCLASSES,
+            CODE,
+            STACK_MAP_TABLE
         };
+        typedef std::variant<std::monostate,
+                             SourceFileAttribute,
+                             LineNumberTableAttribute,
+                             LocalVariableTableAttribute,
+                             ExceptionsAttribute,
+                             ConstantValueAttribute,
+                             BootstrapMethodsAttribute,
+                             SignatureAttribute,
+                             DeprecatedAttribute,
+                             SyntheticAttribute,
+                             InnerClassesAttribute,
+                             EnclosingMethodAttribute,
+                             SourceDebugExtensionAttribute,
+                             LocalVariableTypeTableAttribute,
+                             MethodParametersAttribute,
+                             RuntimeVisibleAnnotationsAttribute,
+                             RuntimeInvisibleAnnotationsAttribute,
+                             RuntimeVisibleParameterAnnotationsAttribute,
+                             RuntimeInvisibleParameterAnnotationsAttribute,
+                             RuntimeVisibleTypeAnnotationsAttribute,
+                             RuntimeInvisibleTypeAnnotationsAttribute,
+                             AnnotationDefaultAttribute,
+                             ModuleAttribute,
+                             ModulePackagesAttribute,
+                             ModuleMainClassAttribute,
+                             NestHostAttribute,
+                             NestMembersAttribute,
+                             RecordAttribute,
+                             PermittedSubclassesAttribute> Value;
+
         Type type = UNKNOWN;
-        std::string name;
-        std::vector<uint8_t> raw_data;
-
-        SourceFileAttribute source_file;
-        LineNumberTableAttribute line_number_table;
-        LocalVariableTableAttribute local_variable_table;
-        ExceptionsAttribute exceptions;
-        ConstantValueAttribute constant_value;
-        BootstrapMethodsAttribute bootstrap_methods;
-        SignatureAttribute signature;
-        DeprecatedAttribute deprecated;
-        SyntheticAttribute synthetic;
-        InnerClassesAttribute inner_classes;
-        EnclosingMethodAttribute enclosing_method;
-        SourceDebugExtensionAttribute source_debug_extension;
-        LocalVariableTypeTableAttribute local_variable_type_table;
-        MethodParametersAttribute method_parameters;
-        RuntimeVisibleAnnotationsAttribute runtime_visible_annotations;
-        RuntimeInvisibleAnnotationsAttribute runtime_invisible_annotations;
-        RuntimeVisibleParameterAnnotationsAttribute runtime_visible_parameter_annotations;
-        RuntimeInvisibleParameterAnnotationsAttribute runtime_invisible_parameter_annotations;
-        RuntimeVisibleTypeAnnotationsAttribute runtime_visible_type_annotations;
-        RuntimeInvisibleTypeAnnotationsAttribute runtime_invisible_type_annotations;
-        AnnotationDefaultAttribute annotation_default;
-        ModuleAttribute module_attr;
-        ModulePackagesAttribute module_packages;
-        ModuleMainClassAttribute module_main_class;
-        NestHostAttribute nest_host;
-        NestMembersAttribute nest_members;
-        RecordAttribute record;
-        PermittedSubclassesAttribute permitted_subclasses;
+        std::string_view name;
+        uint32_t length = 0;
+        Value value;
 
+        template<typename T>
+        const T *get() const { return std::get_if<T>(&value); }
         std::string to_string() const;
     };
 
+    // code_attribute is held by value and draws on the same resource as attributes.
     struct MethodInfo {
-        uint16_t access_flags;
-        uint16_t name_index;
-        uint16_t descriptor_index;
-        uint16_t attributes_count;
-        CodeAttribute* code_attribute = nullptr;
-        std::string name;
-        std::string descriptor;
-        std::vector<CodeAttribute::AttributeInfo> attributes;
+        typedef Allocator allocator_type;
+
+        uint16_t access_flags = 0;
+        uint16_t name_index = 0;
+        uint16_t descriptor_index = 0;
+        uint16_t attributes_count = 0;
+        std::optional<CodeAttribute> code_attribute;
+        std::string_view name;
+        std::string_view descriptor;
+        SymbolTable::Symbol name_symbol = SymbolTable::NO_SYMBOL;
+        SymbolTable::Symbol descriptor_symbol = SymbolTable::NO_SYMBOL;
+        std::pmr::vector<CodeAttribute::AttributeInfo> attributes;
+
+        // Owned and built on first use, published the same way as AttributeInfo::specialized.
+        // Copies start without a graph, moves take it.
+        mutable std::atomic<const ControlFlowGraph *> control_flow_graph{nullptr};
+
+        MethodInfo() = default;
+        explicit MethodInfo(const allocator_type &allocator) : attributes(allocator) {}
+        MethodInfo(const MethodInfo &other, const allocator_type &allocator);
+        MethodInfo(MethodInfo &&other, const allocator_type &allocator);
+        MethodInfo(const MethodInfo &other);
+        MethodInfo(MethodInfo &&other) noexcept;
+        MethodInfo &operator=(const MethodInfo &other);
+        MethodInfo &operator=(MethodInfo &&other) noexcept;
+        ~MethodInfo();
 
+        CodeAttribute *new_code_attribute();
+        void reset_code_attribute();
+        // Throws for methods without code. The graph reflects the code as it was when first built.
+        const ControlFlowGraph &get_control_flow_graph() const;
         std::string to_string() const;
-        ~MethodInfo();
     };
 
-    struct FieldInfo {
-        uint16_t access_flags;
-        uint16_t name_index;
-        uint16_t descriptor_index;
-        uint16_t attributes_count;
-        std::string name;
-        std::string descriptor;
-        std::vector<CodeAttribute::AttributeInfo> attributes;
+    struct ClassSummary {
+        uint16_t minor_version = 0;
+        uint16_t major_version = 0;
+        uint16_t access_flags = 0;
+        std::string class_name;
+        std::string super_class_name;
+        std::vector<std::string> interfaces;
 
         std::string to_string() const;
     };
+
+    struct FieldInfo {
+        typedef Allocator allocator_type;
+
+        uint16_t access_flags = 0;
+        uint16_t name_index = 0;
+        uint16_t descriptor_index = 0;
+        uint16_t attributes_count = 0;
+        std::string_view name;
+        std::string_view descriptor;
+        SymbolTable::Symbol name_symbol = SymbolTable::NO_SYMBOL;
+        SymbolTable::Symbol descriptor_symbol = SymbolTable::NO_SYMBOL;
+        std::pmr::vector<CodeAttribute::AttributeInfo> attributes;
+
+        FieldInfo() = default;
+        explicit FieldInfo(const allocator_type &allocator) : attributes(allocator) {}
+        FieldInfo(const FieldInfo &other, const allocator_type &allocator)
+            : access_flags(other.access_flags), name_index(other.name_index),
+              descriptor_index(other.descriptor_index), attributes_count(other.attributes_count), name(other.name),
+              descriptor(other.descriptor), name_symbol(other.name_symbol),
+              descriptor_symbol(other.descriptor_symbol), attributes(other.attributes, allocator) {}
+        FieldInfo(FieldInfo &&other, const allocator_type &allocator)
+            : access_flags(other.access_flags), name_index(other.name_index),
+              descriptor_index(other.descriptor_index), attributes_count(other.attributes_count), name(other.name),
+              descriptor(other.descriptor), name_symbol(other.name_symbol),
+              descriptor_symbol(other.descriptor_symbol), attributes(std::move(other.attributes), allocator) {}
+        FieldInfo(const FieldInfo &) = default;
+        FieldInfo(FieldInfo &&) noexcept = default;
+        FieldInfo &operator=(const FieldInfo &) = default;
+        FieldInfo &operator=(FieldInfo &&) noexcept = default;
+
+        std::string to_string() const;
+    };
+    // A Fieldref, Methodref or InterfaceMethodref resolved to its owner class, name and descriptor.
+    // NameAndType entries resolve with an empty owner. Symbols are set when a symbol table is attached.
+    struct MemberReference {
+        uint8_t tag = 0;
+        std::string_view owner;
+        std::string_view name;
+        std::string_view descriptor;
+        SymbolTable::Symbol owner_symbol = SymbolTable::NO_SYMBOL;
+        SymbolTable::Symbol name_symbol = SymbolTable::NO_SYMBOL;
+        SymbolTable::Symbol descriptor_symbol = SymbolTable::NO_SYMBOL;
+    };
+
     // Constants for access flags
     static constexpr uint16_t ACC_PUBLIC = 0x0001;
     static constexpr uint16_t ACC_PRIVATE = 0x0002;
@@ -428,39 +613,103 @@ public:
     static constexpr uint16_t ACC_ENUM = 0x4000;
     static constexpr uint16_t ACC_MANDATED = 0x8000;
 
-    ClassParser(const std::string &filename);
+    typedef uint32_t ParseOptions;
+    static constexpr ParseOptions PARSE_DEFAULT = 0x0000;
+    static constexpr ParseOptions PARSE_LAZY_UTF8 = 0x0001;
+    static constexpr ParseOptions PARSE_BORROW_ATTRIBUTES = 0x0002;
+    static constexpr ParseOptions PARSE_SKIP_FIELDS = 0x0004;
+    static constexpr ParseOptions PARSE_SKIP_METHODS = 0x0008;
+    static constexpr ParseOptions PARSE_SKIP_CODE = 0x0010;
+    static constexpr ParseOptions PARSE_SKIP_DEBUG = 0x0020;
+    static constexpr ParseOptions PARSE_SKIP_FRAMES = 0x0040;
+    static constexpr ParseOptions PARSE_SKIP_ANNOTATIONS = 0x0080;
+
+    enum LoadMode {
+        LOAD_STREAM,
+        LOAD_MMAP,
+    };
+
+    explicit ClassParser(std::pmr::memory_resource *resource = std::pmr::get_default_resource());
+    ClassParser(const std::string &filename, LoadMode mode = LOAD_STREAM,
+                std::pmr::memory_resource *resource = std::pmr::get_default_resource());
+    explicit ClassParser(std::span<const uint8_t> data,
+                         std::pmr::memory_resource *resource = std::pmr::get_default_resource());
+    explicit ClassParser(std::vector<uint8_t> &&data,
+                         std::pmr::memory_resource *resource = std::pmr::get_default_resource());
     ~ClassParser();
 
-    void parse();
+    // Moving keeps every view valid: the class bytes, pool text and containers all change owner
+    // without moving in memory. Assignment is not offered because the memory resource is fixed.
+    ClassParser(ClassParser &&other) noexcept = default;
+    ClassParser(const ClassParser &) = delete;
+    ClassParser &operator=(const ClassParser &) = delete;
+
+    void set_symbol_table(SymbolTable *symbols) { this->symbols = symbols; }
+    SymbolTable *get_symbol_table() const { return symbols; }
+    ParseOptions get_options() const { return options; }
+
+    // Rebinds the parser to a new class. Containers keep their capacity for the next parse.
+    void reset(std::span<const uint8_t> data);
+    void reset(const std::string &filename, LoadMode mode = LOAD_STREAM);
+
+    void parse(ParseOptions options = PARSE_DEFAULT);
+    void parse(std::span<const uint8_t> data, ParseOptions options = PARSE_DEFAULT);
+    void parse(ClassVisitor &visitor, ParseOptions options = PARSE_DEFAULT);
     void dump() const;
 
+    static ClassSummary scan_header(std::span<const uint8_t> data);
+    static ClassSummary scan_header(const std::string &filename);
+
     MethodInfo *find_main_method();
-    MethodInfo *find_method(const std::string &name);
-    MethodInfo *find_method(const std::string &name, const std::string &descriptor);
-
-    const std::vector<ConstantPoolInfo *> &get_constant_pool() const;
-    const std::vector<FieldInfo> &get_fields() const { return fields; }
-    const std::vector<MethodInfo> &get_methods() const { return methods; }
-    const std::string &get_class_name() const;
-    const std::string &get_super_class_name() const;
+    MethodInfo *find_method(std::string_view name);
+    MethodInfo *find_method(std::string_view name, std::string_view descriptor);
+    FieldInfo *find_field(std::string_view name);
+    FieldInfo *find_field(std::string_view name, std::string_view descriptor);
+    const MethodInfo *find_main_method() const;
+    const MethodInfo *find_method(std::string_view name) const;
+    const MethodInfo *find_method(std::string_view name, std::string_view descriptor) const;
+    const FieldInfo *find_field(std::string_view name) const;
+    const FieldInfo *find_field(std::string_view name, std::string_view descriptor) const;
+
+    // Fills every lazy cache so the const interface no longer mutates and can be shared across threads.
+    void freeze();
+
+    const ConstantPool &get_constant_pool() const;
+    const std::pmr::vector<FieldInfo> &get_fields() const { return fields; }
+    const std::pmr::vector<MethodInfo> &get_methods() const { return methods; }
+    const std::pmr::vector<uint16_t> &get_interfaces() const { return interfaces; }
+    std::string_view get_class_name() const { return class_name; }
+    std::string_view get_super_class_name() const { return super_class_name; }
+    std::pmr::memory_resource *get_memory_resource() const { return allocator.resource(); }
     uint16_t get_major_version() const { return major_version; }
     uint16_t get_minor_version() const { return minor_version; }
     uint16_t get_access_flags() const { return access_flags; }
+    SymbolTable::Symbol get_class_symbol() const { return class_symbol; }
+    SymbolTable::Symbol get_super_class_symbol() const { return super_class_symbol; }
+
+    const SpecializedAttribute &decode_attribute(const CodeAttribute::AttributeInfo &attribute) const;
+    // The attribute type named by a Utf8 pool entry, classified once per entry and cached until the next parse.
+    SpecializedAttribute::Type attribute_kind(uint16_t name_index) const;
+    // Every member reference in the pool is resolved on the first call and cached until the next parse.
+    // Safe to call from several threads once Utf8 entries are decoded (see freeze()).
+    const MemberReference &resolve_member_reference(uint16_t index) const;
 
     std::string get_utf8_string(uint16_t index) const;
+    std::string_view get_utf8_view(uint16_t index) const;
     std::string get_class_name(uint16_t index) const;
+    std::string_view get_class_name_view(uint16_t index) const;
     std::string get_super_class_name(uint16_t index) const;
     std::string get_method_descriptor(uint16_t index) const;
     std::string get_field_descriptor(uint16_t index) const;
-    const std::vector<CodeAttribute::AttributeInfo>& get_class_attributes() const { return class_attributes; }
+    const std::pmr::vector<CodeAttribute::AttributeInfo>& get_class_attributes() const { return class_attributes; }
 
     std::string get_method_name(const MethodInfo& method) const;
     std::string get_field_name(const FieldInfo& field) const;
     std::string get_access_flags_string(uint16_t flags, bool is_method = false) const;
     std::string to_string() const;
 
-    typedef std::vector<FieldInfo>::const_iterator field_iterator;
-    typedef std::vector<MethodInfo>::const_iterator method_iterator;
+    typedef std::pmr::vector<FieldInfo>::const_iterator field_iterator;
+    typedef std::pmr::vector<MethodInfo>::const_iterator method_iterator;
 
     field_iterator fields_begin() const { return fields.begin(); }
     field_iterator fields_end() const { return fields.end(); }
@@ -468,38 +717,98 @@ public:
     method_iterator methods_end() const { return methods.end(); }
 
 private:
+    Allocator allocator;
     std::string filename;
-    uint8_t *file_data;
+    const uint8_t *file_data = nullptr;
+    std::vector<uint8_t> owned_data;
+    MappedFile mapped_file;
     size_t file_size = 0;
     size_t cursor = 0;
-    std::string class_name;
-    std::string super_class_name;
-
-    uint32_t magic;
-    uint16_t minor_version;
-    uint16_t major_version;
-    uint16_t access_flags;
-    uint16_t this_class_index;
-    uint16_t super_class_index;
-    uint16_t interfaces_count;
-
-    std::vector<ConstantPoolInfo *> constant_pool;
-    std::vector<MethodInfo> methods;
-    std::vector<FieldInfo> fields;
-    std::vector<uint16_t> interfaces;
-    std::vector<CodeAttribute::AttributeInfo> class_attributes;
+    ParseOptions options = PARSE_DEFAULT;
+    std::string_view class_name;
+    std::string_view super_class_name;
+
+    uint32_t magic = 0;
+    uint16_t minor_version = 0;
+    uint16_t major_version = 0;
+    uint16_t access_flags = 0;
+    uint16_t this_class_index = 0;
+    uint16_t super_class_index = 0;
+    uint16_t interfaces_count = 0;
+
+    ConstantPool constant_pool{allocator};
+    std::pmr::vector<MethodInfo> methods{allocator};
+    std::pmr::vector<FieldInfo> fields{allocator};
+    std::pmr::vector<uint16_t> interfaces{allocator};
+    std::pmr::vector<CodeAttribute::AttributeInfo> class_attributes{allocator};
+
+    static constexpr uint8_t ATTRIBUTE_KIND_UNRESOLVED = 0xFF;
+    mutable std::pmr::vector<uint8_t> attribute_kinds{allocator};
+    uint64_t skipped_attribute_kinds = 0;
+
+    SymbolTable *symbols = nullptr;
+    std::pmr::vector<SymbolTable::Symbol> pool_symbols{allocator};
+    SymbolTable::Symbol class_symbol = SymbolTable::NO_SYMBOL;
+    SymbolTable::Symbol super_class_symbol = SymbolTable::NO_SYMBOL;
+
+    struct MemberKey {
+        std::string_view name;
+        std::string_view descriptor;
+
+        bool operator==(const MemberKey &other) const = default;
+    };
+
+    struct MemberKeyHash {
+        size_t operator()(const MemberKey &key) const;
+    };
+
+    // Built on the first lookup after a parse; keys are the members' name and descriptor views.
+    struct MemberIndex {
+        bool built = false;
+        std::pmr::unordered_map<std::string_view, size_t> by_name;
+        std::pmr::unordered_map<MemberKey, size_t, MemberKeyHash> by_signature;
+
+        explicit MemberIndex(const Allocator &allocator) : by_name(allocator), by_signature(allocator) {}
+
+        template<typename Member>
+        void build(const std::pmr::vector<Member> &members);
+        void clear();
+    };
+
+    MemberIndex method_index{allocator};
+    MemberIndex field_index{allocator};
+
+    struct MemberReferenceTable;
+
+    // Published with a compare-and-swap like decoded attributes; moving the parser hands it over.
+    struct MemberReferenceCache {
+        std::atomic<const MemberReferenceTable *> table{nullptr};
+
+        MemberReferenceCache() = default;
+        MemberReferenceCache(MemberReferenceCache &&other) noexcept : table(other.table.exchange(nullptr)) {}
+        ~MemberReferenceCache() { clear(); }
+
+        void clear();
+    };
+
+    mutable MemberReferenceCache member_references;
 
     bool load_file();
+    bool map_file();
     void ensure_available(size_t bytes) const;
+    void skip(size_t bytes);
     uint8_t read_uint8();
     uint16_t read_uint16();
     uint32_t read_uint32();
     uint64_t read_uint64();
 
-    std::string read_modified_utf8(uint16_t length);
+    size_t read_modified_utf8(uint16_t length, char *out);
 
     uint8_t read_u1();
 
+    void parse_header(ParseOptions options);
+    ClassSummary summarize() const;
+
     void parse_constant_pool();
 
     void parse_access_flags();
@@ -511,38 +820,46 @@ private:
     void parse_interfaces();
     void parse_fields();
     void parse_methods();
-    void parse_attributes(uint16_t count, MethodInfo* method = nullptr,
+    bool parse_attributes(uint16_t count, MethodInfo* method = nullptr,
                          FieldInfo* field = nullptr,
-                         std::vector<CodeAttribute::AttributeInfo>* out_attrs = nullptr);
+                         std::pmr::vector<CodeAttribute::AttributeInfo>* out_attrs = nullptr);
     void parse_code_attribute(CodeAttribute* code_attr);
-
-    SpecializedAttribute parse_specialized_attribute(const std::string& name, const std::vector<uint8_t>& data);
-    void parse_source_file_attribute(SourceFileAttribute& attr, const std::vector<uint8_t>& data);
-    void parse_line_number_table_attribute(LineNumberTableAttribute& attr, const std::vector<uint8_t>& data);
-    void parse_local_variable_table_attribute(LocalVariableTableAttribute& attr, const std::vector<uint8_t>& data);
-    void parse_exceptions_attribute(ExceptionsAttribute& attr, const std::vector<uint8_t>& data);
-    void parse_constant_value_attribute(ConstantValueAttribute& attr, const std::vector<uint8_t>& data);
-    void parse_bootstrap_methods_attribute(BootstrapMethodsAttribute& attr, const std::vector<uint8_t>& data);
-    void parse_signature_attribute(SignatureAttribute& attr, const std::vector<uint8_t>& data);
-    void parse_deprecated_attribute(DeprecatedAttribute& attr, const std::vector<uint8_t>& data);
-    void parse_synthetic_attribute(SyntheticAttribute& attr, const std::vector<uint8_t>& data);
-    void parse_inner_classes_attribute(InnerClassesAttribute& attr, const std::vector<uint8_t>& data);
-    void parse_enclosing_method_attribute(EnclosingMethodAttribute& attr, const std::vector<uint8_t>& data);
-    void parse_source_debug_extension_attribute(SourceDebugExtensionAttribute& attr, const std::vector<uint8_t>& data);
-    void parse_local_variable_type_table_attribute(LocalVariableTypeTableAttribute& attr, const std::vector<uint8_t>& data);
-    void parse_method_parameters_attribute(MethodParametersAttribute& attr, const std::vector<uint8_t>& data);
-    void parse_runtime_visible_annotations_attribute(RuntimeVisibleAnnotationsAttribute& attr, const std::vector<uint8_t>& data);
-    void parse_runtime_invisible_annotations_attribute(RuntimeInvisibleAnnotationsAttribute& attr, const std::vector<uint8_t>& data);
-    void parse_runtime_visible_parameter_annotations_attribute(RuntimeVisibleParameterAnnotationsAttribute& attr, const std::vector<uint8_t>& data);
-    void parse_runtime_invisible_parameter_annotations_attribute(RuntimeInvisibleParameterAnnotationsAttribute& attr, const std::vector<uint8_t>& data);
-    void parse_runtime_visible_type_annotations_attribute(RuntimeVisibleTypeAnnotationsAttribute& attr, const std::vector<uint8_t>& data);
-    void parse_runtime_invisible_type_annotations_attribute(RuntimeInvisibleTypeAnnotationsAttribute& attr, const std::vector<uint8_t>& data);
-    void parse_annotation_default_attribute(AnnotationDefaultAttribute& attr, const std::vector<uint8_t>& data);
-    void parse_module_attribute(ModuleAttribute& attr, const std::vector<uint8_t>& data);
-    void parse_module_packages_attribute(ModulePackagesAttribute& attr, const std::vector<uint8_t>& data);
-    void parse_module_main_class_attribute(ModuleMainClassAttribute& attr, const std::vector<uint8_t>& data);
-    void parse_nest_host_attribute(NestHostAttribute& attr, const std::vector<uint8_t>& data);
-    void parse_nest_members_attribute(NestMembersAttribute& attr, const std::vector<uint8_t>& data);
-    void parse_record_attribute(RecordAttribute& attr, const std::vector<uint8_t>& data);
-    void parse_permitted_subclasses_attribute(PermittedSubclassesAttribute& attr, const std::vector<uint8_t>& data);
+    void read_attribute_payload(uint32_t length, CodeAttribute::AttributeInfo &attribute);
+    void skip_attributes(uint16_t count);
+    void visit_attributes(ClassVisitor &visitor, int target, uint16_t count);
+    void visit_code(ClassVisitor &visitor, uint32_t length);
+    bool is_skipped_attribute(SpecializedAttribute::Type kind) const;
+    SymbolTable::Symbol intern_utf8(uint16_t index);
+    MemberReference read_member_reference(uint16_t index) const;
+    const MemberReferenceTable &member_reference_table() const;
+
+    SpecializedAttribute parse_specialized_attribute(uint16_t name_index, std::span<const uint8_t> data) const;
+    void parse_source_file_attribute(SourceFileAttribute& attr, std::span<const uint8_t> data) const;
+    void parse_line_number_table_attribute(LineNumberTableAttribute& attr, std::span<const uint8_t> data) const;
+    void parse_local_variable_table_attribute(LocalVariableTableAttribute& attr, std::span<const uint8_t> data) const;
+    void parse_exceptions_attribute(ExceptionsAttribute& attr, std::span<const uint8_t> data) const;
+    void parse_constant_value_attribute(ConstantValueAttribute& attr, std::span<const uint8_t> data) const;
+    void parse_bootstrap_methods_attribute(BootstrapMethodsAttribute& attr, std::span<const uint8_t> data) const;
+    void parse_signature_attribute(SignatureAttribute& attr, std::span<const uint8_t> data) const;
+    void parse_deprecated_attribute(DeprecatedAttribute& attr, std::span<const uint8_t> data) const;
+    void parse_synthetic_attribute(SyntheticAttribute& attr, std::span<const uint8_t> data) const;
+    void parse_inner_classes_attribute(InnerClassesAttribute& attr, std::span<const uint8_t> data) const;
+    void parse_enclosing_method_attribute(EnclosingMethodAttribute& attr, std::span<const uint8_t> data) const;
+    void parse_source_debug_extension_attribute(SourceDebugExtensionAttribute& attr, std::span<const uint8_t> data) const;
+    void parse_local_variable_type_table_attribute(LocalVariableTypeTableAttribute& attr, std::span<const uint8_t> data) const;
+    void parse_method_parameters_attribute(MethodParametersAttribute& attr, std::span<const uint8_t> data) const;
+    void parse_runtime_visible_annotations_attribute(RuntimeVisibleAnnotationsAttribute& attr, std::span<const uint8_t> data) const;
+    void parse_runtime_invisible_annotations_attribute(RuntimeInvisibleAnnotationsAttribute& attr, std::span<const uint8_t> data) const;
+    void parse_runtime_visible_parameter_annotations_attribute(RuntimeVisibleParameterAnnotationsAttribute& attr, std::span<const uint8_t> data) const;
+    void parse_runtime_invisible_parameter_annotations_attribute(RuntimeInvisibleParameterAnnotationsAttribute& attr, std::span<const uint8_t> data) const;
+    void parse_runtime_visible_type_annotations_attribute(RuntimeVisibleTypeAnnotationsAttribute& attr, std::span<const uint8_t> data) const;
+    void parse_runtime_invisible_type_annotations_attribute(RuntimeInvisibleTypeAnnotationsAttribute& attr, std::span<const uint8_t> data) const;
+    void parse_annotation_default_attribute(AnnotationDefaultAttribute& attr, std::span<const uint8_t> data) const;
+    void parse_module_attribute(ModuleAttribute& attr, std::span<const uint8_t> data) const;
+    void parse_module_packages_attribute(ModulePackagesAttribute& attr, std::span<const uint8_t> data) const;
+    void parse_module_main_class_attribute(ModuleMainClassAttribute& attr, std::span<const uint8_t> data) const;
+    void parse_nest_host_attribute(NestHostAttribute& attr, std::span<const uint8_t> data) const;
+    void parse_nest_members_attribute(NestMembersAttribute& attr, std::span<const uint8_t> data) const;
+    void parse_record_attribute(RecordAttribute& attr, std::span<const uint8_t> data) const;
+    void parse_permitted_subclasses_attribute(PermittedSubclassesAttribute& attr, std::span<const uint8_t> data) const;
 };
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+#include "class_parser.h"
+
+// Callbacks driven by ClassParser::parse(ClassVisitor &). Names and payloads are views into the
+// parser's constant pool and class buffer and are only valid during the callback.
+class ClassVisitor {
+public:
+    enum Action {
+        CONTINUE,
+        SKIP,
+    };
+
+    enum AttributeTarget {
+        ATTRIBUTE_CLASS,
+        ATTRIBUTE_FIELD,
+        ATTRIBUTE_METHOD,
+        ATTRIBUTE_CODE,
+    };
+
+    virtual ~ClassVisitor() = default;
+
+    virtual void visit_header(const ClassParser &/*parser*/) {}
+
+    virtual Action visit_constant_pool(size_t /*count*/) { return SKIP; }
+    virtual void visit_constant(uint16_t /*index*/, const ClassParser::ConstantPoolInfo &/*info*/) {}
+
+    virtual Action visit_field(uint16_t /*access_flags*/, std::string_view /*name*/, std::string_view /*descriptor*/) {
+        return CONTINUE;
+    }
+    virtual void visit_field_end() {}
+
+    virtual Action visit_method(uint16_t /*access_flags*/, std::string_view /*name*/, std::string_view /*descriptor*/) {
+        return CONTINUE;
+    }
+    virtual Action visit_code(uint16_t /*max_stack*/, uint16_t /*max_locals*/, std::span<const uint8_t> /*code*/) {
+        return CONTINUE;
+    }
+    virtual void visit_exception_handler(const ClassParser::ExceptionTableEntry &/*entry*/) {}
+    virtual void visit_method_end() {}
+
+    virtual void visit_attribute(AttributeTarget /*target*/, std::string_view /*name*/, std::span<const uint8_t> /*data*/) {}
+
+    virtual void visit_end() {}
+};
@@ -0,0 +1,264 @@
+#include "control_flow_graph.h"
+
+#include <algorithm>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+
+#include "bytecode.h"
+
+namespace {
+    enum : uint8_t {
+        MARK_INSTRUCTION = 1,
+        MARK_LEADER = 2,
+    };
+
+    const char *edge_kind_name(const ControlFlowGraph::EdgeKind kind) {
+        switch (kind) {
+            case ControlFlowGraph::EDGE_FALLTHROUGH: return "fallthrough";
+            case ControlFlowGraph::EDGE_BRANCH: return "branch";
+            case ControlFlowGraph::EDGE_SWITCH: return "switch";
+            case ControlFlowGraph::EDGE_JSR: return "jsr";
+            case ControlFlowGraph::EDGE_EXCEPTION: return "exception";
+        }
+        return "unknown";
+    }
+
+    bool is_return(const uint8_t opcode) {
+        return opcode >= Bytecode::OP_IRETURN && opcode <= Bytecode::OP_RETURN;
+    }
+
+    bool is_jsr(const uint8_t opcode) {
+        return opcode == Bytecode::OP_JSR || opcode == Bytecode::OP_JSR_W;
+    }
+
+    // Whether control can continue to the next instruction.
+    bool falls_through(const Bytecode::Instruction &instruction) {
+        const uint8_t opcode = instruction.get_opcode();
+        switch (instruction.get_info().operand) {
+            case Bytecode::OPERAND_TABLESWITCH:
+            case Bytecode::OPERAND_LOOKUPSWITCH:
+                return false;
+            default:
+                break;
+        }
+        return opcode != Bytecode::OP_GOTO && opcode != Bytecode::OP_GOTO_W && opcode != Bytecode::OP_RET &&
+               opcode != Bytecode::OP_ATHROW && !is_return(opcode);
+    }
+
+    bool ends_block(const Bytecode::Instruction &instruction) {
+        switch (instruction.get_info().operand) {
+            case Bytecode::OPERAND_BRANCH:
+            case Bytecode::OPERAND_BRANCH_WIDE:
+            case Bytecode::OPERAND_TABLESWITCH:
+            case Bytecode::OPERAND_LOOKUPSWITCH:
+                return true;
+            default:
+                return !falls_through(instruction);
+        }
+    }
+}
+
+std::string ControlFlowGraph::Edge::to_string() const {
+    std::ostringstream oss;
+    oss << "B" << source << " -> B" << target << " " << edge_kind_name(kind);
+    if (kind == EDGE_EXCEPTION) oss << "#" << handler;
+    return oss.str();
+}
+
+std::string ControlFlowGraph::Block::to_string() const {
+    std::ostringstream oss;
+    oss << "[" << start_pc << ", " << end_pc << ") " << instruction_count << " instructions";
+    return oss.str();
+}
+
+ControlFlowGraph::ControlFlowGraph(const ClassParser::CodeAttribute &code) {
+    build(code.bytecode(), code.exception_table);
+}
+
+ControlFlowGraph::ControlFlowGraph(const std::span<const uint8_t> code,
+                                   const std::span<const ClassParser::ExceptionTableEntry> exception_table) {
+    build(code, exception_table);
+}
+
+void ControlFlowGraph::build(const std::span<const uint8_t> code,
+                             const std::span<const ClassParser::ExceptionTableEntry> exception_table) {
+    if (code.empty()) {
+        throw std::runtime_error("Method has no code");
+    }
+    if (code.size() >= std::numeric_limits<uint32_t>::max()) {
+        throw std::runtime_error("Code too large: " + std::to_string(code.size()) + " bytes");
+    }
+    const auto size = static_cast<uint32_t>(code.size());
+    const Bytecode bytecode(code);
+
+    // Pass 1: mark instruction starts and leaders. Targets are checked once every start is known.
+    std::vector<uint8_t> marks(size + 1, 0);
+    const auto mark_target = [&](const uint32_t pc, const int64_t target) {
+        if (target < 0 || target >= size) {
+            throw std::runtime_error("Branch target " + std::to_string(target) + " out of range at pc " +
+                                     std::to_string(pc));
+        }
+        marks[target] |= MARK_LEADER;
+    };
+    marks[0] |= MARK_LEADER;
+    Bytecode::Instruction last;
+    for (const Bytecode::Instruction &instruction: bytecode) {
+        const uint32_t pc = instruction.get_offset();
+        marks[pc] |= MARK_INSTRUCTION;
+        switch (instruction.get_info().operand) {
+            case Bytecode::OPERAND_BRANCH:
+            case Bytecode::OPERAND_BRANCH_WIDE:
+                mark_target(pc, static_cast<int64_t>(pc) + instruction.get_branch_offset());
+                break;
+            case Bytecode::OPERAND_TABLESWITCH:
+            case Bytecode::OPERAND_LOOKUPSWITCH:
+                mark_target(pc, static_cast<int64_t>(pc) + instruction.get_default_offset());
+                for (uint32_t i = 0, count = instruction.get_case_count(); i < count; ++i) {
+                    mark_target(pc, static_cast<int64_t>(pc) + instruction.get_case_offset(i));
+                }
+                break;
+            default:
+                break;
+        }
+        if (ends_block(instruction)) {
+            marks[pc + instruction.get_length()] |= MARK_LEADER;
+        }
+        last = instruction;
+    }
+    if (falls_through(last)) {
+        throw std::runtime_error("Execution falls off the end of the code at pc " + std::to_string(last.get_offset()));
+    }
+    for (const ClassParser::ExceptionTableEntry &entry: exception_table) {
+        if (entry.start_pc >= entry.end_pc || entry.end_pc > size || entry.handler_pc >= size) {
+            throw std::runtime_error("Invalid exception table entry: " + entry.to_string());
+        }
+        marks[entry.start_pc] |= MARK_LEADER;
+        marks[entry.end_pc] |= MARK_LEADER;
+        marks[entry.handler_pc] |= MARK_LEADER;
+    }
+    marks[size] = MARK_INSTRUCTION;
+
+    // Pass 2: cut blocks at the leaders, remembering each block's last instruction.
+    std::vector<uint32_t> block_of(size);
+    std::vector<uint32_t> last_instruction;
+    blocks.clear();
+    for (uint32_t pc = 0; pc < size; ++pc) {
+        const uint8_t mark = marks[pc];
+        if (mark & MARK_LEADER) {
+            if (!(mark & MARK_INSTRUCTION)) {
+                throw std::runtime_error("Block boundary at pc " + std::to_string(pc) + " is not an instruction start");
+            }
+            if (!blocks.empty()) {
+                blocks.back().end_pc = pc;
+            }
+            block_of[pc] = static_cast<uint32_t>(blocks.size());
+            Block &block = blocks.emplace_back();
+            block.start_pc = pc;
+            last_instruction.push_back(pc);
+        }
+        if (mark & MARK_INSTRUCTION) {
+            blocks.back().instruction_count++;
+            last_instruction.back() = pc;
+        }
+    }
+    blocks.back().end_pc = size;
+    for (const ClassParser::ExceptionTableEntry &entry: exception_table) {
+        if (!(marks[entry.end_pc] & MARK_INSTRUCTION)) {
+            throw std::runtime_error("Exception range does not end at an instruction: " + entry.to_string());
+        }
+    }
+
+    // Pass 3: edges in source order, then exception edges, then distributed by a stable counting
+    // sort into per-block successor and predecessor slices.
+    const auto block_count = static_cast<uint32_t>(blocks.size());
+    std::vector<Edge> edges;
+    edges.reserve(block_count * 2);
+    std::vector<uint32_t> switch_seen(block_count, std::numeric_limits<uint32_t>::max());
+    for (uint32_t b = 0; b < block_count; ++b) {
+        const Bytecode::Instruction instruction = bytecode.at(last_instruction[b]);
+        const uint32_t pc = instruction.get_offset();
+        switch (instruction.get_info().operand) {
+            case Bytecode::OPERAND_BRANCH:
+            case Bytecode::OPERAND_BRANCH_WIDE:
+                edges.push_back({b, block_of[instruction.get_branch_target()],
+                                 is_jsr(instruction.get_opcode()) ? EDGE_JSR : EDGE_BRANCH, NO_HANDLER});
+                break;
+            case Bytecode::OPERAND_TABLESWITCH:
+            case Bytecode::OPERAND_LOOKUPSWITCH: {
+                // Switches often share targets; each target block gets one edge.
+                const auto add_case = [&](const int32_t offset) {
+                    const uint32_t target = block_of[pc + offset];
+                    if (switch_seen[target] != b) {
+                        switch_seen[target] = b;
+                        edges.push_back({b, target, EDGE_SWITCH, NO_HANDLER});
+                    }
+                };
+                add_case(instruction.get_default_offset());
+                for (uint32_t i = 0, count = instruction.get_case_count(); i < count; ++i) {
+                    add_case(instruction.get_case_offset(i));
+                }
+                break;
+            }
+            default:
+                break;
+        }
+        if (falls_through(instruction)) {
+            edges.push_back({b, b + 1, EDGE_FALLTHROUGH, NO_HANDLER});
+        }
+    }
+    for (size_t i = 0; i < exception_table.size(); ++i) {
+        const ClassParser::ExceptionTableEntry &entry = exception_table[i];
+        const uint32_t handler = block_of[entry.handler_pc];
+        for (uint32_t b = block_of[entry.start_pc]; b < block_count && blocks[b].start_pc < entry.end_pc; ++b) {
+            edges.push_back({b, handler, EDGE_EXCEPTION, static_cast<uint16_t>(i)});
+        }
+    }
+
+    for (const Edge &edge: edges) {
+        blocks[edge.source].successors_end++;
+        blocks[edge.target].predecessors_end++;
+    }
+    uint32_t successor_offset = 0;
+    uint32_t predecessor_offset = 0;
+    for (Block &block: blocks) {
+        block.successors_begin = successor_offset;
+        successor_offset += block.successors_end;
+        block.successors_end = block.successors_begin;
+        block.predecessors_begin = predecessor_offset;
+        predecessor_offset += block.predecessors_end;
+        block.predecessors_end = block.predecessors_begin;
+    }
+    successors.resize(edges.size());
+    predecessors.resize(edges.size());
+    for (const Edge &edge: edges) {
+        successors[blocks[edge.source].successors_end++] = edge;
+        predecessors[blocks[edge.target].predecessors_end++] = edge;
+    }
+}
+
+uint32_t ControlFlowGraph::block_at(const uint32_t pc) const {
+    if (blocks.empty() || pc >= blocks.back().end_pc) {
+        throw std::out_of_range("pc " + std::to_string(pc) + " is outside the code");
+    }
+    const auto it = std::upper_bound(blocks.begin(), blocks.end(), pc, [](const uint32_t value, const Block &block) {
+        return value < block.start_pc;
+    });
+    return static_cast<uint32_t>(it - blocks.begin() - 1);
+}
+
+std::string ControlFlowGraph::to_string() const {
+    std::ostringstream oss;
+    oss << "ControlFlowGraph[" << blocks.size() << " blocks, " << successors.size() << " edges]\n";
+    for (uint32_t b = 0; b < blocks.size(); ++b) {
+        oss << "  B" << b << " " << blocks[b].to_string();
+        const char *separator = " -> ";
+        for (const Edge &edge: get_successors(b)) {
+            oss << separator << "B" << edge.target << " " << edge_kind_name(edge.kind);
+            if (edge.kind == EDGE_EXCEPTION) oss << "#" << edge.handler;
+            separator = ", ";
+        }
+        oss << "\n";
+    }
+    return oss.str();
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "class_parser.h"
+
+// Basic blocks and edges of one method, in flat arrays. Blocks are numbered in pc order, so block
+// 0 is the entry. Each block's successors and predecessors are contiguous slices of two edge
+// arrays, normal edges first and exception edges after them in exception table order.
+class ControlFlowGraph {
+public:
+    enum EdgeKind : uint8_t {
+        EDGE_FALLTHROUGH,
+        EDGE_BRANCH,
+        EDGE_SWITCH,
+        // jsr to its subroutine; the jsr also falls through to its return point.
+        EDGE_JSR,
+        EDGE_EXCEPTION,
+    };
+
+    static constexpr uint16_t NO_HANDLER = 0xffff;
+
+    struct Edge {
+        uint32_t source = 0;
+        uint32_t target = 0;
+        EdgeKind kind = EDGE_FALLTHROUGH;
+        // Index into the exception table for EDGE_EXCEPTION.
+        uint16_t handler = NO_HANDLER;
+
+        std::string to_string() const;
+    };
+
+    struct Block {
+        uint32_t start_pc = 0;
+        uint32_t end_pc = 0;
+        uint32_t instruction_count = 0;
+        uint32_t successors_begin = 0;
+        uint32_t successors_end = 0;
+        uint32_t predecessors_begin = 0;
+        uint32_t predecessors_end = 0;
+
+        std::string to_string() const;
+    };
+
+    // Leaders are pc 0, branch and switch targets, instructions after a branch, switch, jsr, ret,
+    // return or athrow, handlers, and both ends of every protected range. ret has no successors.
+    explicit ControlFlowGraph(const ClassParser::CodeAttribute &code);
+    ControlFlowGraph(std::span<const uint8_t> code, std::span<const ClassParser::ExceptionTableEntry> exception_table);
+
+    size_t size() const { return blocks.size(); }
+    const std::vector<Block> &get_blocks() const { return blocks; }
+    const Block &get_block(const uint32_t index) const { return blocks.at(index); }
+    size_t get_edge_count() const { return successors.size(); }
+
+    std::span<const Edge> get_successors(const uint32_t block) const {
+        const Block &b = blocks.at(block);
+        return {successors.data() + b.successors_begin, successors.data() + b.successors_end};
+    }
+
+    std::span<const Edge> get_predecessors(const uint32_t block) const {
+        const Block &b = blocks.at(block);
+        return {predecessors.data() + b.predecessors_begin, predecessors.data() + b.predecessors_end};
+    }
+
+    // Block containing pc, which need not be an instruction start.
+    uint32_t block_at(uint32_t pc) const;
+
+    std::string to_string() const;
+
+private:
+    std::vector<Block> blocks;
+    std::vector<Edge> successors;
+    std::vector<Edge> predecessors;
+
+    void build(std::span<const uint8_t> code, std::span<const ClassParser::ExceptionTableEntry> exception_table);
+};
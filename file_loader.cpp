@@ -0,0 +1,640 @@
+#include "file_loader.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    std::runtime_error load_error(const char *path, const int error) {
+        return std::runtime_error("Failed to load file: " + std::string(path) + ": " + std::strerror(error));
+    }
+
+    struct Loaded {
+        size_t index = 0;
+        size_t reserved = 0;
+        std::vector<uint8_t> data;
+        std::exception_ptr error;
+    };
+
+    // Hand-off between the loader and the workers. reserve() admits a file only while the bytes
+    // reserved by reads in flight, queued files and files being consumed stay under the limit.
+    // Recycled buffers count against the same limit and are dropped first when space runs out.
+    class LoadQueue {
+    public:
+        LoadQueue(const size_t byte_limit, const size_t entry_limit)
+            : byte_limit(byte_limit), entry_limit(entry_limit) {
+        }
+
+        bool try_reserve(const size_t bytes) {
+            std::lock_guard lock(mutex);
+            return reserve_locked(bytes);
+        }
+
+        bool reserve(const size_t bytes) {
+            std::unique_lock lock(mutex);
+            space.wait(lock, [&] { return cancelled || reserve_locked(bytes); });
+            return !cancelled;
+        }
+
+        std::vector<uint8_t> take_buffer() {
+            std::lock_guard lock(mutex);
+            if (spare.empty()) {
+                return {};
+            }
+            std::vector<uint8_t> buffer = std::move(spare.back());
+            spare.pop_back();
+            spare_bytes -= buffer.capacity();
+            return buffer;
+        }
+
+        void push(Loaded &&loaded) {
+            {
+                std::lock_guard lock(mutex);
+                if (!cancelled) {
+                    ready.push_back(std::move(loaded));
+                } else {
+                    release_locked(loaded.reserved, std::move(loaded.data));
+                }
+            }
+            available.notify_one();
+        }
+
+        bool pop(Loaded &loaded) {
+            std::unique_lock lock(mutex);
+            available.wait(lock, [&] { return cancelled || closed || !ready.empty(); });
+            if (cancelled || ready.empty()) {
+                return false;
+            }
+            loaded = std::move(ready.front());
+            ready.pop_front();
+            return true;
+        }
+
+        void release(const size_t bytes, std::vector<uint8_t> &&buffer) {
+            {
+                std::lock_guard lock(mutex);
+                release_locked(bytes, std::move(buffer));
+            }
+            space.notify_one();
+        }
+
+        void close() {
+            {
+                std::lock_guard lock(mutex);
+                closed = true;
+            }
+            available.notify_all();
+        }
+
+        void cancel(const std::exception_ptr &error) {
+            {
+                std::lock_guard lock(mutex);
+                if (!first_error) {
+                    first_error = error;
+                }
+                cancelled = true;
+                for (Loaded &loaded: ready) {
+                    release_locked(loaded.reserved, std::move(loaded.data));
+                }
+                ready.clear();
+            }
+            available.notify_all();
+            space.notify_all();
+        }
+
+        bool is_cancelled() {
+            std::lock_guard lock(mutex);
+            return cancelled;
+        }
+
+        std::exception_ptr error() {
+            std::lock_guard lock(mutex);
+            return first_error;
+        }
+
+    private:
+        std::mutex mutex;
+        std::condition_variable available;
+        std::condition_variable space;
+        std::deque<Loaded> ready;
+        std::vector<std::vector<uint8_t> > spare;
+        const size_t byte_limit;
+        const size_t entry_limit;
+        size_t reserved_bytes = 0;
+        size_t reserved_entries = 0;
+        size_t spare_bytes = 0;
+        bool closed = false;
+        bool cancelled = false;
+        std::exception_ptr first_error;
+
+        bool reserve_locked(const size_t bytes) {
+            while (!spare.empty() && reserved_bytes + bytes + spare_bytes > byte_limit) {
+                spare_bytes -= spare.back().capacity();
+                spare.pop_back();
+            }
+            if (reserved_entries != 0 && (reserved_bytes + bytes > byte_limit || reserved_entries >= entry_limit)) {
+                return false;
+            }
+            reserved_bytes += bytes;
+            reserved_entries++;
+            return true;
+        }
+
+        void release_locked(const size_t bytes, std::vector<uint8_t> &&buffer) {
+            reserved_bytes -= bytes;
+            reserved_entries--;
+            if (buffer.capacity() != 0 && reserved_bytes + spare_bytes + buffer.capacity() <= byte_limit) {
+                spare_bytes += buffer.capacity();
+                spare.push_back(std::move(buffer));
+            }
+        }
+    };
+
+    // Reads the whole file, reserving its size in the queue first. Sets errno on failure.
+    bool read_fully(const char *path, std::vector<uint8_t> &data, size_t &reserved, LoadQueue &queue) {
+        std::error_code ec;
+        const uintmax_t size = std::filesystem::file_size(path, ec);
+        if (ec) {
+            errno = ec.default_error_condition().value();
+            return false;
+        }
+        reserved = static_cast<size_t>(size);
+        if (!queue.reserve(reserved)) {
+            errno = ECANCELED;
+            return false;
+        }
+        errno = 0;
+        std::ifstream file(path, std::ios::binary);
+        data = queue.take_buffer();
+        data.resize(reserved);
+        file.read(reinterpret_cast<char *>(data.data()), static_cast<std::streamsize>(data.size()));
+        if (!file.is_open() || file.bad()) {
+            const int error = errno != 0 ? errno : EIO;
+            queue.release(reserved, std::move(data));
+            errno = error;
+            return false;
+        }
+        data.resize(static_cast<size_t>(file.gcount()));
+        return true;
+    }
+
+    void load_with_threads(const std::span<const char *const> paths, const unsigned reader_count, LoadQueue &queue) {
+        std::atomic<size_t> next{0};
+        const auto reader = [&] {
+            size_t index;
+            while (!queue.is_cancelled() && (index = next.fetch_add(1, std::memory_order_relaxed)) < paths.size()) {
+                Loaded loaded;
+                loaded.index = index;
+                if (!read_fully(paths[index], loaded.data, loaded.reserved, queue)) {
+                    const int error = errno;
+                    if (error == ECANCELED) break;
+                    if (!queue.reserve(0)) break;
+                    loaded.reserved = 0;
+                    loaded.error = std::make_exception_ptr(load_error(paths[index], error));
+                }
+                queue.push(std::move(loaded));
+            }
+        };
+        std::vector<std::thread> readers;
+        for (unsigned i = 0; i < reader_count; ++i) {
+            readers.emplace_back(reader);
+        }
+        for (auto &thread: readers) {
+            thread.join();
+        }
+    }
+
+#ifdef __linux__
+    // Minimal io_uring wrapper over the raw system calls, following the ring protocol of the
+    // kernel's io_uring(7) documentation: we own the SQ tail and the CQ head, the kernel the others.
+    class Ring {
+    public:
+        explicit Ring(const unsigned entries) {
+            io_uring_params params{};
+            fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+            if (fd < 0) {
+                throw std::system_error(errno, std::generic_category(), "io_uring_setup");
+            }
+
+            sq_size = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+            cq_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+            const bool single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+            if (single_mmap) {
+                sq_size = cq_size = std::max(sq_size, cq_size);
+            }
+            sq_ring = mmap(nullptr, sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+                           IORING_OFF_SQ_RING);
+            cq_ring = single_mmap
+                          ? sq_ring
+                          : mmap(nullptr, cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd,
+                                 IORING_OFF_CQ_RING);
+            sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+            sqes = static_cast<io_uring_sqe *>(mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE,
+                                                    MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES));
+            if (sq_ring == MAP_FAILED || cq_ring == MAP_FAILED || sqes == MAP_FAILED) {
+                const int error = errno;
+                unmap();
+                throw std::system_error(error, std::generic_category(), "io_uring mmap");
+            }
+
+            char *sq = static_cast<char *>(sq_ring);
+            sq_head = reinterpret_cast<uint32_t *>(sq + params.sq_off.head);
+            sq_tail = reinterpret_cast<uint32_t *>(sq + params.sq_off.tail);
+            sq_mask = *reinterpret_cast<uint32_t *>(sq + params.sq_off.ring_mask);
+            sq_entries = params.sq_entries;
+            uint32_t *array = reinterpret_cast<uint32_t *>(sq + params.sq_off.array);
+            for (uint32_t i = 0; i < sq_entries; ++i) {
+                array[i] = i;
+            }
+            local_tail = *sq_tail;
+            submitted_tail = local_tail;
+
+            char *cq = static_cast<char *>(cq_ring);
+            cq_head = reinterpret_cast<uint32_t *>(cq + params.cq_off.head);
+            cq_tail = reinterpret_cast<uint32_t *>(cq + params.cq_off.tail);
+            cq_mask = *reinterpret_cast<uint32_t *>(cq + params.cq_off.ring_mask);
+            cqes = reinterpret_cast<io_uring_cqe *>(cq + params.cq_off.cqes);
+        }
+
+        ~Ring() {
+            unmap();
+        }
+
+        Ring(const Ring &) = delete;
+        Ring &operator=(const Ring &) = delete;
+
+        // Flushes queued entries to the kernel when the submission queue is full.
+        io_uring_sqe *next_sqe() {
+            if (local_tail - std::atomic_ref(*sq_head).load(std::memory_order_acquire) >= sq_entries) {
+                submit(0);
+            }
+            io_uring_sqe *sqe = &sqes[local_tail & sq_mask];
+            std::memset(sqe, 0, sizeof(*sqe));
+            local_tail++;
+            return sqe;
+        }
+
+        void submit(const unsigned wait_for) {
+            std::atomic_ref(*sq_tail).store(local_tail, std::memory_order_release);
+            unsigned pending = local_tail - submitted_tail;
+            unsigned wait = wait_for;
+            while (pending != 0 || wait != 0) {
+                const long submitted = syscall(__NR_io_uring_enter, fd, pending, wait,
+                                               wait != 0 ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+                if (submitted < 0) {
+                    if (errno == EINTR || ((errno == EAGAIN || errno == EBUSY) && wait != 0)) {
+                        continue;
+                    }
+                    throw std::system_error(errno, std::generic_category(), "io_uring_enter");
+                }
+                pending -= static_cast<unsigned>(submitted);
+                submitted_tail += static_cast<unsigned>(submitted);
+                wait = 0;
+            }
+        }
+
+        template<typename Handler>
+        unsigned reap(Handler &&handler) {
+            uint32_t head = *cq_head;
+            const uint32_t tail = std::atomic_ref(*cq_tail).load(std::memory_order_acquire);
+            const unsigned count = tail - head;
+            for (; head != tail; ++head) {
+                const io_uring_cqe cqe = cqes[head & cq_mask];
+                std::atomic_ref(*cq_head).store(head + 1, std::memory_order_release);
+                handler(cqe.user_data, cqe.res);
+            }
+            return count;
+        }
+
+    private:
+        int fd = -1;
+        void *sq_ring = MAP_FAILED;
+        void *cq_ring = MAP_FAILED;
+        size_t sq_size = 0;
+        size_t cq_size = 0;
+        size_t sqes_size = 0;
+        io_uring_sqe *sqes = static_cast<io_uring_sqe *>(MAP_FAILED);
+        uint32_t *sq_head = nullptr;
+        uint32_t *sq_tail = nullptr;
+        uint32_t sq_mask = 0;
+        uint32_t sq_entries = 0;
+        uint32_t local_tail = 0;
+        uint32_t submitted_tail = 0;
+        uint32_t *cq_head = nullptr;
+        uint32_t *cq_tail = nullptr;
+        uint32_t cq_mask = 0;
+        io_uring_cqe *cqes = nullptr;
+
+        void unmap() {
+            if (sqes != MAP_FAILED) munmap(sqes, sqes_size);
+            if (cq_ring != MAP_FAILED && cq_ring != sq_ring) munmap(cq_ring, cq_size);
+            if (sq_ring != MAP_FAILED) munmap(sq_ring, sq_size);
+            if (fd >= 0) ::close(fd);
+        }
+    };
+
+    // Each slot walks one file through OPENAT -> READ (repeated on short reads) -> CLOSE. Only the
+    // final CLOSE is left to complete in the background, tagged so its completion is ignored.
+    void load_with_io_uring(const std::span<const char *const> paths, const unsigned queue_depth, LoadQueue &queue) {
+        enum : uint64_t {
+            STAGE_OPEN = 0,
+            STAGE_READ = 1,
+            STAGE_CLOSE = 2,
+        };
+        struct Slot {
+            Loaded loaded;
+            int fd = -1;
+            size_t done = 0;
+            bool reserved = false;
+        };
+
+        // Declared before the ring so that the buffers reads target outlive it.
+        std::vector<Slot> slots(queue_depth);
+        Ring ring(queue_depth * 2);
+        std::vector<unsigned> free_slots;
+        for (unsigned i = queue_depth; i-- > 0;) {
+            free_slots.push_back(i);
+        }
+        std::vector<unsigned> waiting;
+        size_t next = 0;
+        unsigned in_flight = 0;
+
+        // When an exception unwinds, waits for the requests still in flight so the kernel is done
+        // with the slot buffers before they are freed, and closes the files those requests opened.
+        struct Drain {
+            Ring &ring;
+            std::vector<Slot> &slots;
+            unsigned &in_flight;
+            const int exceptions = std::uncaught_exceptions();
+
+            ~Drain() {
+                if (std::uncaught_exceptions() == exceptions) {
+                    return;
+                }
+                try {
+                    while (in_flight != 0) {
+                        ring.submit(1);
+                        ring.reap([&](const uint64_t user_data, const int result) {
+                            in_flight--;
+                            if ((user_data & 3) == STAGE_OPEN && result >= 0) {
+                                ::close(result);
+                            }
+                        });
+                    }
+                } catch (...) {
+                }
+                for (const Slot &slot: slots) {
+                    if (slot.fd >= 0) ::close(slot.fd);
+                }
+            }
+        } drain{ring, slots, in_flight};
+
+        const auto submit_read = [&](const unsigned id) {
+            Slot &slot = slots[id];
+            io_uring_sqe *sqe = ring.next_sqe();
+            sqe->opcode = IORING_OP_READ;
+            sqe->fd = slot.fd;
+            sqe->addr = reinterpret_cast<uint64_t>(slot.loaded.data.data() + slot.done);
+            sqe->len = static_cast<uint32_t>(slot.loaded.data.size() - slot.done);
+            sqe->off = slot.done;
+            sqe->user_data = static_cast<uint64_t>(id) << 2 | STAGE_READ;
+            in_flight++;
+        };
+        // Hands the file to the workers, or its error unless loading was cancelled, and frees the slot.
+        const auto finish = [&](const unsigned id, const int error) {
+            Slot &slot = slots[id];
+            if (slot.fd >= 0) {
+                io_uring_sqe *sqe = ring.next_sqe();
+                sqe->opcode = IORING_OP_CLOSE;
+                sqe->fd = slot.fd;
+                sqe->user_data = STAGE_CLOSE;
+                in_flight++;
+            }
+            if (error == 0) {
+                slot.loaded.data.resize(slot.done);
+                queue.push(std::move(slot.loaded));
+            } else {
+                if (slot.reserved) {
+                    queue.release(slot.loaded.reserved, std::move(slot.loaded.data));
+                }
+                if (error != ECANCELED && queue.reserve(0)) {
+                    Loaded failed;
+                    failed.index = slot.loaded.index;
+                    failed.error = std::make_exception_ptr(load_error(paths[failed.index], error));
+                    queue.push(std::move(failed));
+                }
+            }
+            slot = Slot();
+            free_slots.push_back(id);
+        };
+        // Opened files wait here until the queue has room for them, so reads already in flight
+        // are never blocked behind a reservation.
+        const auto start_read = [&](const unsigned id, const bool block) {
+            Slot &slot = slots[id];
+            struct stat st{};
+            if (fstat(slot.fd, &st) != 0) {
+                finish(id, errno);
+                return;
+            }
+            const size_t size = static_cast<size_t>(st.st_size);
+            if (!(block ? queue.reserve(size) : queue.try_reserve(size))) {
+                if (block) {
+                    finish(id, ECANCELED);
+                } else {
+                    waiting.push_back(id);
+                }
+                return;
+            }
+            slot.reserved = true;
+            slot.loaded.reserved = size;
+            if (queue.is_cancelled()) {
+                finish(id, ECANCELED);
+                return;
+            }
+            slot.loaded.data = queue.take_buffer();
+            slot.loaded.data.resize(size);
+            if (size == 0) {
+                finish(id, 0);
+            } else {
+                submit_read(id);
+            }
+        };
+
+        while (true) {
+            const bool cancelled = queue.is_cancelled();
+            while (!cancelled && next < paths.size() && !free_slots.empty()) {
+                const unsigned id = free_slots.back();
+                free_slots.pop_back();
+                slots[id].loaded.index = next;
+                io_uring_sqe *sqe = ring.next_sqe();
+                sqe->opcode = IORING_OP_OPENAT;
+                sqe->fd = AT_FDCWD;
+                sqe->addr = reinterpret_cast<uint64_t>(paths[next]);
+                sqe->open_flags = O_RDONLY | O_CLOEXEC;
+                sqe->user_data = static_cast<uint64_t>(id) << 2 | STAGE_OPEN;
+                in_flight++;
+                next++;
+            }
+            if (in_flight == 0) {
+                if (waiting.empty()) break;
+                // Nothing else can free space from this thread, so wait for the workers.
+                const unsigned id = waiting.front();
+                waiting.erase(waiting.begin());
+                start_read(id, true);
+                continue;
+            }
+
+            ring.submit(1);
+            ring.reap([&](const uint64_t user_data, const int result) {
+                in_flight--;
+                const uint64_t stage = user_data & 3;
+                const unsigned id = static_cast<unsigned>(user_data >> 2);
+                if (stage == STAGE_CLOSE) {
+                    return;
+                }
+                Slot &slot = slots[id];
+                if (result < 0) {
+                    finish(id, -result);
+                } else if (stage == STAGE_OPEN) {
+                    slot.fd = result;
+                    if (queue.is_cancelled()) {
+                        finish(id, ECANCELED);
+                    } else {
+                        start_read(id, false);
+                    }
+                } else if (result == 0) {
+                    finish(id, 0);
+                } else {
+                    slot.done += static_cast<size_t>(result);
+                    if (slot.done < slot.loaded.data.size()) {
+                        submit_read(id);
+                    } else {
+                        finish(id, 0);
+                    }
+                }
+            });
+            const std::vector<unsigned> retry = std::move(waiting);
+            waiting.clear();
+            for (const unsigned id: retry) {
+                start_read(id, false);
+            }
+        }
+    }
+#endif
+}
+
+FileLoader::FileLoader(const Backend backend, const unsigned queue_depth, const size_t buffer_limit)
+    : backend(backend), queue_depth(std::max(1u, queue_depth)), buffer_limit(buffer_limit) {
+    if (backend == BACKEND_AUTO) {
+        this->backend = is_io_uring_available() ? BACKEND_IO_URING : BACKEND_THREADS;
+    }
+}
+
+bool FileLoader::is_io_uring_available() {
+#ifdef __linux__
+    static const bool available = [] {
+        try {
+            Ring ring(2);
+            return true;
+        } catch (const std::exception &) {
+            return false;
+        }
+    }();
+    return available;
+#else
+    return false;
+#endif
+}
+
+const char *FileLoader::backend_name(const Backend backend) {
+    switch (backend) {
+        case BACKEND_AUTO:
+            return "auto";
+        case BACKEND_IO_URING:
+            return "io_uring";
+        case BACKEND_THREADS:
+            return "threads";
+    }
+    return "unknown";
+}
+
+void FileLoader::run(const std::span<const char *const> paths, unsigned worker_count, const FileCallback &callback,
+                     const ErrorCallback &on_error) const {
+    worker_count = std::max(1u, worker_count);
+    LoadQueue queue(buffer_limit, static_cast<size_t>(queue_depth) * 4);
+
+    std::thread loader([&] {
+        try {
+            if (backend == BACKEND_IO_URING) {
+#ifdef __linux__
+                load_with_io_uring(paths, queue_depth, queue);
+#else
+                throw std::runtime_error("io_uring is only available on Linux");
+#endif
+            } else {
+                load_with_threads(paths, std::min(queue_depth, MAX_READER_THREADS), queue);
+            }
+        } catch (...) {
+            queue.cancel(std::current_exception());
+        }
+        queue.close();
+    });
+
+    const auto worker = [&](const unsigned self) {
+        Loaded loaded;
+        while (queue.pop(loaded)) {
+            try {
+                if (loaded.error) {
+                    try {
+                        std::rethrow_exception(loaded.error);
+                    } catch (const std::exception &e) {
+                        if (!on_error) throw;
+                        on_error(loaded.index, e);
+                    }
+                } else {
+                    callback(self, loaded.index, std::span<const uint8_t>(loaded.data));
+                }
+            } catch (...) {
+                queue.cancel(std::current_exception());
+            }
+            queue.release(loaded.reserved, std::move(loaded.data));
+            loaded = Loaded();
+        }
+    };
+
+    std::vector<std::thread> workers;
+    workers.reserve(worker_count - 1);
+    for (unsigned t = 1; t < worker_count; ++t) {
+        workers.emplace_back(worker, t);
+    }
+    worker(0);
+    for (auto &thread: workers) {
+        thread.join();
+    }
+    loader.join();
+
+    if (const std::exception_ptr error = queue.error()) {
+        std::rethrow_exception(error);
+    }
+}
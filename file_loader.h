@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <span>
+
+// Reads many small files ahead of the threads that consume them. With io_uring (Linux only) a single
+// loader thread keeps up to queue_depth opens and reads in flight; otherwise a pool of blocking reader
+// threads fills the same queue. Loaded and in-flight buffers together never exceed buffer_limit,
+// except that a single file larger than the limit is still read on its own.
+class FileLoader {
+public:
+    enum Backend {
+        BACKEND_AUTO,
+        BACKEND_IO_URING,
+        BACKEND_THREADS,
+    };
+
+    static constexpr unsigned DEFAULT_QUEUE_DEPTH = 64;
+    static constexpr size_t DEFAULT_BUFFER_LIMIT = 64 * 1024 * 1024;
+    static constexpr unsigned MAX_READER_THREADS = 32;
+
+    // Worker 0 is the thread that called run(). The data is only valid during the callback.
+    typedef std::function<void(unsigned worker, size_t index, std::span<const uint8_t> data)> FileCallback;
+    typedef std::function<void(size_t index, const std::exception &)> ErrorCallback;
+
+    explicit FileLoader(Backend backend = BACKEND_AUTO, unsigned queue_depth = DEFAULT_QUEUE_DEPTH,
+                        size_t buffer_limit = DEFAULT_BUFFER_LIMIT);
+
+    // BACKEND_AUTO resolves to io_uring on Linux when the kernel allows it.
+    Backend get_backend() const { return backend; }
+    unsigned get_queue_depth() const { return queue_depth; }
+    size_t get_buffer_limit() const { return buffer_limit; }
+
+    static bool is_io_uring_available();
+    static const char *backend_name(Backend backend);
+
+    // Files are handed out in completion order. Without an error callback the first failure, or an
+    // exception from the callback, stops loading and is rethrown once all threads have finished.
+    void run(std::span<const char *const> paths, unsigned worker_count, const FileCallback &callback,
+             const ErrorCallback &on_error = nullptr) const;
+
+private:
+    Backend backend;
+    unsigned queue_depth;
+    size_t buffer_limit;
+};
@@ -0,0 +1,329 @@
+#include "jar_reader.h"
+
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <limits>
+#include <memory_resource>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+#include <zlib.h>
+
+namespace {
+    constexpr uint32_t LOCAL_HEADER_SIGNATURE = 0x04034b50;
+    constexpr uint32_t CENTRAL_HEADER_SIGNATURE = 0x02014b50;
+    constexpr uint32_t END_OF_CENTRAL_DIR_SIGNATURE = 0x06054b50;
+    constexpr uint32_t ZIP64_END_OF_CENTRAL_DIR_SIGNATURE = 0x06064b50;
+    constexpr uint32_t ZIP64_LOCATOR_SIGNATURE = 0x07064b50;
+    constexpr uint16_t ZIP64_EXTRA_FIELD_ID = 0x0001;
+    constexpr uint16_t FLAG_ENCRYPTED = 0x0001;
+
+    constexpr size_t LOCAL_HEADER_SIZE = 30;
+    constexpr size_t CENTRAL_HEADER_SIZE = 46;
+    constexpr size_t END_OF_CENTRAL_DIR_SIZE = 22;
+    constexpr size_t ZIP64_LOCATOR_SIZE = 20;
+    constexpr size_t ZIP64_END_OF_CENTRAL_DIR_SIZE = 56;
+    constexpr size_t MAX_COMMENT_SIZE = 0xFFFF;
+    constexpr size_t WORKER_ARENA_SIZE = 256 * 1024;
+
+    uint16_t read_le16(const uint8_t *p) {
+        return static_cast<uint16_t>(p[0] | (p[1] << 8));
+    }
+
+    uint32_t read_le32(const uint8_t *p) {
+        return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+               (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+    }
+
+    uint64_t read_le64(const uint8_t *p) {
+        return static_cast<uint64_t>(read_le32(p)) | (static_cast<uint64_t>(read_le32(p + 4)) << 32);
+    }
+}
+
+bool JarReader::Entry::is_directory() const {
+    return !name.empty() && name.back() == '/';
+}
+
+bool JarReader::Entry::is_class() const {
+    return !is_directory() && name.size() > 6 && name.compare(name.size() - 6, 6, ".class") == 0;
+}
+
+bool JarReader::Entry::is_encrypted() const {
+    return flags & FLAG_ENCRYPTED;
+}
+
+std::string JarReader::Entry::to_string() const {
+    const std::string method_name = method == METHOD_STORED
+                                        ? "stored"
+                                        : method == METHOD_DEFLATED
+                                              ? "deflated"
+                                              : "method " + std::to_string(method);
+    std::ostringstream oss;
+    oss << name << " (" << method_name << ", " << compressed_size << " -> " << uncompressed_size << " bytes)";
+    return oss.str();
+}
+
+JarReader::JarReader(const std::string &filename) : filename(filename) {
+    if (!mapped_file.open(filename, MappedFile::ACCESS_SEQUENTIAL)) {
+        throw std::runtime_error("Failed to load file: " + filename);
+    }
+    read_central_directory();
+}
+
+void JarReader::read_central_directory() {
+    const uint8_t *data = mapped_file.data();
+    const size_t size = mapped_file.size();
+    if (size < END_OF_CENTRAL_DIR_SIZE) {
+        throw std::runtime_error("Not a zip archive: " + filename);
+    }
+
+    size_t eocd = std::string::npos;
+    const size_t search_end = size - END_OF_CENTRAL_DIR_SIZE;
+    const size_t search_start = search_end > MAX_COMMENT_SIZE ? search_end - MAX_COMMENT_SIZE : 0;
+    for (size_t pos = search_end + 1; pos-- > search_start;) {
+        if (read_le32(data + pos) == END_OF_CENTRAL_DIR_SIGNATURE) {
+            eocd = pos;
+            break;
+        }
+    }
+    if (eocd == std::string::npos) {
+        throw std::runtime_error("End of central directory not found: " + filename);
+    }
+
+    uint64_t entry_count = read_le16(data + eocd + 10);
+    uint64_t cd_size = read_le32(data + eocd + 12);
+    uint64_t cd_offset = read_le32(data + eocd + 16);
+
+    if (eocd >= ZIP64_LOCATOR_SIZE && read_le32(data + eocd - ZIP64_LOCATOR_SIZE) == ZIP64_LOCATOR_SIGNATURE) {
+        const uint64_t zip64_eocd = read_le64(data + eocd - ZIP64_LOCATOR_SIZE + 8);
+        if (size < ZIP64_END_OF_CENTRAL_DIR_SIZE || zip64_eocd > size - ZIP64_END_OF_CENTRAL_DIR_SIZE ||
+            read_le32(data + zip64_eocd) != ZIP64_END_OF_CENTRAL_DIR_SIGNATURE) {
+            throw std::runtime_error("Corrupt zip64 end of central directory: " + filename);
+        }
+        entry_count = read_le64(data + zip64_eocd + 32);
+        cd_size = read_le64(data + zip64_eocd + 40);
+        cd_offset = read_le64(data + zip64_eocd + 48);
+    }
+
+    if (cd_offset > size || cd_size > size - cd_offset) {
+        throw std::runtime_error("Central directory outside file boundaries: " + filename);
+    }
+
+    entries.clear();
+    entries.reserve(static_cast<size_t>(std::min<uint64_t>(entry_count, cd_size / CENTRAL_HEADER_SIZE)));
+
+    const uint8_t *p = data + cd_offset;
+    const uint8_t *end = p + cd_size;
+    for (uint64_t i = 0; i < entry_count; ++i) {
+        if (end - p < static_cast<ptrdiff_t>(CENTRAL_HEADER_SIZE) || read_le32(p) != CENTRAL_HEADER_SIGNATURE) {
+            throw std::runtime_error("Corrupt central directory entry #" + std::to_string(i) + ": " + filename);
+        }
+        const uint16_t name_length = read_le16(p + 28);
+        const uint16_t extra_length = read_le16(p + 30);
+        const uint16_t comment_length = read_le16(p + 32);
+        if (static_cast<size_t>(end - p) < CENTRAL_HEADER_SIZE + name_length + extra_length + comment_length) {
+            throw std::runtime_error("Central directory entry #" + std::to_string(i) +
+                                     " outside file boundaries: " + filename);
+        }
+
+        Entry entry;
+        entry.flags = read_le16(p + 8);
+        entry.method = read_le16(p + 10);
+        entry.crc32 = read_le32(p + 16);
+        entry.compressed_size = read_le32(p + 20);
+        entry.uncompressed_size = read_le32(p + 24);
+        entry.local_header_offset = read_le32(p + 42);
+        entry.name.assign(reinterpret_cast<const char *>(p + CENTRAL_HEADER_SIZE), name_length);
+
+        const uint8_t *extra = p + CENTRAL_HEADER_SIZE + name_length;
+        const uint8_t *extra_end = extra + extra_length;
+        while (extra_end - extra >= 4) {
+            const uint16_t id = read_le16(extra);
+            const uint16_t length = read_le16(extra + 2);
+            const uint8_t *field = extra + 4;
+            if (extra_end - field < length) break;
+            if (id == ZIP64_EXTRA_FIELD_ID) {
+                const uint8_t *field_end = field + length;
+                if (entry.uncompressed_size == 0xFFFFFFFF && field_end - field >= 8) {
+                    entry.uncompressed_size = read_le64(field);
+                    field += 8;
+                }
+                if (entry.compressed_size == 0xFFFFFFFF && field_end - field >= 8) {
+                    entry.compressed_size = read_le64(field);
+                    field += 8;
+                }
+                if (entry.local_header_offset == 0xFFFFFFFF && field_end - field >= 8) {
+                    entry.local_header_offset = read_le64(field);
+                }
+            }
+            extra += 4 + length;
+        }
+
+        entries.push_back(std::move(entry));
+        p += CENTRAL_HEADER_SIZE + name_length + extra_length + comment_length;
+    }
+
+    entry_index.clear();
+    entry_index.reserve(entries.size());
+    for (size_t i = 0; i < entries.size(); ++i) {
+        entry_index.emplace(entries[i].name, i);
+    }
+}
+
+const JarReader::Entry *JarReader::find_entry(const std::string_view name) const {
+    const auto it = entry_index.find(name);
+    return it == entry_index.end() ? nullptr : &entries[it->second];
+}
+
+std::span<const uint8_t> JarReader::get_raw_data(const Entry &entry) const {
+    const uint8_t *data = mapped_file.data();
+    const size_t size = mapped_file.size();
+    if (entry.local_header_offset > size || size - entry.local_header_offset < LOCAL_HEADER_SIZE ||
+        read_le32(data + entry.local_header_offset) != LOCAL_HEADER_SIGNATURE) {
+        throw std::runtime_error("Corrupt local header for " + entry.name);
+    }
+    const uint8_t *header = data + entry.local_header_offset;
+    const uint64_t data_offset = entry.local_header_offset + LOCAL_HEADER_SIZE +
+                                 read_le16(header + 26) + read_le16(header + 28);
+    if (data_offset > size || entry.compressed_size > size - data_offset) {
+        throw std::runtime_error("Entry data outside file boundaries: " + entry.name);
+    }
+    return {data + data_offset, static_cast<size_t>(entry.compressed_size)};
+}
+
+std::vector<uint8_t> JarReader::read_entry(const Entry &entry) const {
+    std::vector<uint8_t> result;
+    read_entry(entry, result);
+    return result;
+}
+
+// Reuses the capacity of out, so a caller reading many entries allocates only for the largest one.
+void JarReader::read_entry(const Entry &entry, std::vector<uint8_t> &out) const {
+    if (entry.is_encrypted()) {
+        throw std::runtime_error("Encrypted entries are not supported: " + entry.name);
+    }
+    const std::span<const uint8_t> raw = get_raw_data(entry);
+
+    if (entry.method == METHOD_STORED) {
+        verify_crc(entry, raw);
+        out.assign(raw.begin(), raw.end());
+        return;
+    }
+    if (entry.method != METHOD_DEFLATED) {
+        throw std::runtime_error("Unsupported compression method " + std::to_string(entry.method) +
+                                 " for " + entry.name);
+    }
+    if (raw.size() > std::numeric_limits<uInt>::max() ||
+        entry.uncompressed_size > std::numeric_limits<uInt>::max()) {
+        throw std::runtime_error("Entry too large to inflate: " + entry.name);
+    }
+
+    out.resize(static_cast<size_t>(entry.uncompressed_size));
+    z_stream stream{};
+    if (inflateInit2(&stream, -MAX_WBITS) != Z_OK) {
+        throw std::runtime_error("Failed to initialize inflater for " + entry.name);
+    }
+    stream.next_in = const_cast<Bytef *>(raw.data());
+    stream.avail_in = static_cast<uInt>(raw.size());
+    stream.next_out = out.data();
+    stream.avail_out = static_cast<uInt>(out.size());
+    const int status = inflate(&stream, Z_FINISH);
+    const uLong produced = stream.total_out;
+    inflateEnd(&stream);
+
+    if (status != Z_STREAM_END || produced != entry.uncompressed_size) {
+        throw std::runtime_error("Failed to inflate " + entry.name);
+    }
+    verify_crc(entry, out);
+}
+
+void JarReader::verify_crc(const Entry &entry, const std::span<const uint8_t> data) {
+    const uLong crc = crc32_z(crc32_z(0, Z_NULL, 0), data.data(), data.size());
+    if (crc != entry.crc32) {
+        std::ostringstream oss;
+        oss << "CRC-32 mismatch for " << entry.name << ": expected " << std::hex << entry.crc32 << ", got " << crc;
+        throw std::runtime_error(oss.str());
+    }
+}
+
+ClassParser JarReader::open_class(const Entry &entry, std::pmr::memory_resource *resource) const {
+    if (entry.method == METHOD_STORED && !entry.is_encrypted()) {
+        const std::span<const uint8_t> data = get_raw_data(entry);
+        verify_crc(entry, data);
+        return ClassParser(data, resource);
+    }
+    return ClassParser(read_entry(entry), resource);
+}
+
+void JarReader::parse_classes(const ClassCallback &callback, unsigned thread_count,
+                              const ErrorCallback &on_error) const {
+    std::vector<const Entry *> classes;
+    for (const Entry &entry: entries) {
+        if (entry.is_class()) {
+            classes.push_back(&entry);
+        }
+    }
+
+    if (thread_count == 0) {
+        thread_count = std::max(1u, std::thread::hardware_concurrency());
+    }
+    thread_count = static_cast<unsigned>(std::min<size_t>(thread_count, std::max<size_t>(1, classes.size())));
+
+    std::atomic<size_t> next{0};
+    std::atomic<bool> failed{false};
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    const auto record_error = [&] {
+        std::lock_guard lock(error_mutex);
+        if (!error) {
+            error = std::current_exception();
+        }
+        failed.store(true, std::memory_order_relaxed);
+    };
+
+    // Each worker parses into its own arena and rewinds it before the next class.
+    auto worker = [&] {
+        std::vector<std::byte> arena_buffer(WORKER_ARENA_SIZE);
+        std::pmr::monotonic_buffer_resource arena(arena_buffer.data(), arena_buffer.size());
+        while (!failed.load(std::memory_order_relaxed)) {
+            arena.release();
+            const size_t index = next.fetch_add(1, std::memory_order_relaxed);
+            if (index >= classes.size()) break;
+            try {
+                ClassParser parser = open_class(*classes[index], &arena);
+                parser.parse();
+                callback(*classes[index], parser);
+            } catch (const std::exception &e) {
+                if (!on_error) {
+                    record_error();
+                    continue;
+                }
+                // The lock serialises on_error; an exception from it stops the run like a parse error.
+                try {
+                    std::lock_guard lock(error_mutex);
+                    on_error(*classes[index], e);
+                } catch (...) {
+                    record_error();
+                }
+            } catch (...) {
+                record_error();
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    threads.reserve(thread_count - 1);
+    for (unsigned i = 1; i < thread_count; ++i) {
+        threads.emplace_back(worker);
+    }
+    worker();
+    for (auto &thread: threads) {
+        thread.join();
+    }
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory_resource>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "class_parser.h"
+#include "mapped_file.h"
+
+class JarReader {
+public:
+    enum {
+        METHOD_STORED = 0,
+        METHOD_DEFLATED = 8,
+    };
+
+    struct Entry {
+        std::string name;
+        uint16_t flags = 0;
+        uint16_t method = 0;
+        uint32_t crc32 = 0;
+        uint64_t compressed_size = 0;
+        uint64_t uncompressed_size = 0;
+        uint64_t local_header_offset = 0;
+
+        bool is_directory() const;
+        bool is_class() const;
+        bool is_encrypted() const;
+        std::string to_string() const;
+    };
+
+    typedef std::function<void(const Entry &, ClassParser &)> ClassCallback;
+    typedef std::function<void(const Entry &, const std::exception &)> ErrorCallback;
+
+    explicit JarReader(const std::string &filename);
+
+    const std::string &get_filename() const { return filename; }
+    const std::vector<Entry> &get_entries() const { return entries; }
+    const Entry *find_entry(std::string_view name) const;
+
+    // The entry's bytes as stored in the archive, compressed or not, without a CRC check.
+    std::span<const uint8_t> get_raw_data(const Entry &entry) const;
+    // Uncompressed contents, checked against the CRC-32 from the central directory.
+    std::vector<uint8_t> read_entry(const Entry &entry) const;
+    void read_entry(const Entry &entry, std::vector<uint8_t> &out) const;
+    // Throws when data does not match the entry's CRC-32; for callers that borrow stored entries.
+    static void verify_crc(const Entry &entry, std::span<const uint8_t> data);
+
+    // Parses every class entry on thread_count workers. callback runs concurrently on the workers
+    // and must be thread-safe; on_error calls are serialised. Without on_error, or if on_error
+    // throws, the first exception stops the workers and is rethrown on the calling thread.
+    void parse_classes(const ClassCallback &callback, unsigned thread_count = 0,
+                       const ErrorCallback &on_error = nullptr) const;
+
+private:
+    std::string filename;
+    MappedFile mapped_file;
+    std::vector<Entry> entries;
+    std::unordered_map<std::string_view, size_t> entry_index;
+
+    void read_central_directory();
+    ClassParser open_class(const Entry &entry, std::pmr::memory_resource *resource) const;
+};
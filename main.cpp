@@ -1,22 +1,66 @@
+#include <cstdlib>
 #include <iostream>
 #include <string>
 #include <filesystem>
-#include <sstream>
+#include <mutex>
+#include <vector>
 
+#include "batch_parser.h"
 #include "class_parser.h"
 
-int main(int argc, char *argv[]) {
-    const std::string filename = "D:\\AppProjects\\Test\\test\\out\\production\\test\\Main.class";
+static bool has_extension(const std::string &filename, const std::string &extension) {
+    return filename.size() >= extension.size() &&
+           filename.compare(filename.size() - extension.size(), extension.size(), extension) == 0;
+}
 
-    if (!std::filesystem::exists(filename)) {
-        std::cerr << "Class file not found: " << filename << std::endl;
+int main(int argc, char *argv[]) {
+    unsigned thread_count = 0;
+    std::vector<std::string> paths;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "-j" && i + 1 < argc) {
+            thread_count = static_cast<unsigned>(std::atoi(argv[++i]));
+        } else if (arg.rfind("-j", 0) == 0 && arg.size() > 2) {
+            thread_count = static_cast<unsigned>(std::atoi(arg.c_str() + 2));
+        } else {
+            paths.push_back(arg);
+        }
+    }
+    if (paths.empty()) {
+        std::cerr << "Usage: " << argv[0] << " [-j threads] <class-file|jar|directory>..." << std::endl;
         return 1;
     }
 
+    for (const auto &path: paths) {
+        if (!std::filesystem::exists(path)) {
+            std::cerr << "Path not found: " << path << std::endl;
+            return 1;
+        }
+    }
+
     try {
-        ClassParser parser(filename);
-        parser.parse();
-        parser.dump();
+        if (paths.size() == 1 && has_extension(paths[0], ".class")) {
+            ClassParser parser(paths[0], ClassParser::LOAD_MMAP);
+            parser.parse();
+            parser.dump();
+            return 0;
+        }
+
+        BatchParser batch(thread_count);
+        for (const auto &path: paths) {
+            batch.add(path);
+        }
+        std::mutex output_mutex;
+        const BatchParser::Stats stats = batch.run([&](const BatchParser::Item &item, ClassParser &parser) {
+            std::lock_guard lock(output_mutex);
+            std::cout << (item.entry != nullptr ? item.entry->name : item.path) << ": " << parser.get_class_name()
+                    << " extends " << parser.get_super_class_name() << " (" << parser.get_fields().size()
+                    << " fields, " << parser.get_methods().size() << " methods)" << std::endl;
+        }, [&](const BatchParser::Item &item, const std::exception &e) {
+            std::lock_guard lock(output_mutex);
+            std::cerr << "Error parsing " << item.to_string() << ": " << e.what() << std::endl;
+        });
+        std::cerr << stats.to_string() << std::endl;
     } catch (const std::runtime_error &e) {
         std::cerr << "Error execution: " << e.what() << std::endl;
         return 1;
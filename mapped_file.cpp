@@ -0,0 +1,127 @@
+#include "mapped_file.h"
+
+#include <utility>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(const std::string &filename, const AccessHint hint) {
+    open(filename, hint);
+}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+MappedFile::MappedFile(MappedFile &&other) noexcept
+    : mapping(std::exchange(other.mapping, nullptr)),
+      length(std::exchange(other.length, 0)),
+      opened(std::exchange(other.opened, false)) {
+}
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept {
+    if (this != &other) {
+        close();
+        mapping = std::exchange(other.mapping, nullptr);
+        length = std::exchange(other.length, 0);
+        opened = std::exchange(other.opened, false);
+    }
+    return *this;
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const std::string &filename, const AccessHint hint) {
+    close();
+    const DWORD flags = hint == ACCESS_SEQUENTIAL ? FILE_FLAG_SEQUENTIAL_SCAN : FILE_FLAG_RANDOM_ACCESS;
+    HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | flags, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size)) {
+        CloseHandle(file);
+        return false;
+    }
+    if (file_size.QuadPart == 0) {
+        CloseHandle(file);
+        opened = true;
+        return true;
+    }
+    HANDLE mapping_handle = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (mapping_handle == nullptr) {
+        return false;
+    }
+    void *view = MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping_handle);
+    if (view == nullptr) {
+        return false;
+    }
+    mapping = static_cast<const uint8_t *>(view);
+    length = static_cast<size_t>(file_size.QuadPart);
+    opened = true;
+    return true;
+}
+
+void MappedFile::close() {
+    if (mapping) {
+        UnmapViewOfFile(mapping);
+    }
+    mapping = nullptr;
+    length = 0;
+    opened = false;
+}
+
+#else
+
+bool MappedFile::open(const std::string &filename, const AccessHint hint) {
+    close();
+    const int fd = ::open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st {};
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        ::close(fd);
+        return false;
+    }
+    if (st.st_size == 0) {
+        ::close(fd);
+        opened = true;
+        return true;
+    }
+    void *view = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (view == MAP_FAILED) {
+        return false;
+    }
+    if (hint == ACCESS_SEQUENTIAL) {
+        madvise(view, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+        madvise(view, static_cast<size_t>(st.st_size), MADV_WILLNEED);
+    } else {
+        madvise(view, static_cast<size_t>(st.st_size), MADV_RANDOM);
+    }
+    mapping = static_cast<const uint8_t *>(view);
+    length = static_cast<size_t>(st.st_size);
+    opened = true;
+    return true;
+}
+
+void MappedFile::close() {
+    if (mapping) {
+        munmap(const_cast<uint8_t *>(mapping), length);
+    }
+    mapping = nullptr;
+    length = 0;
+    opened = false;
+}
+
+#endif
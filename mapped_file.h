@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+class MappedFile {
+public:
+    enum AccessHint {
+        ACCESS_SEQUENTIAL,
+        ACCESS_RANDOM,
+    };
+
+    MappedFile() = default;
+    explicit MappedFile(const std::string &filename, AccessHint hint = ACCESS_SEQUENTIAL);
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+    MappedFile(MappedFile &&other) noexcept;
+    MappedFile &operator=(MappedFile &&other) noexcept;
+
+    bool open(const std::string &filename, AccessHint hint = ACCESS_SEQUENTIAL);
+    void close();
+
+    bool is_open() const { return opened; }
+    const uint8_t *data() const { return mapping; }
+    size_t size() const { return length; }
+
+private:
+    const uint8_t *mapping = nullptr;
+    size_t length = 0;
+    bool opened = false;
+};
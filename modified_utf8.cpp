@@ -0,0 +1,236 @@
+#include "modified_utf8.h"
+
+#include <bit>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define MODIFIED_UTF8_X86 1
+#include <immintrin.h>
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define MODIFIED_UTF8_ALWAYS_INLINE inline __attribute__((always_inline))
+#elif defined(_MSC_VER)
+#define MODIFIED_UTF8_ALWAYS_INLINE __forceinline
+#else
+#define MODIFIED_UTF8_ALWAYS_INLINE inline
+#endif
+
+namespace {
+    typedef size_t (*AsciiPrefixKernel)(const uint8_t *, size_t);
+
+    constexpr uint64_t HIGH_BITS = 0x8080808080808080ULL;
+    constexpr uint64_t LOW_BITS = 0x0101010101010101ULL;
+
+    // Bit 7 of each byte is set for bytes that end an ASCII run: high-bit bytes and zero bytes.
+    // Zero detection can only misfire above a real stop byte, so the first set bit is exact.
+    MODIFIED_UTF8_ALWAYS_INLINE uint64_t stop_bits(const uint8_t *in) {
+        uint64_t word;
+        std::memcpy(&word, in, sizeof(word));
+        return (word | ((word - LOW_BITS) & ~word)) & HIGH_BITS;
+    }
+
+    MODIFIED_UTF8_ALWAYS_INLINE size_t first_stop_byte(const uint64_t stop) {
+        if constexpr (std::endian::native == std::endian::little) {
+            return std::countr_zero(stop) / 8;
+        } else {
+            return std::countl_zero(stop) / 8;
+        }
+    }
+
+    // Checks up to 15 bytes with two overlapping 8-byte words; shorter inputs go byte by byte.
+    MODIFIED_UTF8_ALWAYS_INLINE size_t ascii_prefix_short(const uint8_t *in, const size_t length) {
+        if (length >= 8) {
+            if (const uint64_t stop = stop_bits(in); stop != 0) {
+                return first_stop_byte(stop);
+            }
+            if (const uint64_t stop = stop_bits(in + length - 8); stop != 0) {
+                return length - 8 + first_stop_byte(stop);
+            }
+            return length;
+        }
+        size_t i = 0;
+        while (i < length && in[i] != 0 && (in[i] & 0x80) == 0) {
+            ++i;
+        }
+        return i;
+    }
+
+#ifndef MODIFIED_UTF8_X86
+    size_t ascii_prefix_scalar(const uint8_t *in, const size_t length) {
+        size_t i = 0;
+        for (; i + 8 <= length; i += 8) {
+            if (const uint64_t stop = stop_bits(in + i); stop != 0) {
+                return i + first_stop_byte(stop);
+            }
+        }
+        return i + ascii_prefix_short(in + i, length - i);
+    }
+#else
+    MODIFIED_UTF8_ALWAYS_INLINE unsigned stop_mask_16(const uint8_t *in) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in));
+        return static_cast<unsigned>(
+            _mm_movemask_epi8(chunk) | _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, _mm_setzero_si128())));
+    }
+
+    // Whole 16-byte blocks, then one overlapping block for the tail. Bytes the overlap re-reads
+    // were already checked, so the lowest stop bit is still the first stop byte.
+    MODIFIED_UTF8_ALWAYS_INLINE size_t ascii_prefix_16(const uint8_t *in, const size_t length) {
+        if (length < 16) {
+            return ascii_prefix_short(in, length);
+        }
+        size_t i = 0;
+        for (; i + 16 <= length; i += 16) {
+            if (const unsigned stop = stop_mask_16(in + i); stop != 0) {
+                return i + std::countr_zero(stop);
+            }
+        }
+        if (i < length) {
+            if (const unsigned stop = stop_mask_16(in + length - 16); stop != 0) {
+                return length - 16 + std::countr_zero(stop);
+            }
+        }
+        return length;
+    }
+
+    size_t ascii_prefix_sse2(const uint8_t *in, const size_t length) {
+        return ascii_prefix_16(in, length);
+    }
+
+#if defined(__GNUC__) || defined(__clang__)
+    // Stays entirely in VEX-encoded code and clears the upper YMM state before returning, so
+    // callers running legacy SSE code do not pay AVX/SSE transition penalties.
+    __attribute__((target("avx2")))
+    size_t ascii_prefix_avx2(const uint8_t *in, const size_t length) {
+        if (length < 32) {
+            return ascii_prefix_16(in, length);
+        }
+        const __m256i zero = _mm256_setzero_si256();
+        size_t result = length;
+        size_t i = 0;
+        for (; i + 32 <= length; i += 32) {
+            const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in + i));
+            const unsigned stop = static_cast<unsigned>(
+                _mm256_movemask_epi8(chunk) | _mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, zero)));
+            if (stop != 0) {
+                result = i + std::countr_zero(stop);
+                break;
+            }
+        }
+        if (result == length && i < length) {
+            const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(in + length - 32));
+            const unsigned stop = static_cast<unsigned>(
+                _mm256_movemask_epi8(chunk) | _mm256_movemask_epi8(_mm256_cmpeq_epi8(chunk, zero)));
+            if (stop != 0) {
+                result = length - 32 + std::countr_zero(stop);
+            }
+        }
+        _mm256_zeroupper();
+        return result;
+    }
+#endif
+#endif
+
+    struct KernelSelection {
+        AsciiPrefixKernel kernel;
+        const char *name;
+    };
+
+    KernelSelection select_kernel() {
+#ifdef MODIFIED_UTF8_X86
+#if defined(__GNUC__) || defined(__clang__)
+        if (__builtin_cpu_supports("avx2")) {
+            return {ascii_prefix_avx2, "avx2"};
+        }
+#endif
+        return {ascii_prefix_sse2, "sse2"};
+#else
+        return {ascii_prefix_scalar, "scalar"};
+#endif
+    }
+
+    const KernelSelection &selected_kernel() {
+        static const KernelSelection selection = select_kernel();
+        return selection;
+    }
+
+    size_t encode_utf8(const uint32_t code_point, char *out) {
+        if (code_point < 0x80) {
+            out[0] = static_cast<char>(code_point);
+            return 1;
+        }
+        if (code_point < 0x800) {
+            out[0] = static_cast<char>(0xC0 | (code_point >> 6));
+            out[1] = static_cast<char>(0x80 | (code_point & 0x3F));
+            return 2;
+        }
+        if (code_point < 0x10000) {
+            out[0] = static_cast<char>(0xE0 | (code_point >> 12));
+            out[1] = static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+            out[2] = static_cast<char>(0x80 | (code_point & 0x3F));
+            return 3;
+        }
+        out[0] = static_cast<char>(0xF0 | (code_point >> 18));
+        out[1] = static_cast<char>(0x80 | ((code_point >> 12) & 0x3F));
+        out[2] = static_cast<char>(0x80 | ((code_point >> 6) & 0x3F));
+        out[3] = static_cast<char>(0x80 | (code_point & 0x3F));
+        return 4;
+    }
+
+    bool is_continuation(const uint8_t b) {
+        return (b & 0xC0) == 0x80;
+    }
+
+    uint32_t decode_three_bytes(const uint8_t *in) {
+        return ((in[0] & 0x0F) << 12) | ((in[1] & 0x3F) << 6) | (in[2] & 0x3F);
+    }
+}
+
+size_t modified_utf8_ascii_prefix(const uint8_t *in, const size_t length) {
+    return selected_kernel().kernel(in, length);
+}
+
+const char *modified_utf8_kernel_name() {
+    return selected_kernel().name;
+}
+
+size_t modified_utf8_decode(const uint8_t *in, const size_t length, char *out) {
+    const AsciiPrefixKernel ascii_prefix = selected_kernel().kernel;
+    size_t i = 0;
+    size_t written = 0;
+
+    while (i < length) {
+        const size_t run = ascii_prefix(in + i, length - i);
+        std::memcpy(out + written, in + i, run);
+        i += run;
+        written += run;
+        if (i >= length) break;
+
+        const uint8_t b1 = in[i];
+        if (b1 == 0) {
+            out[written++] = '\0';
+            i += 1;
+        } else if ((b1 & 0xE0) == 0xC0 && i + 1 < length && is_continuation(in[i + 1])) {
+            const uint32_t code_point = ((b1 & 0x1F) << 6) | (in[i + 1] & 0x3F);
+            written += encode_utf8(code_point, out + written);
+            i += 2;
+        } else if ((b1 & 0xF0) == 0xE0 && i + 2 < length &&
+                   is_continuation(in[i + 1]) && is_continuation(in[i + 2])) {
+            uint32_t code_point = decode_three_bytes(in + i);
+            i += 3;
+            if (code_point >= 0xD800 && code_point <= 0xDBFF && i + 2 < length && in[i] == 0xED &&
+                is_continuation(in[i + 1]) && is_continuation(in[i + 2])) {
+                if (const uint32_t low = decode_three_bytes(in + i); low >= 0xDC00 && low <= 0xDFFF) {
+                    code_point = 0x10000 + ((code_point - 0xD800) << 10) + (low - 0xDC00);
+                    i += 3;
+                }
+            }
+            written += encode_utf8(code_point, out + written);
+        } else {
+            out[written++] = '?';
+            i += 1;
+        }
+    }
+
+    return written;
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Length of the leading run of bytes in [0x01, 0x7F], which decode to themselves.
+size_t modified_utf8_ascii_prefix(const uint8_t *in, size_t length);
+
+// Decodes JVM modified UTF-8 into standard UTF-8 and returns the number of bytes written.
+// The output is never longer than the input, so out must hold at least length bytes.
+size_t modified_utf8_decode(const uint8_t *in, size_t length, char *out);
+
+const char *modified_utf8_kernel_name();
@@ -0,0 +1,1800 @@
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "batch_parser.h"
+#include "bytecode.h"
+#include "class_file.h"
+#include "class_parser.h"
+#include "class_visitor.h"
+#include "control_flow_graph.h"
+#include "file_loader.h"
+#include "modified_utf8.h"
+#include "stack_map_table.h"
+#include "symbol_table.h"
+#include "virtual_machine.h"
+
+#if defined(__linux__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace {
+    std::atomic<size_t> allocation_count{0};
+    std::atomic<size_t> allocation_bytes{0};
+}
+
+// Kept out of line: once GCC inlines a replacement it sees free() paired with operator new at the
+// call site and reports -Wmismatched-new-delete.
+[[gnu::noinline]] void *operator new(const size_t size) {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    allocation_bytes.fetch_add(size, std::memory_order_relaxed);
+    if (void *p = std::malloc(size ? size : 1)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+[[gnu::noinline]] void operator delete(void *p) noexcept {
+    std::free(p);
+}
+
+[[gnu::noinline]] void operator delete(void *p, size_t) noexcept {
+    std::free(p);
+}
+
+[[gnu::noinline]] void *operator new(const size_t size, const std::align_val_t alignment) {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    allocation_bytes.fetch_add(size, std::memory_order_relaxed);
+    const size_t align = static_cast<size_t>(alignment);
+    if (void *p = std::aligned_alloc(align, (size + align - 1) / align * align)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+[[gnu::noinline]] void operator delete(void *p, std::align_val_t) noexcept {
+    std::free(p);
+}
+
+[[gnu::noinline]] void operator delete(void *p, size_t, std::align_val_t) noexcept {
+    std::free(p);
+}
+
+namespace {
+    struct Corpus {
+        std::vector<std::string> files;
+        size_t total_bytes = 0;
+    };
+
+    Corpus collect_corpus(const std::string &root) {
+        Corpus corpus;
+        if (std::filesystem::is_regular_file(root)) {
+            corpus.files.push_back(root);
+            corpus.total_bytes = std::filesystem::file_size(root);
+            return corpus;
+        }
+        for (const auto &entry: std::filesystem::recursive_directory_iterator(root)) {
+            if (entry.is_regular_file() && entry.path().extension() == ".class") {
+                corpus.files.push_back(entry.path().string());
+                corpus.total_bytes += entry.file_size();
+            }
+        }
+        return corpus;
+    }
+
+    std::vector<std::vector<uint8_t> > read_corpus(const Corpus &corpus) {
+        std::vector<std::vector<uint8_t> > buffers;
+        buffers.reserve(corpus.files.size());
+        for (const auto &file: corpus.files) {
+            std::ifstream in(file, std::ios::binary);
+            buffers.emplace_back(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        }
+        return buffers;
+    }
+
+    void report(const std::string &label, const size_t classes, const size_t bytes, const double seconds) {
+        std::cout << std::left << std::setw(28) << label << std::right << std::fixed << std::setprecision(3)
+                << std::setw(10) << seconds * 1000.0 << " ms"
+                << std::setw(14) << std::setprecision(0) << classes / seconds << " classes/s"
+                << std::setw(10) << std::setprecision(1) << bytes / seconds / (1024.0 * 1024.0) << " MB/s"
+                << std::endl;
+    }
+
+    template<typename Body>
+    double time_best_of(const int iterations, Body &&body) {
+        double best = 0;
+        for (int i = 0; i < iterations; ++i) {
+            const auto start = std::chrono::steady_clock::now();
+            body();
+            const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            if (i == 0 || elapsed.count() < best) {
+                best = elapsed.count();
+            }
+        }
+        return best;
+    }
+
+    size_t sink = 0;
+
+    void bench_load(const Corpus &corpus, const int iterations) {
+        for (const auto mode: {ClassParser::LOAD_STREAM, ClassParser::LOAD_MMAP}) {
+            const double seconds = time_best_of(iterations, [&] {
+                for (const auto &file: corpus.files) {
+                    ClassParser parser(file, mode);
+                    parser.parse();
+                    sink += parser.get_methods().size();
+                }
+            });
+            report(mode == ClassParser::LOAD_STREAM ? "load+parse (ifstream)" : "load+parse (mmap)",
+                   corpus.files.size(), corpus.total_bytes, seconds);
+        }
+
+        const auto buffers = read_corpus(corpus);
+        const double seconds = time_best_of(iterations, [&] {
+            for (const auto &buffer: buffers) {
+                ClassParser parser{std::span<const uint8_t>(buffer)};
+                parser.parse();
+                sink += parser.get_methods().size();
+            }
+        });
+        report("parse (in-memory span)", corpus.files.size(), corpus.total_bytes, seconds);
+    }
+
+    std::string to_modified_utf8(const std::string_view utf8) {
+        std::string result;
+        for (size_t i = 0; i < utf8.size(); ++i) {
+            const auto b = static_cast<uint8_t>(utf8[i]);
+            if (b == 0) {
+                result += "\xC0\x80";
+            } else if ((b & 0xF8) == 0xF0 && i + 3 < utf8.size()) {
+                const uint32_t code_point = ((b & 0x07) << 18) | ((utf8[i + 1] & 0x3F) << 12) |
+                                            ((utf8[i + 2] & 0x3F) << 6) | (utf8[i + 3] & 0x3F);
+                for (const uint32_t unit: {0xD800 + ((code_point - 0x10000) >> 10),
+                                           0xDC00 + ((code_point - 0x10000) & 0x3FF)}) {
+                    result += static_cast<char>(0xE0 | (unit >> 12));
+                    result += static_cast<char>(0x80 | ((unit >> 6) & 0x3F));
+                    result += static_cast<char>(0x80 | (unit & 0x3F));
+                }
+                i += 3;
+            } else {
+                result += static_cast<char>(b);
+            }
+        }
+        return result;
+    }
+
+    size_t decode_per_byte(const uint8_t *in, const size_t length, char *out) {
+        size_t written = 0;
+        for (size_t i = 0; i < length; ++i) {
+            if (const uint8_t b1 = in[i]; (b1 & 0x80) == 0) {
+                out[written++] = static_cast<char>(b1);
+            } else if ((b1 & 0xE0) == 0xC0 && i + 1 < length) {
+                out[written++] = static_cast<char>(((b1 & 0x1F) << 6) | (in[i + 1] & 0x3F));
+                i += 1;
+            } else if ((b1 & 0xF0) == 0xE0 && i + 2 < length) {
+                out[written++] = static_cast<char>(((b1 & 0x0F) << 12) | ((in[i + 1] & 0x3F) << 6) |
+                                                   (in[i + 2] & 0x3F));
+                i += 2;
+            } else {
+                out[written++] = '?';
+            }
+        }
+        return written;
+    }
+
+    void bench_decode(const Corpus &corpus, const int iterations) {
+        std::vector<std::string> strings;
+        size_t total_bytes = 0;
+        for (const auto &buffer: read_corpus(corpus)) {
+            ClassParser parser{std::span<const uint8_t>(buffer)};
+            parser.parse();
+            const ClassParser::ConstantPool &pool = parser.get_constant_pool();
+            for (uint16_t i = 1; i < pool.size(); ++i) {
+                if (pool.tag(i) == ClassParser::CONSTANT_Utf8) {
+                    strings.push_back(to_modified_utf8(pool.utf8(i)));
+                    total_bytes += strings.back().size();
+                }
+            }
+        }
+        std::cout << strings.size() << " Utf8 constants, average " << std::fixed << std::setprecision(1)
+                << static_cast<double>(total_bytes) / strings.size() << " bytes, kernel "
+                << modified_utf8_kernel_name() << std::endl;
+
+        std::vector<char> out(65536);
+        const auto run = [&](const std::string &label, size_t (*decode)(const uint8_t *, size_t, char *)) {
+            const double seconds = time_best_of(iterations, [&] {
+                for (const auto &str: strings) {
+                    sink += decode(reinterpret_cast<const uint8_t *>(str.data()), str.size(), out.data());
+                }
+            });
+            std::cout << std::left << std::setw(28) << label << std::right << std::setprecision(2)
+                    << std::setw(10) << seconds * 1e9 / strings.size() << " ns/string"
+                    << std::setw(10) << std::setprecision(1) << total_bytes / seconds / (1024.0 * 1024.0)
+                    << " MB/s" << std::endl;
+        };
+        run("per-byte decoder", decode_per_byte);
+        run("modified_utf8_decode", modified_utf8_decode);
+    }
+
+    void bench_utf8(const Corpus &corpus, const int iterations) {
+        const auto buffers = read_corpus(corpus);
+
+        for (const auto options: {ClassParser::PARSE_DEFAULT, ClassParser::PARSE_LAZY_UTF8}) {
+            const std::string mode = options == ClassParser::PARSE_DEFAULT ? "eager" : "lazy";
+
+            const size_t allocations_before = allocation_count.load();
+            const double parse_seconds = time_best_of(iterations, [&] {
+                for (const auto &buffer: buffers) {
+                    ClassParser parser{std::span<const uint8_t>(buffer)};
+                    parser.parse(options);
+                    sink += parser.get_constant_pool().size();
+                }
+            });
+            const size_t allocations = allocation_count.load() - allocations_before;
+            report("parse (" + mode + " utf8)", corpus.files.size(), corpus.total_bytes, parse_seconds);
+            std::cout << "  allocations per class: " << allocations / iterations / buffers.size() << std::endl;
+
+            const double access_seconds = time_best_of(iterations, [&] {
+                for (const auto &buffer: buffers) {
+                    ClassParser parser{std::span<const uint8_t>(buffer)};
+                    parser.parse(options);
+                    const ClassParser::ConstantPool &pool = parser.get_constant_pool();
+                    for (uint16_t i = 1; i < pool.size(); ++i) {
+                        if (pool.tag(i) == ClassParser::CONSTANT_Utf8) {
+                            sink += pool.utf8(i).size();
+                        }
+                    }
+                }
+            });
+            report("parse+read all (" + mode + ")", corpus.files.size(), corpus.total_bytes, access_seconds);
+        }
+    }
+
+    void bench_attributes(const Corpus &corpus, const int iterations) {
+        const auto buffers = read_corpus(corpus);
+
+        for (const auto options: {ClassParser::PARSE_DEFAULT, ClassParser::PARSE_BORROW_ATTRIBUTES}) {
+            const size_t allocations_before = allocation_count.load();
+            const size_t bytes_before = allocation_bytes.load();
+            const double seconds = time_best_of(iterations, [&] {
+                for (const auto &buffer: buffers) {
+                    ClassParser parser{std::span<const uint8_t>(buffer)};
+                    parser.parse(options);
+                    for (const auto &method: parser.get_methods()) {
+                        if (method.code_attribute) {
+                            sink += method.code_attribute->bytecode().size();
+                        }
+                    }
+                }
+            });
+            const size_t runs = iterations * buffers.size();
+            report(options == ClassParser::PARSE_DEFAULT ? "parse (copied attributes)" : "parse (borrowed attributes)",
+                   corpus.files.size(), corpus.total_bytes, seconds);
+            std::cout << "  allocations per class: " << (allocation_count.load() - allocations_before) / runs
+                    << ", allocated KB per class: " << std::setprecision(1)
+                    << (allocation_bytes.load() - bytes_before) / 1024.0 / runs << std::endl;
+        }
+
+        const auto decode_all = [](const ClassParser &parser, const auto &attributes) {
+            for (const auto &attribute: attributes) {
+                sink += parser.decode_attribute(attribute).type;
+            }
+        };
+        const size_t allocations_before = allocation_count.load();
+        const size_t bytes_before = allocation_bytes.load();
+        const double seconds = time_best_of(iterations, [&] {
+            for (const auto &buffer: buffers) {
+                ClassParser parser{std::span<const uint8_t>(buffer)};
+                parser.parse(ClassParser::PARSE_BORROW_ATTRIBUTES);
+                decode_all(parser, parser.get_class_attributes());
+                for (const auto &field: parser.get_fields()) {
+                    decode_all(parser, field.attributes);
+                }
+                for (const auto &method: parser.get_methods()) {
+                    decode_all(parser, method.attributes);
+                    if (method.code_attribute) {
+                        decode_all(parser, method.code_attribute->attributes);
+                    }
+                }
+            }
+        });
+        const size_t runs = iterations * buffers.size();
+        report("parse+decode all (borrowed)", corpus.files.size(), corpus.total_bytes, seconds);
+        std::cout << "  allocations per class: " << (allocation_count.load() - allocations_before) / runs
+                << ", allocated KB per class: " << std::setprecision(1)
+                << (allocation_bytes.load() - bytes_before) / 1024.0 / runs
+                << ", sizeof(SpecializedAttribute): " << sizeof(ClassParser::SpecializedAttribute) << std::endl;
+    }
+
+    void bench_options(const Corpus &corpus, const int iterations) {
+        const auto buffers = read_corpus(corpus);
+        const std::vector<std::pair<std::string, ClassParser::ParseOptions> > masks = {
+            {"default", ClassParser::PARSE_DEFAULT},
+            {"skip code", ClassParser::PARSE_SKIP_CODE},
+            {"skip debug", ClassParser::PARSE_SKIP_DEBUG},
+            {"skip frames", ClassParser::PARSE_SKIP_FRAMES},
+            {"skip annotations", ClassParser::PARSE_SKIP_ANNOTATIONS},
+            {"skip fields", ClassParser::PARSE_SKIP_FIELDS},
+            {"skip methods", ClassParser::PARSE_SKIP_METHODS},
+            {"skip code+debug+annotations", ClassParser::PARSE_SKIP_CODE | ClassParser::PARSE_SKIP_DEBUG |
+                                            ClassParser::PARSE_SKIP_ANNOTATIONS},
+        };
+
+        double baseline = 0;
+        for (const auto &[label, options]: masks) {
+            const double seconds = time_best_of(iterations, [&] {
+                for (const auto &buffer: buffers) {
+                    ClassParser parser{std::span<const uint8_t>(buffer)};
+                    parser.parse(options);
+                    sink += parser.get_methods().size();
+                }
+            });
+            if (options == ClassParser::PARSE_DEFAULT) {
+                baseline = seconds;
+            }
+            report(label, corpus.files.size(), corpus.total_bytes, seconds);
+            std::cout << "  speedup: " << std::setprecision(2) << baseline / seconds << "x" << std::endl;
+        }
+    }
+
+    void bench_scan(const Corpus &corpus, const int iterations) {
+        const auto buffers = read_corpus(corpus);
+
+        const double parse_seconds = time_best_of(iterations, [&] {
+            for (const auto &buffer: buffers) {
+                ClassParser parser{std::span<const uint8_t>(buffer)};
+                parser.parse();
+                sink += parser.get_class_name().size();
+            }
+        });
+        report("full parse (memory)", corpus.files.size(), corpus.total_bytes, parse_seconds);
+
+        const double scan_seconds = time_best_of(iterations, [&] {
+            for (const auto &buffer: buffers) {
+                sink += ClassParser::scan_header(std::span<const uint8_t>(buffer)).class_name.size();
+            }
+        });
+        report("scan_header (memory)", corpus.files.size(), corpus.total_bytes, scan_seconds);
+
+        const double file_seconds = time_best_of(iterations, [&] {
+            for (const auto &file: corpus.files) {
+                sink += ClassParser::scan_header(file).class_name.size();
+            }
+        });
+        report("scan_header (mmap files)", corpus.files.size(), corpus.total_bytes, file_seconds);
+    }
+
+    class BytecodeCounter : public ClassVisitor {
+    public:
+        size_t methods = 0;
+        size_t bytecode_bytes = 0;
+
+        Action visit_method(uint16_t /*access_flags*/, std::string_view /*name*/, std::string_view /*descriptor*/) override {
+            ++methods;
+            return CONTINUE;
+        }
+
+        Action visit_code(uint16_t /*max_stack*/, uint16_t /*max_locals*/, std::span<const uint8_t> code) override {
+            bytecode_bytes += code.size();
+            return SKIP;
+        }
+    };
+
+    void bench_visitor(const Corpus &corpus, const int iterations) {
+        const auto buffers = read_corpus(corpus);
+        const auto run = [&](const std::string &label, const auto &body) {
+            const size_t allocations_before = allocation_count.load();
+            const double seconds = time_best_of(iterations, [&] {
+                for (const auto &buffer: buffers) {
+                    body(buffer);
+                }
+            });
+            report(label, corpus.files.size(), corpus.total_bytes, seconds);
+            std::cout << "  allocations per class: "
+                    << (allocation_count.load() - allocations_before) / iterations / buffers.size() << std::endl;
+        };
+
+        run("object model (bytecode)", [&](const std::vector<uint8_t> &buffer) {
+            ClassParser parser{std::span<const uint8_t>(buffer)};
+            parser.parse(ClassParser::PARSE_LAZY_UTF8 | ClassParser::PARSE_BORROW_ATTRIBUTES);
+            for (const auto &method: parser.get_methods()) {
+                if (method.code_attribute) {
+                    sink += method.code_attribute->bytecode().size();
+                }
+            }
+        });
+        run("visitor (bytecode)", [&](const std::vector<uint8_t> &buffer) {
+            ClassParser parser{std::span<const uint8_t>(buffer)};
+            BytecodeCounter counter;
+            parser.parse(counter, ClassParser::PARSE_LAZY_UTF8);
+            sink += counter.bytecode_bytes;
+        });
+    }
+
+    const ClassParser::MethodInfo *linear_find_method(const ClassParser &parser, const std::string &name,
+                                                      const std::string &descriptor) {
+        for (const auto &method: parser.get_methods()) {
+            if (method.name == name && method.descriptor == descriptor) {
+                return &method;
+            }
+        }
+        return nullptr;
+    }
+
+    const ClassParser::FieldInfo *linear_find_field(const ClassParser &parser, const std::string &name,
+                                                    const std::string &descriptor) {
+        for (const auto &field: parser.get_fields()) {
+            if (field.name == name && field.descriptor == descriptor) {
+                return &field;
+            }
+        }
+        return nullptr;
+    }
+
+    void bench_lookup(const Corpus &corpus, const int iterations) {
+        const auto buffers = read_corpus(corpus);
+
+        for (const size_t min_members: {size_t{0}, size_t{64}}) {
+            size_t classes = 0;
+            size_t lookups = 0;
+            double linear_seconds = 0;
+            double index_seconds = 0;
+            double build_seconds = 0;
+            for (const auto &buffer: buffers) {
+                ClassParser parser{std::span<const uint8_t>(buffer)};
+                parser.parse(ClassParser::PARSE_SKIP_CODE | ClassParser::PARSE_SKIP_DEBUG);
+                if (parser.get_methods().size() + parser.get_fields().size() < min_members) {
+                    continue;
+                }
+                std::vector<std::pair<std::string, std::string> > method_keys;
+                std::vector<std::pair<std::string, std::string> > field_keys;
+                for (const auto &method: parser.get_methods()) {
+                    method_keys.emplace_back(method.name, method.descriptor);
+                }
+                for (const auto &field: parser.get_fields()) {
+                    field_keys.emplace_back(field.name, field.descriptor);
+                }
+                ++classes;
+                lookups += method_keys.size() + field_keys.size();
+
+                linear_seconds += time_best_of(iterations, [&] {
+                    for (const auto &[name, descriptor]: method_keys) {
+                        sink += linear_find_method(parser, name, descriptor) != nullptr;
+                    }
+                    for (const auto &[name, descriptor]: field_keys) {
+                        sink += linear_find_field(parser, name, descriptor) != nullptr;
+                    }
+                });
+                build_seconds += time_best_of(1, [&] {
+                    sink += parser.find_method("<init>") != nullptr;
+                    sink += parser.find_field("") != nullptr;
+                });
+                index_seconds += time_best_of(iterations, [&] {
+                    for (const auto &[name, descriptor]: method_keys) {
+                        sink += parser.find_method(name, descriptor) != nullptr;
+                    }
+                    for (const auto &[name, descriptor]: field_keys) {
+                        sink += parser.find_field(name, descriptor) != nullptr;
+                    }
+                });
+            }
+            std::cout << "classes with >= " << min_members << " members: " << classes << ", "
+                    << lookups << " lookups" << std::fixed << std::setprecision(1) << "\n"
+                    << "  linear scan:  " << linear_seconds * 1e9 / lookups << " ns per lookup\n"
+                    << "  hash index:   " << index_seconds * 1e9 / lookups << " ns per lookup, "
+                    << build_seconds * 1e9 / lookups << " ns per member to build" << std::endl;
+        }
+    }
+
+    void bench_symbols(const Corpus &corpus, const int iterations) {
+        const auto buffers = read_corpus(corpus);
+
+        for (const bool interned: {false, true}) {
+            const double seconds = time_best_of(iterations, [&] {
+                SymbolTable symbols;
+                for (const auto &buffer: buffers) {
+                    ClassParser parser{std::span<const uint8_t>(buffer)};
+                    if (interned) {
+                        parser.set_symbol_table(&symbols);
+                    }
+                    parser.parse(ClassParser::PARSE_SKIP_CODE | ClassParser::PARSE_SKIP_DEBUG);
+                    sink += parser.get_methods().size();
+                }
+            });
+            report(interned ? "parse (interned members)" : "parse", corpus.files.size(), corpus.total_bytes, seconds);
+        }
+
+        SymbolTable symbols;
+        std::vector<std::string> names;
+        size_t members = 0;
+        size_t copied_bytes = 0;
+        for (const auto &buffer: buffers) {
+            ClassParser parser{std::span<const uint8_t>(buffer)};
+            parser.set_symbol_table(&symbols);
+            parser.parse(ClassParser::PARSE_SKIP_CODE | ClassParser::PARSE_SKIP_DEBUG);
+            const auto add = [&](const std::string_view name, const std::string_view descriptor) {
+                ++members;
+                for (const std::string_view text: {name, descriptor}) {
+                    copied_bytes += sizeof(std::string) + (text.size() > 15 ? text.size() + 1 : 0);
+                    names.emplace_back(text);
+                }
+            };
+            for (const auto &method: parser.get_methods()) {
+                add(method.name, method.descriptor);
+            }
+            for (const auto &field: parser.get_fields()) {
+                add(field.name, field.descriptor);
+            }
+        }
+        std::cout << members << " members, " << symbols.size() << " distinct symbols\n" << std::fixed
+                << std::setprecision(1)
+                << "  std::string copies (old layout): " << copied_bytes / 1024.0 << " KB\n"
+                << "  symbol ids + shared table:       " << (members * 2 * sizeof(SymbolTable::Symbol) + symbols.memory_usage()) /
+                1024.0 << " KB" << std::endl;
+
+        for (const unsigned threads: {1u, std::max(2u, std::thread::hardware_concurrency())}) {
+            const double seconds = time_best_of(iterations, [&] {
+                std::vector<std::thread> workers;
+                std::vector<size_t> results(threads);
+                for (unsigned t = 0; t < threads; ++t) {
+                    workers.emplace_back([&, t] {
+                        for (size_t i = t; i < names.size(); i += threads) {
+                            results[t] += symbols.intern(names[i]);
+                        }
+                    });
+                }
+                for (unsigned t = 0; t < threads; ++t) {
+                    workers[t].join();
+                    sink += results[t];
+                }
+            });
+            std::cout << "  intern (" << threads << " threads): " << std::setprecision(1)
+                    << seconds * 1e9 / names.size() << " ns per string" << std::endl;
+        }
+    }
+
+    void bench_shared(const Corpus &corpus, const int iterations) {
+        const auto buffers = read_corpus(corpus);
+
+        const double parse_seconds = time_best_of(iterations, [&] {
+            for (const auto &buffer: buffers) {
+                ClassParser parser{std::span<const uint8_t>(buffer)};
+                parser.parse(ClassParser::PARSE_LAZY_UTF8);
+                sink += parser.get_methods().size();
+            }
+        });
+        report("ClassParser::parse", corpus.files.size(), corpus.total_bytes, parse_seconds);
+
+        std::vector<std::shared_ptr<const ClassFile> > classes;
+        const double build_seconds = time_best_of(iterations, [&] {
+            classes.clear();
+            for (const auto &buffer: buffers) {
+                classes.push_back(ClassFile::parse(std::span<const uint8_t>(buffer), ClassParser::PARSE_LAZY_UTF8));
+            }
+        });
+        report("ClassFile::parse (frozen)", corpus.files.size(), corpus.total_bytes, build_seconds);
+
+        // Every thread walks every class, so the reads overlap on the same shared objects.
+        size_t reads = 0;
+        for (const auto &cls: classes) {
+            for (const auto &method: cls->get_methods()) {
+                reads += 1 + method.attributes.size();
+            }
+        }
+        for (const unsigned threads: {1u, std::max(2u, std::thread::hardware_concurrency())}) {
+            const double seconds = time_best_of(iterations, [&] {
+                std::vector<std::thread> workers;
+                std::vector<size_t> results(threads);
+                for (unsigned t = 0; t < threads; ++t) {
+                    workers.emplace_back([&, t] {
+                        for (const auto &cls: classes) {
+                            for (const auto &method: cls->get_methods()) {
+                                results[t] += cls->find_method(method.name, method.descriptor) == &method;
+                                for (const auto &attribute: method.attributes) {
+                                    results[t] += cls->decode_attribute(attribute).length;
+                                }
+                            }
+                        }
+                    });
+                }
+                for (unsigned t = 0; t < threads; ++t) {
+                    workers[t].join();
+                    sink += results[t];
+                }
+            });
+            std::cout << "  shared reads (" << threads << " threads): " << std::fixed << std::setprecision(1)
+                    << seconds * 1e9 / (reads * threads) << " ns per read" << std::endl;
+        }
+    }
+
+    void bench_arena(const Corpus &corpus, const int iterations) {
+        const auto buffers = read_corpus(corpus);
+        std::vector<std::byte> arena_buffer(256 * 1024);
+        std::pmr::monotonic_buffer_resource arena(arena_buffer.data(), arena_buffer.size());
+
+        for (const bool use_arena: {false, true}) {
+            std::pmr::memory_resource *resource = use_arena ? &arena : std::pmr::get_default_resource();
+            const size_t allocations_before = allocation_count.load();
+            const double seconds = time_best_of(iterations, [&] {
+                for (const auto &buffer: buffers) {
+                    {
+                        ClassParser parser{std::span<const uint8_t>(buffer), resource};
+                        parser.parse();
+                        for (const auto &method: parser.get_methods()) {
+                            if (method.code_attribute) {
+                                sink += method.code_attribute->bytecode().size();
+                            }
+                        }
+                    }
+                    arena.release();
+                }
+            });
+            report(use_arena ? "parse (arena per class)" : "parse (default heap)",
+                   corpus.files.size(), corpus.total_bytes, seconds);
+            std::cout << "  heap allocations per class: "
+                    << (allocation_count.load() - allocations_before) / iterations / buffers.size() << std::endl;
+        }
+    }
+
+    void bench_reuse(const Corpus &corpus, const int iterations) {
+        const auto buffers = read_corpus(corpus);
+        std::pmr::unsynchronized_pool_resource pool;
+
+        const auto run = [&](const std::string &label, const auto &body) {
+            body();
+            const size_t allocations_before = allocation_count.load();
+            const double seconds = time_best_of(iterations, body);
+            report(label, corpus.files.size(), corpus.total_bytes, seconds);
+            std::cout << "  heap allocations per class: "
+                    << (allocation_count.load() - allocations_before) / iterations / buffers.size() << std::endl;
+        };
+
+        run("fresh parser per class", [&] {
+            for (const auto &buffer: buffers) {
+                ClassParser parser{std::span<const uint8_t>(buffer)};
+                parser.parse(ClassParser::PARSE_BORROW_ATTRIBUTES);
+                sink += parser.get_methods().size();
+            }
+        });
+        ClassParser reused;
+        run("reused parser", [&] {
+            for (const auto &buffer: buffers) {
+                reused.parse(std::span<const uint8_t>(buffer), ClassParser::PARSE_BORROW_ATTRIBUTES);
+                sink += reused.get_methods().size();
+            }
+        });
+        ClassParser pooled(&pool);
+        run("reused parser + pool", [&] {
+            for (const auto &buffer: buffers) {
+                pooled.parse(std::span<const uint8_t>(buffer), ClassParser::PARSE_BORROW_ATTRIBUTES);
+                sink += pooled.get_methods().size();
+            }
+        });
+    }
+
+#if defined(__linux__)
+    // Drops the corpus from the page cache and returns the fraction of its pages still resident.
+    double evict_page_cache(const Corpus &corpus) {
+        size_t pages = 0;
+        size_t resident = 0;
+        const size_t page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+        for (const auto &file: corpus.files) {
+            const int fd = open(file.c_str(), O_RDONLY);
+            if (fd < 0) continue;
+            posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+            const size_t size = static_cast<size_t>(lseek(fd, 0, SEEK_END));
+            if (size != 0) {
+                void *mapping = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+                if (mapping != MAP_FAILED) {
+                    std::vector<unsigned char> vec((size + page_size - 1) / page_size);
+                    if (mincore(mapping, size, vec.data()) == 0) {
+                        pages += vec.size();
+                        resident += static_cast<size_t>(std::count_if(vec.begin(), vec.end(),
+                                                                      [](const unsigned char v) { return v & 1; }));
+                    }
+                    munmap(mapping, size);
+                }
+            }
+            close(fd);
+        }
+        return pages != 0 ? static_cast<double>(resident) / pages : 0;
+    }
+#endif
+
+    void bench_async_load(const Corpus &corpus, const int iterations) {
+        BatchParser batch;
+        for (const auto &file: corpus.files) {
+            batch.add(file);
+        }
+        const unsigned threads = std::max(2u, std::thread::hardware_concurrency());
+        batch.set_thread_count(threads);
+        const FileLoader uring(FileLoader::BACKEND_IO_URING);
+        const FileLoader pool(FileLoader::BACKEND_THREADS);
+
+        struct Loader {
+            std::string label;
+            const FileLoader *loader;
+        };
+        std::vector<Loader> loaders = {{"per-worker read", nullptr}, {"loader (threads)", &pool}};
+        if (FileLoader::is_io_uring_available()) {
+            loaders.push_back({"loader (io_uring)", &uring});
+        } else {
+            std::cout << "io_uring unavailable, skipping" << std::endl;
+        }
+
+#if defined(__linux__)
+        const std::vector<bool> page_cache_states = {true, false};
+#else
+        std::cout << "page cache eviction needs Linux, skipping the cold run" << std::endl;
+        const std::vector<bool> page_cache_states = {false};
+#endif
+        for (const bool cold: page_cache_states) {
+            std::cout << (cold ? "cold page cache" : "warm page cache") << ", " << threads << " workers" << std::endl;
+            for (const auto &[label, loader]: loaders) {
+                batch.set_file_loader(loader);
+                double resident = 0;
+                BatchParser::Stats best;
+                for (int i = 0; i < iterations; ++i) {
+#if defined(__linux__)
+                    if (cold) {
+                        resident = std::max(resident, evict_page_cache(corpus));
+                    }
+#endif
+                    const BatchParser::Stats stats = batch.run([&](const BatchParser::Item &, ClassParser &parser) {
+                        sink += parser.get_methods().size();
+                    });
+                    if (i == 0 || stats.seconds < best.seconds) {
+                        best = stats;
+                    }
+                }
+                report("  " + label, best.classes, best.bytes, best.seconds);
+                if (cold && resident > 0.01) {
+                    std::cout << "  warning: " << std::setprecision(0) << resident * 100
+                            << "% of pages stayed cached" << std::endl;
+                }
+            }
+        }
+    }
+
+    // A jar passed as the corpus is expanded into its classes; throughput uses the inflated sizes.
+    void bench_batch(const Corpus &corpus, const int iterations) {
+        BatchParser batch;
+        for (const auto &file: corpus.files) {
+            batch.add(file);
+        }
+        const unsigned max_threads = std::max(2u, std::thread::hardware_concurrency());
+        std::vector<unsigned> thread_counts;
+        for (unsigned threads = 1; threads < max_threads; threads *= 2) {
+            thread_counts.push_back(threads);
+        }
+        thread_counts.push_back(max_threads);
+
+        double single_thread = 0;
+        for (const unsigned threads: thread_counts) {
+            batch.set_thread_count(threads);
+            std::atomic<size_t> methods{0};
+            BatchParser::Stats best;
+            for (int i = 0; i < iterations; ++i) {
+                const BatchParser::Stats stats = batch.run([&](const BatchParser::Item &, ClassParser &parser) {
+                    methods.fetch_add(parser.get_methods().size(), std::memory_order_relaxed);
+                });
+                if (i == 0 || stats.seconds < best.seconds) {
+                    best = stats;
+                }
+            }
+            sink += methods.load();
+            if (threads == 1) {
+                single_thread = best.seconds;
+            }
+            report(std::to_string(best.threads) + " threads", best.classes, best.bytes, best.seconds);
+            std::cout << "  speedup: " << std::fixed << std::setprecision(2) << single_thread / best.seconds
+                    << "x" << std::endl;
+        }
+    }
+
+    void bench_constant_pool(const Corpus &corpus, const int iterations) {
+        const auto buffers = read_corpus(corpus);
+
+        const size_t allocations_before = allocation_count.load();
+        const double parse_seconds = time_best_of(iterations, [&] {
+            for (const auto &buffer: buffers) {
+                ClassParser parser{std::span<const uint8_t>(buffer)};
+                parser.parse();
+                sink += parser.get_constant_pool().size();
+            }
+        });
+        const size_t allocations = allocation_count.load() - allocations_before;
+        report("parse", corpus.files.size(), corpus.total_bytes, parse_seconds);
+        std::cout << "allocations per class: " << allocations / iterations / buffers.size() << std::endl;
+
+        size_t lookups = 0;
+        double lookup_seconds = 0;
+        double view_seconds = 0;
+        for (const auto &buffer: buffers) {
+            ClassParser parser{std::span<const uint8_t>(buffer)};
+            parser.parse();
+            const ClassParser::ConstantPool &pool = parser.get_constant_pool();
+            lookup_seconds += time_best_of(iterations, [&] {
+                for (uint16_t i = 1; i < pool.size(); ++i) {
+                    if (pool.tag(i) == ClassParser::CONSTANT_Class) {
+                        sink += parser.get_class_name(i).size();
+                    } else if (pool.tag(i) == ClassParser::CONSTANT_Utf8) {
+                        sink += parser.get_utf8_string(i).size();
+                    }
+                }
+            });
+            view_seconds += time_best_of(iterations, [&] {
+                for (uint16_t i = 1; i < pool.size(); ++i) {
+                    if (pool.tag(i) == ClassParser::CONSTANT_Class) {
+                        sink += pool.utf8(pool.index1(i)).size();
+                    } else if (pool.tag(i) == ClassParser::CONSTANT_Utf8) {
+                        sink += pool.utf8(i).size();
+                    }
+                }
+            });
+            for (uint16_t i = 1; i < pool.size(); ++i) {
+                lookups += pool.tag(i) == ClassParser::CONSTANT_Class || pool.tag(i) == ClassParser::CONSTANT_Utf8;
+            }
+        }
+        std::cout << std::fixed << std::setprecision(1)
+                << "get_class_name/get_utf8_string: " << lookup_seconds * 1e9 / lookups << " ns per lookup\n"
+                << "ConstantPool::utf8 views:       " << view_seconds * 1e9 / lookups << " ns per lookup" << std::endl;
+    }
+
+    // Basic blocks the way analyses used to build them: ordered sets and maps keyed by pc.
+    size_t naive_control_flow_graph(const ClassParser::CodeAttribute &code) {
+        const Bytecode bytecode(code);
+        std::set<uint32_t> leaders{0};
+        std::map<uint32_t, std::vector<uint32_t> > targets;
+        for (const Bytecode::Instruction &instruction: bytecode) {
+            const uint32_t pc = instruction.get_offset();
+            const uint8_t opcode = instruction.get_opcode();
+            std::vector<uint32_t> jumps;
+            bool falls_through = true;
+            switch (instruction.get_info().operand) {
+                case Bytecode::OPERAND_BRANCH:
+                case Bytecode::OPERAND_BRANCH_WIDE:
+                    jumps.push_back(instruction.get_branch_target());
+                    falls_through = opcode != Bytecode::OP_GOTO && opcode != Bytecode::OP_GOTO_W;
+                    break;
+                case Bytecode::OPERAND_TABLESWITCH:
+                case Bytecode::OPERAND_LOOKUPSWITCH:
+                    jumps.push_back(pc + instruction.get_default_offset());
+                    for (uint32_t i = 0; i < instruction.get_case_count(); ++i) {
+                        jumps.push_back(pc + instruction.get_case_offset(i));
+                    }
+                    falls_through = false;
+                    break;
+                default:
+                    falls_through = opcode != Bytecode::OP_RET && opcode != Bytecode::OP_ATHROW &&
+                                    (opcode < Bytecode::OP_IRETURN || opcode > Bytecode::OP_RETURN);
+                    if (falls_through) continue;
+                    break;
+            }
+            leaders.insert(jumps.begin(), jumps.end());
+            leaders.insert(pc + instruction.get_length());
+            if (falls_through) {
+                jumps.push_back(pc + instruction.get_length());
+            }
+            targets[pc] = std::move(jumps);
+        }
+        for (const auto &entry: code.exception_table) {
+            leaders.insert({entry.start_pc, entry.end_pc, entry.handler_pc});
+        }
+
+        std::map<uint32_t, std::vector<uint32_t> > successors;
+        std::map<uint32_t, std::vector<uint32_t> > predecessors;
+        const auto add_edge = [&](const uint32_t from, const uint32_t to) {
+            successors[from].push_back(to);
+            predecessors[to].push_back(from);
+        };
+        for (const Bytecode::Instruction &instruction: bytecode) {
+            const uint32_t pc = instruction.get_offset();
+            const uint32_t next = pc + instruction.get_length();
+            if (next != code.bytecode().size() && leaders.count(next) == 0) continue;
+            const uint32_t block = *std::prev(leaders.upper_bound(pc));
+            const auto it = targets.find(pc);
+            if (it == targets.end()) {
+                add_edge(block, next);
+            } else {
+                for (const uint32_t target: it->second) {
+                    add_edge(block, target);
+                }
+            }
+        }
+        for (const auto &entry: code.exception_table) {
+            for (auto it = leaders.lower_bound(entry.start_pc); it != leaders.end() && *it < entry.end_pc; ++it) {
+                add_edge(*it, entry.handler_pc);
+            }
+        }
+        return successors.size() + predecessors.size();
+    }
+
+    void bench_cfg(const Corpus &corpus, const int iterations) {
+        const auto buffers = read_corpus(corpus);
+        std::vector<std::unique_ptr<ClassParser> > parsers;
+        parsers.reserve(buffers.size());
+        // Methods by instruction count: under 100, under 1000, and larger.
+        std::vector<const ClassParser::CodeAttribute *> buckets[3];
+        size_t instructions[3] = {};
+        for (const auto &buffer: buffers) {
+            parsers.push_back(std::make_unique<ClassParser>(std::span<const uint8_t>(buffer)));
+            parsers.back()->parse();
+            for (const auto &method: parsers.back()->get_methods()) {
+                if (!method.code_attribute) continue;
+                const Bytecode bytecode(*method.code_attribute);
+                const size_t count = std::distance(bytecode.begin(), bytecode.end());
+                const int bucket = count < 100 ? 0 : count < 1000 ? 1 : 2;
+                buckets[bucket].push_back(&*method.code_attribute);
+                instructions[bucket] += count;
+            }
+        }
+
+        const char *labels[3] = {"< 100 instructions", "< 1000 instructions", ">= 1000 instructions"};
+        for (int bucket = 0; bucket < 3; ++bucket) {
+            if (buckets[bucket].empty()) continue;
+            const auto &methods = buckets[bucket];
+            std::cout << labels[bucket] << ": " << methods.size() << " methods, " << instructions[bucket]
+                    << " instructions" << std::endl;
+            const auto run = [&](const std::string &label, const auto &body) {
+                const double seconds = time_best_of(iterations, [&] {
+                    for (const ClassParser::CodeAttribute *code: methods) {
+                        sink += body(*code);
+                    }
+                });
+                std::cout << "  " << std::left << std::setw(24) << label << std::right << std::fixed
+                        << std::setprecision(3) << std::setw(10) << seconds * 1000.0 << " ms"
+                        << std::setw(10) << std::setprecision(1) << seconds * 1e9 / instructions[bucket]
+                        << " ns/instruction" << std::endl;
+            };
+            run("ControlFlowGraph", [](const ClassParser::CodeAttribute &code) {
+                return ControlFlowGraph(code).get_edge_count();
+            });
+            run("std::map", [](const ClassParser::CodeAttribute &code) {
+                return naive_control_flow_graph(code);
+            });
+        }
+
+        const double first_seconds = time_best_of(1, [&] {
+            for (const auto &parser: parsers) {
+                for (const auto &method: parser->get_methods()) {
+                    if (method.code_attribute) sink += method.get_control_flow_graph().size();
+                }
+            }
+        });
+        const double cached_seconds = time_best_of(iterations, [&] {
+            for (const auto &parser: parsers) {
+                for (const auto &method: parser->get_methods()) {
+                    if (method.code_attribute) sink += method.get_control_flow_graph().size();
+                }
+            }
+        });
+        std::cout << std::fixed << std::setprecision(3) << "MethodInfo::get_control_flow_graph: first "
+                << first_seconds * 1000.0 << " ms, cached " << cached_seconds * 1000.0 << " ms" << std::endl;
+    }
+
+    void bench_frames(const Corpus &corpus, const int iterations) {
+        const auto buffers = read_corpus(corpus);
+        std::vector<std::unique_ptr<ClassParser> > parsers;
+        std::vector<std::pair<const ClassParser *, const ClassParser::MethodInfo *> > methods;
+        for (const auto &buffer: buffers) {
+            parsers.push_back(std::make_unique<ClassParser>(std::span<const uint8_t>(buffer)));
+            parsers.back()->parse();
+            for (const auto &method: parsers.back()->get_methods()) {
+                if (!method.code_attribute) continue;
+                for (const auto &attribute: method.code_attribute->attributes) {
+                    if (parsers.back()->attribute_kind(attribute.name_index) ==
+                        ClassParser::SpecializedAttribute::STACK_MAP_TABLE) {
+                        methods.emplace_back(parsers.back().get(), &method);
+                        break;
+                    }
+                }
+            }
+        }
+        if (methods.empty()) {
+            std::cout << "No StackMapTable attributes in the corpus" << std::endl;
+            return;
+        }
+
+        // Up to 256 evenly spaced pcs per method.
+        constexpr uint32_t QUERIES_PER_METHOD = 256;
+        size_t frames = 0;
+        size_t types = 0;
+        size_t entries = 0;
+        size_t queries = 0;
+        for (const auto &[parser, method]: methods) {
+            const StackMapTable table(*parser, *method);
+            frames += table.size();
+            types += table.get_type_count();
+            for (const StackMapTable::Frame &frame: table.get_frames()) {
+                entries += frame.locals_count + frame.stack_count;
+            }
+            queries += std::min<size_t>(QUERIES_PER_METHOD, method->code_attribute->bytecode().size());
+        }
+        std::cout << methods.size() << " methods, " << frames << " frames, " << queries << " queries; "
+                << types << " verification types stored for " << entries << " frame entries" << std::endl;
+
+        const auto run = [&](const std::string &label, const auto &body) {
+            const double seconds = time_best_of(iterations, [&] {
+                for (const auto &[parser, method]: methods) {
+                    body(*parser, *method);
+                }
+            });
+            std::cout << std::left << std::setw(28) << label << std::right << std::fixed << std::setprecision(3)
+                    << std::setw(10) << seconds * 1000.0 << " ms" << std::setw(12) << std::setprecision(1)
+                    << seconds * 1e9 / queries << " ns/query" << std::endl;
+        };
+        const auto for_each_query = [&](const ClassParser::MethodInfo &method, const auto &query) {
+            const auto length = static_cast<uint32_t>(method.code_attribute->bytecode().size());
+            const uint32_t count = std::min(QUERIES_PER_METHOD, length);
+            for (uint32_t i = 0; i < count; ++i) {
+                query(static_cast<uint32_t>(uint64_t{length} * i / count));
+            }
+        };
+        run("index once", [&](const ClassParser &parser, const ClassParser::MethodInfo &method) {
+            const StackMapTable table(parser, method);
+            for_each_query(method, [&](const uint32_t pc) {
+                sink += table.nearest_frame(pc).locals_count;
+            });
+        });
+        run("decode per query", [&](const ClassParser &parser, const ClassParser::MethodInfo &method) {
+            for_each_query(method, [&](const uint32_t pc) {
+                sink += StackMapTable(parser, method).nearest_frame(pc).locals_count;
+            });
+        });
+    }
+
+    void bench_instructions(const Corpus &corpus, const int iterations) {
+        const auto buffers = read_corpus(corpus);
+        std::vector<std::unique_ptr<ClassParser> > parsers;
+        parsers.reserve(buffers.size());
+        for (const auto &buffer: buffers) {
+            parsers.push_back(std::make_unique<ClassParser>(std::span<const uint8_t>(buffer)));
+            parsers.back()->parse();
+        }
+
+        const auto run = [&](const std::string &label, const auto &body) {
+            size_t instructions = 0;
+            const size_t allocations_before = allocation_count.load();
+            const double seconds = time_best_of(iterations, [&] {
+                instructions = 0;
+                for (const auto &parser: parsers) {
+                    for (const auto &method: parser->get_methods()) {
+                        if (method.code_attribute) {
+                            instructions += body(*parser, Bytecode(*method.code_attribute));
+                        }
+                    }
+                }
+            });
+            std::cout << std::left << std::setw(28) << label << std::right << std::fixed << std::setprecision(3)
+                    << std::setw(10) << seconds * 1000.0 << " ms"
+                    << std::setw(14) << std::setprecision(1) << instructions / seconds / 1e6 << " M instructions/s"
+                    << std::setw(10) << (allocation_count.load() - allocations_before) / iterations << " allocations"
+                    << std::endl;
+        };
+
+        run("decode", [](const ClassParser &, const Bytecode &bytecode) {
+            size_t count = 0;
+            for (const Bytecode::Instruction &instruction: bytecode) {
+                sink += instruction.get_opcode();
+                count++;
+            }
+            return count;
+        });
+        run("decode+operands", [](const ClassParser &parser, const Bytecode &bytecode) {
+            size_t count = 0;
+            for (const Bytecode::Instruction &instruction: bytecode) {
+                switch (instruction.get_info().operand) {
+                    case Bytecode::OPERAND_CLASS:
+                    case Bytecode::OPERAND_MULTIANEWARRAY:
+                        sink += instruction.get_class_name(parser).size();
+                        break;
+                    case Bytecode::OPERAND_FIELD:
+                    case Bytecode::OPERAND_METHOD:
+                    case Bytecode::OPERAND_INVOKEINTERFACE:
+                        sink += instruction.get_member_name(parser).size();
+                        break;
+                    case Bytecode::OPERAND_BRANCH:
+                    case Bytecode::OPERAND_BRANCH_WIDE:
+                        sink += instruction.get_branch_target();
+                        break;
+                    case Bytecode::OPERAND_TABLESWITCH:
+                    case Bytecode::OPERAND_LOOKUPSWITCH:
+                        sink += instruction.get_case_count();
+                        break;
+                    case Bytecode::OPERAND_BYTE:
+                    case Bytecode::OPERAND_SHORT:
+                    case Bytecode::OPERAND_IINC:
+                        sink += instruction.get_immediate();
+                        break;
+                    default:
+                        break;
+                }
+                count++;
+            }
+            return count;
+        });
+        run("decode+stack effect", [](const ClassParser &parser, const Bytecode &bytecode) {
+            size_t count = 0;
+            for (const Bytecode::Instruction &instruction: bytecode) {
+                const Bytecode::StackEffect effect = instruction.get_stack_effect(parser);
+                sink += effect.pushes - effect.pops;
+                count++;
+            }
+            return count;
+        });
+    }
+
+    // Assembles one method's bytecode. Branches refer to labels and are patched in finish().
+    class KernelAssembler {
+    public:
+        int new_label() {
+            labels.push_back(-1);
+            return static_cast<int>(labels.size() - 1);
+        }
+
+        void bind(const int label) { labels[label] = static_cast<int32_t>(code.size()); }
+
+        KernelAssembler &op(const uint8_t opcode) {
+            code.push_back(opcode);
+            return *this;
+        }
+
+        KernelAssembler &u1(const uint8_t value) { return op(value); }
+
+        KernelAssembler &u2(const uint16_t value) {
+            code.push_back(static_cast<uint8_t>(value >> 8));
+            code.push_back(static_cast<uint8_t>(value));
+            return *this;
+        }
+
+        KernelAssembler &s4(const int32_t value) {
+            u2(static_cast<uint16_t>(static_cast<uint32_t>(value) >> 16));
+            return u2(static_cast<uint16_t>(value));
+        }
+
+        KernelAssembler &iinc(const uint8_t local, const int8_t delta) {
+            return op(Bytecode::OP_IINC).u1(local).u1(static_cast<uint8_t>(delta));
+        }
+
+        KernelAssembler &branch(const uint8_t opcode, const int label) {
+            fixups.push_back({code.size() + 1, code.size(), label, false});
+            return op(opcode).u2(0);
+        }
+
+        KernelAssembler &tableswitch(const int32_t low, const std::vector<int> &cases, const int default_label) {
+            const size_t pc = begin_switch(Bytecode::OP_TABLESWITCH);
+            fixups.push_back({code.size(), pc, default_label, true});
+            s4(0).s4(low).s4(low + (static_cast<int32_t>(cases.size()) - 1));
+            for (const int label: cases) {
+                fixups.push_back({code.size(), pc, label, true});
+                s4(0);
+            }
+            return *this;
+        }
+
+        // Keys must be sorted.
+        KernelAssembler &lookupswitch(const std::vector<std::pair<int32_t, int> > &cases, const int default_label) {
+            const size_t pc = begin_switch(Bytecode::OP_LOOKUPSWITCH);
+            fixups.push_back({code.size(), pc, default_label, true});
+            s4(0).s4(static_cast<int32_t>(cases.size()));
+            for (const auto &[key, label]: cases) {
+                s4(key);
+                fixups.push_back({code.size(), pc, label, true});
+                s4(0);
+            }
+            return *this;
+        }
+
+        std::vector<uint8_t> finish() {
+            for (const Fixup &fixup: fixups) {
+                const int32_t offset = labels[fixup.label] - static_cast<int32_t>(fixup.pc);
+                if (fixup.wide) {
+                    for (int i = 0; i < 4; ++i) {
+                        code[fixup.position + i] = static_cast<uint8_t>(static_cast<uint32_t>(offset) >> (24 - 8 * i));
+                    }
+                } else {
+                    code[fixup.position] = static_cast<uint8_t>(offset >> 8);
+                    code[fixup.position + 1] = static_cast<uint8_t>(offset);
+                }
+            }
+            return std::move(code);
+        }
+
+    private:
+        struct Fixup {
+            size_t position;
+            size_t pc;
+            int label;
+            bool wide;
+        };
+
+        std::vector<uint8_t> code;
+        std::vector<int32_t> labels;
+        std::vector<Fixup> fixups;
+
+        size_t begin_switch(const uint8_t opcode) {
+            const size_t pc = code.size();
+            op(opcode);
+            while (code.size() % 4 != 0) code.push_back(0);
+            return pc;
+        }
+    };
+
+    // Writes a class file with public static methods only; enough for the interpreter benchmark
+    // without a Java compiler at hand.
+    class KernelClassBuilder {
+    public:
+        explicit KernelClassBuilder(const std::string_view name) : name(name) {
+            this_class = class_ref(name);
+            super_class = class_ref("java/lang/Object");
+        }
+
+        uint16_t utf8(const std::string_view value) {
+            const auto it = utf8_indexes.find(std::string(value));
+            if (it != utf8_indexes.end()) return it->second;
+            pool.push_back(ClassParser::CONSTANT_Utf8);
+            put_u2(pool, static_cast<uint16_t>(value.size()));
+            pool.insert(pool.end(), value.begin(), value.end());
+            return utf8_indexes[std::string(value)] = next_index(1);
+        }
+
+        uint16_t class_ref(const std::string_view class_name) {
+            const uint16_t name_index = utf8(class_name);
+            pool.push_back(ClassParser::CONSTANT_Class);
+            put_u2(pool, name_index);
+            return next_index(1);
+        }
+
+        // A Methodref to a method of this class.
+        uint16_t method_ref(const std::string_view method_name, const std::string_view descriptor) {
+            const uint16_t name_index = utf8(method_name);
+            const uint16_t descriptor_index = utf8(descriptor);
+            pool.push_back(ClassParser::CONSTANT_NameAndType);
+            put_u2(pool, name_index);
+            put_u2(pool, descriptor_index);
+            const uint16_t name_and_type = next_index(1);
+            pool.push_back(ClassParser::CONSTANT_Methodref);
+            put_u2(pool, this_class);
+            put_u2(pool, name_and_type);
+            return next_index(1);
+        }
+
+        uint16_t integer_constant(const int32_t value) {
+            pool.push_back(ClassParser::CONSTANT_Integer);
+            put_u4(pool, static_cast<uint32_t>(value));
+            return next_index(1);
+        }
+
+        uint16_t float_constant(const float value) {
+            pool.push_back(ClassParser::CONSTANT_Float);
+            put_u4(pool, std::bit_cast<uint32_t>(value));
+            return next_index(1);
+        }
+
+        uint16_t long_constant(const int64_t value) {
+            pool.push_back(ClassParser::CONSTANT_Long);
+            put_u4(pool, static_cast<uint32_t>(static_cast<uint64_t>(value) >> 32));
+            put_u4(pool, static_cast<uint32_t>(value));
+            return next_index(2);
+        }
+
+        void add_method(const std::string_view method_name, const std::string_view descriptor,
+                        const uint16_t max_stack, const uint16_t max_locals, const std::vector<uint8_t> &code) {
+            std::vector<uint8_t> &out = methods;
+            put_u2(out, ClassParser::ACC_PUBLIC | ClassParser::ACC_STATIC);
+            put_u2(out, utf8(method_name));
+            put_u2(out, utf8(descriptor));
+            put_u2(out, 1);
+            put_u2(out, utf8("Code"));
+            put_u4(out, static_cast<uint32_t>(12 + code.size()));
+            put_u2(out, max_stack);
+            put_u2(out, max_locals);
+            put_u4(out, static_cast<uint32_t>(code.size()));
+            out.insert(out.end(), code.begin(), code.end());
+            put_u2(out, 0);
+            put_u2(out, 0);
+            ++method_count;
+        }
+
+        std::vector<uint8_t> build() const {
+            std::vector<uint8_t> out;
+            put_u4(out, 0xCAFEBABE);
+            put_u2(out, 0);
+            put_u2(out, 52);
+            put_u2(out, pool_count);
+            out.insert(out.end(), pool.begin(), pool.end());
+            put_u2(out, ClassParser::ACC_PUBLIC);
+            put_u2(out, this_class);
+            put_u2(out, super_class);
+            put_u2(out, 0);
+            put_u2(out, 0);
+            put_u2(out, method_count);
+            out.insert(out.end(), methods.begin(), methods.end());
+            put_u2(out, 0);
+            return out;
+        }
+
+    private:
+        std::string name;
+        std::vector<uint8_t> pool;
+        uint16_t pool_count = 1;
+        std::map<std::string, uint16_t> utf8_indexes;
+        std::vector<uint8_t> methods;
+        uint16_t method_count = 0;
+        uint16_t this_class = 0;
+        uint16_t super_class = 0;
+
+        uint16_t next_index(const uint16_t slots) {
+            const uint16_t index = pool_count;
+            pool_count += slots;
+            return index;
+        }
+
+        static void put_u2(std::vector<uint8_t> &out, const uint16_t value) {
+            out.push_back(static_cast<uint8_t>(value >> 8));
+            out.push_back(static_cast<uint8_t>(value));
+        }
+
+        static void put_u4(std::vector<uint8_t> &out, const uint32_t value) {
+            put_u2(out, static_cast<uint16_t>(value >> 16));
+            put_u2(out, static_cast<uint16_t>(value));
+        }
+    };
+
+    struct Kernel {
+        const char *name;
+        const char *descriptor;
+        int32_t argument;
+        std::function<VirtualMachine::Value(int32_t)> native;
+        char result_type;
+    };
+
+    // Static compute kernels, each mirrored by a native version whose result the interpreter must match.
+    std::vector<uint8_t> build_kernels_class(std::vector<Kernel> &kernels) {
+        using B = Bytecode;
+        KernelClassBuilder builder("Kernels");
+
+        {
+            // static int fib(int n) { return n < 2 ? n : fib(n - 1) + fib(n - 2); }
+            const uint16_t fib = builder.method_ref("fib", "(I)I");
+            KernelAssembler a;
+            const int recurse = a.new_label();
+            a.op(B::OP_ILOAD_0).op(B::OP_ICONST_2).branch(B::OP_IF_ICMPGE, recurse);
+            a.op(B::OP_ILOAD_0).op(B::OP_IRETURN);
+            a.bind(recurse);
+            a.op(B::OP_ILOAD_0).op(B::OP_ICONST_1).op(B::OP_ISUB).op(B::OP_INVOKESTATIC).u2(fib);
+            a.op(B::OP_ILOAD_0).op(B::OP_ICONST_2).op(B::OP_ISUB).op(B::OP_INVOKESTATIC).u2(fib);
+            a.op(B::OP_IADD).op(B::OP_IRETURN);
+            builder.add_method("fib", "(I)I", 3, 1, a.finish());
+            kernels.push_back({"fib", "(I)I", 25, [](const int32_t n) {
+                const std::function<int32_t(int32_t)> fib = [&fib](const int32_t m) {
+                    return m < 2 ? m : fib(m - 1) + fib(m - 2);
+                };
+                VirtualMachine::Value v{};
+                v.i = fib(n);
+                return v;
+            }, 'I'});
+        }
+        {
+            // Counts primes below n with a boolean[] sieve.
+            KernelAssembler a;
+            const int loop = a.new_label(), inner = a.new_label(), next = a.new_label(), end = a.new_label();
+            a.op(B::OP_ILOAD_0).op(B::OP_NEWARRAY).u1(VirtualMachine::T_BOOLEAN).op(B::OP_ASTORE_1);
+            a.op(B::OP_ICONST_0).op(B::OP_ISTORE_2).op(B::OP_ICONST_2).op(B::OP_ISTORE_3);
+            a.bind(loop);
+            a.op(B::OP_ILOAD_3).op(B::OP_ILOAD_0).branch(B::OP_IF_ICMPGE, end);
+            a.op(B::OP_ALOAD_1).op(B::OP_ILOAD_3).op(B::OP_BALOAD).branch(B::OP_IFNE, next);
+            a.iinc(2, 1);
+            a.op(B::OP_ILOAD_3).op(B::OP_ILOAD_0).op(B::OP_ILOAD_3).op(B::OP_IDIV).branch(B::OP_IF_ICMPGT, next);
+            a.op(B::OP_ILOAD_3).op(B::OP_ILOAD_3).op(B::OP_IMUL).op(B::OP_ISTORE).u1(4);
+            a.bind(inner);
+            a.op(B::OP_ILOAD).u1(4).op(B::OP_ILOAD_0).branch(B::OP_IF_ICMPGE, next);
+            a.op(B::OP_ALOAD_1).op(B::OP_ILOAD).u1(4).op(B::OP_ICONST_1).op(B::OP_BASTORE);
+            a.op(B::OP_ILOAD).u1(4).op(B::OP_ILOAD_3).op(B::OP_IADD).op(B::OP_ISTORE).u1(4);
+            a.branch(B::OP_GOTO, inner);
+            a.bind(next);
+            a.iinc(3, 1).branch(B::OP_GOTO, loop);
+            a.bind(end);
+            a.op(B::OP_ILOAD_2).op(B::OP_IRETURN);
+            builder.add_method("sieve", "(I)I", 3, 5, a.finish());
+            kernels.push_back({"sieve", "(I)I", 1 << 20, [](const int32_t n) {
+                std::vector<bool> composite(n);
+                int32_t count = 0;
+                for (int32_t i = 2; i < n; ++i) {
+                    if (composite[i]) continue;
+                    ++count;
+                    if (i > n / i) continue;
+                    for (int32_t j = i * i; j < n; j += i) composite[j] = true;
+                }
+                VirtualMachine::Value v{};
+                v.i = count;
+                return v;
+            }, 'I'});
+        }
+        {
+            // Sums the product of two n x n double[][] matrices with a[i][j] = i + j and b[i][j] = i - j.
+            const uint16_t matrix = builder.class_ref("[[D");
+            KernelAssembler a;
+            const int fill_i = a.new_label(), fill_j = a.new_label(), fill_next = a.new_label(),
+                    fill_end = a.new_label(), loop_i = a.new_label(), loop_j = a.new_label(),
+                    loop_k = a.new_label(), next_j = a.new_label(), next_i = a.new_label(), end = a.new_label();
+            a.op(B::OP_ILOAD_0).op(B::OP_ILOAD_0).op(B::OP_MULTIANEWARRAY).u2(matrix).u1(2).op(B::OP_ASTORE_1);
+            a.op(B::OP_ILOAD_0).op(B::OP_ILOAD_0).op(B::OP_MULTIANEWARRAY).u2(matrix).u1(2).op(B::OP_ASTORE_2);
+            a.op(B::OP_ICONST_0).op(B::OP_ISTORE_3);
+            a.bind(fill_i);
+            a.op(B::OP_ILOAD_3).op(B::OP_ILOAD_0).branch(B::OP_IF_ICMPGE, fill_end);
+            a.op(B::OP_ICONST_0).op(B::OP_ISTORE).u1(4);
+            a.bind(fill_j);
+            a.op(B::OP_ILOAD).u1(4).op(B::OP_ILOAD_0).branch(B::OP_IF_ICMPGE, fill_next);
+            a.op(B::OP_ALOAD_1).op(B::OP_ILOAD_3).op(B::OP_AALOAD).op(B::OP_ILOAD).u1(4);
+            a.op(B::OP_ILOAD_3).op(B::OP_ILOAD).u1(4).op(B::OP_IADD).op(B::OP_I2D).op(B::OP_DASTORE);
+            a.op(B::OP_ALOAD_2).op(B::OP_ILOAD_3).op(B::OP_AALOAD).op(B::OP_ILOAD).u1(4);
+            a.op(B::OP_ILOAD_3).op(B::OP_ILOAD).u1(4).op(B::OP_ISUB).op(B::OP_I2D).op(B::OP_DASTORE);
+            a.iinc(4, 1).branch(B::OP_GOTO, fill_j);
+            a.bind(fill_next);
+            a.iinc(3, 1).branch(B::OP_GOTO, fill_i);
+            a.bind(fill_end);
+            a.op(B::OP_DCONST_0).op(B::OP_DSTORE).u1(6).op(B::OP_ICONST_0).op(B::OP_ISTORE_3);
+            a.bind(loop_i);
+            a.op(B::OP_ILOAD_3).op(B::OP_ILOAD_0).branch(B::OP_IF_ICMPGE, end);
+            a.op(B::OP_ICONST_0).op(B::OP_ISTORE).u1(4);
+            a.bind(loop_j);
+            a.op(B::OP_ILOAD).u1(4).op(B::OP_ILOAD_0).branch(B::OP_IF_ICMPGE, next_i);
+            a.op(B::OP_DCONST_0).op(B::OP_DSTORE).u1(8).op(B::OP_ICONST_0).op(B::OP_ISTORE).u1(5);
+            a.bind(loop_k);
+            a.op(B::OP_ILOAD).u1(5).op(B::OP_ILOAD_0).branch(B::OP_IF_ICMPGE, next_j);
+            a.op(B::OP_DLOAD).u1(8);
+            a.op(B::OP_ALOAD_1).op(B::OP_ILOAD_3).op(B::OP_AALOAD).op(B::OP_ILOAD).u1(5).op(B::OP_DALOAD);
+            a.op(B::OP_ALOAD_2).op(B::OP_ILOAD).u1(5).op(B::OP_AALOAD).op(B::OP_ILOAD).u1(4).op(B::OP_DALOAD);
+            a.op(B::OP_DMUL).op(B::OP_DADD).op(B::OP_DSTORE).u1(8);
+            a.iinc(5, 1).branch(B::OP_GOTO, loop_k);
+            a.bind(next_j);
+            a.op(B::OP_DLOAD).u1(6).op(B::OP_DLOAD).u1(8).op(B::OP_DADD).op(B::OP_DSTORE).u1(6);
+            a.iinc(4, 1).branch(B::OP_GOTO, loop_j);
+            a.bind(next_i);
+            a.iinc(3, 1).branch(B::OP_GOTO, loop_i);
+            a.bind(end);
+            a.op(B::OP_DLOAD).u1(6).op(B::OP_DRETURN);
+            builder.add_method("matmul", "(I)D", 6, 10, a.finish());
+            kernels.push_back({"matmul", "(I)D", 64, [](const int32_t n) {
+                double sum = 0;
+                for (int32_t i = 0; i < n; ++i) {
+                    for (int32_t j = 0; j < n; ++j) {
+                        double cell = 0;
+                        for (int32_t k = 0; k < n; ++k) cell += static_cast<double>(i + k) * (k - j);
+                        sum += cell;
+                    }
+                }
+                VirtualMachine::Value v{};
+                v.d = sum;
+                return v;
+            }, 'D'});
+        }
+        {
+            // Folds n steps of a 64-bit linear congruential generator into a hash.
+            constexpr int64_t SEED = 0x2545F4914F6CDD1DLL;
+            constexpr int64_t MULTIPLIER = 6364136223846793005LL;
+            constexpr int64_t INCREMENT = 1442695040888963407LL;
+            const uint16_t seed = builder.long_constant(SEED);
+            const uint16_t multiplier = builder.long_constant(MULTIPLIER);
+            const uint16_t increment = builder.long_constant(INCREMENT);
+            KernelAssembler a;
+            const int loop = a.new_label(), end = a.new_label();
+            a.op(B::OP_LDC2_W).u2(seed).op(B::OP_LSTORE_1).op(B::OP_LCONST_0).op(B::OP_LSTORE_3);
+            a.op(B::OP_ICONST_0).op(B::OP_ISTORE).u1(5);
+            a.bind(loop);
+            a.op(B::OP_ILOAD).u1(5).op(B::OP_ILOAD_0).branch(B::OP_IF_ICMPGE, end);
+            a.op(B::OP_LLOAD_1).op(B::OP_LDC2_W).u2(multiplier).op(B::OP_LMUL);
+            a.op(B::OP_LDC2_W).u2(increment).op(B::OP_LADD).op(B::OP_LSTORE_1);
+            a.op(B::OP_LLOAD_3).op(B::OP_LLOAD_1).op(B::OP_BIPUSH).u1(33).op(B::OP_LUSHR).op(B::OP_LXOR);
+            a.op(B::OP_LSTORE_3);
+            a.iinc(5, 1).branch(B::OP_GOTO, loop);
+            a.bind(end);
+            a.op(B::OP_LLOAD_3).op(B::OP_LRETURN);
+            builder.add_method("lcg", "(I)J", 5, 6, a.finish());
+            kernels.push_back({"lcg", "(I)J", 1 << 20, [](const int32_t n) {
+                uint64_t x = SEED;
+                uint64_t h = 0;
+                for (int32_t i = 0; i < n; ++i) {
+                    x = x * MULTIPLIER + INCREMENT;
+                    h ^= x >> 33;
+                }
+                VirtualMachine::Value v{};
+                v.l = static_cast<int64_t>(h);
+                return v;
+            }, 'J'});
+        }
+        {
+            // Sums eight Newton steps towards sqrt(i) for i in 1..n in float.
+            const uint16_t half = builder.float_constant(0.5f);
+            KernelAssembler a;
+            const int loop = a.new_label(), step = a.new_label(), next = a.new_label(), end = a.new_label();
+            a.op(B::OP_FCONST_0).op(B::OP_FSTORE_1).op(B::OP_ICONST_1).op(B::OP_ISTORE_2);
+            a.bind(loop);
+            a.op(B::OP_ILOAD_2).op(B::OP_ILOAD_0).branch(B::OP_IF_ICMPGT, end);
+            a.op(B::OP_ILOAD_2).op(B::OP_I2F).op(B::OP_DUP).op(B::OP_FSTORE_3).op(B::OP_FSTORE).u1(4);
+            a.op(B::OP_BIPUSH).u1(8).op(B::OP_ISTORE).u1(5);
+            a.bind(step);
+            a.op(B::OP_ILOAD).u1(5).branch(B::OP_IFLE, next);
+            a.op(B::OP_LDC).u1(static_cast<uint8_t>(half)).op(B::OP_FLOAD).u1(4).op(B::OP_FLOAD_3);
+            a.op(B::OP_FLOAD).u1(4).op(B::OP_FDIV).op(B::OP_FADD).op(B::OP_FMUL).op(B::OP_FSTORE).u1(4);
+            a.iinc(5, -1).branch(B::OP_GOTO, step);
+            a.bind(next);
+            a.op(B::OP_FLOAD_1).op(B::OP_FLOAD).u1(4).op(B::OP_FADD).op(B::OP_FSTORE_1);
+            a.iinc(2, 1).branch(B::OP_GOTO, loop);
+            a.bind(end);
+            a.op(B::OP_FLOAD_1).op(B::OP_FRETURN);
+            builder.add_method("newton", "(I)F", 4, 6, a.finish());
+            kernels.push_back({"newton", "(I)F", 1 << 16, [](const int32_t n) {
+                float sum = 0;
+                for (int32_t i = 1; i <= n; ++i) {
+                    const float x = static_cast<float>(i);
+                    float y = x;
+                    for (int step = 8; step > 0; --step) y = 0.5f * (y + x / y);
+                    sum += y;
+                }
+                VirtualMachine::Value v{};
+                v.f = sum;
+                return v;
+            }, 'F'});
+        }
+        {
+            // Mixes an accumulator through a tableswitch on i % 7 and a lookupswitch on i & 15.
+            KernelAssembler a;
+            const int loop = a.new_label(), next = a.new_label(), end = a.new_label();
+            const int case0 = a.new_label(), case1 = a.new_label(), case2 = a.new_label(), case3 = a.new_label(),
+                    other = a.new_label(), key4 = a.new_label(), key6 = a.new_label(), key13 = a.new_label();
+            a.op(B::OP_ICONST_0).op(B::OP_ISTORE_1).op(B::OP_ICONST_0).op(B::OP_ISTORE_2);
+            a.bind(loop);
+            a.op(B::OP_ILOAD_2).op(B::OP_ILOAD_0).branch(B::OP_IF_ICMPGE, end);
+            a.op(B::OP_ILOAD_2).op(B::OP_BIPUSH).u1(7).op(B::OP_IREM);
+            a.tableswitch(0, {case0, case1, case2, case3}, other);
+            a.bind(case0);
+            a.op(B::OP_ILOAD_1).op(B::OP_ILOAD_2).op(B::OP_IADD).op(B::OP_ISTORE_1).branch(B::OP_GOTO, next);
+            a.bind(case1);
+            a.op(B::OP_ILOAD_1).op(B::OP_ILOAD_2).op(B::OP_IXOR).op(B::OP_ISTORE_1).branch(B::OP_GOTO, next);
+            a.bind(case2);
+            a.op(B::OP_ILOAD_1).op(B::OP_ICONST_3).op(B::OP_IMUL).op(B::OP_ISTORE_1).branch(B::OP_GOTO, next);
+            a.bind(case3);
+            a.op(B::OP_ILOAD_1).op(B::OP_ICONST_1).op(B::OP_ISHL).op(B::OP_ISTORE_1).branch(B::OP_GOTO, next);
+            a.bind(other);
+            a.op(B::OP_ILOAD_2).op(B::OP_BIPUSH).u1(15).op(B::OP_IAND);
+            a.lookupswitch({{4, key4}, {6, key6}, {13, key13}}, next);
+            a.bind(key4);
+            a.iinc(1, 7).branch(B::OP_GOTO, next);
+            a.bind(key6);
+            a.op(B::OP_ILOAD_1).op(B::OP_ICONST_5).op(B::OP_ISHR).op(B::OP_ISTORE_1).branch(B::OP_GOTO, next);
+            a.bind(key13);
+            a.op(B::OP_ILOAD_1).op(B::OP_INEG).op(B::OP_ISTORE_1);
+            a.bind(next);
+            a.iinc(2, 1).branch(B::OP_GOTO, loop);
+            a.bind(end);
+            a.op(B::OP_ILOAD_1).op(B::OP_IRETURN);
+            builder.add_method("dispatch", "(I)I", 2, 3, a.finish());
+            kernels.push_back({"dispatch", "(I)I", 1 << 20, [](const int32_t n) {
+                uint32_t acc = 0;
+                for (int32_t i = 0; i < n; ++i) {
+                    switch (i % 7) {
+                        case 0: acc += i; break;
+                        case 1: acc ^= i; break;
+                        case 2: acc *= 3; break;
+                        case 3: acc <<= 1; break;
+                        default:
+                            switch (i & 15) {
+                                case 4: acc += 7; break;
+                                case 6: acc = static_cast<uint32_t>(static_cast<int32_t>(acc) >> 5); break;
+                                case 13: acc = 0u - acc; break;
+                                default: break;
+                            }
+                    }
+                }
+                VirtualMachine::Value v{};
+                v.i = static_cast<int32_t>(acc);
+                return v;
+            }, 'I'});
+        }
+        {
+            // main runs every kernel once and drops the results.
+            KernelAssembler a;
+            for (const Kernel &kernel: kernels) {
+                const uint16_t argument = builder.integer_constant(kernel.argument);
+                a.op(B::OP_LDC_W).u2(argument).op(B::OP_INVOKESTATIC).u2(builder.method_ref(kernel.name, kernel.descriptor));
+                a.op(kernel.result_type == 'J' || kernel.result_type == 'D' ? B::OP_POP2 : B::OP_POP);
+            }
+            a.op(B::OP_RETURN);
+            builder.add_method("main", "([Ljava/lang/String;)V", 2, 1, a.finish());
+        }
+        return builder.build();
+    }
+
+    void bench_member_refs(const Corpus &corpus, const int iterations) {
+        const auto buffers = read_corpus(corpus);
+        std::vector<std::unique_ptr<ClassParser> > parsers;
+        std::vector<std::pair<const ClassParser *, uint16_t> > sites;
+        for (const auto &buffer: buffers) {
+            parsers.push_back(std::make_unique<ClassParser>(std::span<const uint8_t>(buffer)));
+            parsers.back()->parse();
+            const ClassParser &parser = *parsers.back();
+            for (const auto &method: parser.get_methods()) {
+                if (!method.code_attribute) continue;
+                for (const Bytecode::Instruction &instruction: Bytecode(*method.code_attribute)) {
+                    switch (instruction.get_info().operand) {
+                        case Bytecode::OPERAND_FIELD:
+                        case Bytecode::OPERAND_METHOD:
+                        case Bytecode::OPERAND_INVOKEINTERFACE:
+                            sites.emplace_back(&parser, instruction.get_constant_index());
+                            break;
+                        default:
+                            break;
+                    }
+                }
+            }
+        }
+        if (sites.empty()) {
+            std::cout << "No field or invoke instructions in the corpus" << std::endl;
+            return;
+        }
+        std::cout << sites.size() << " field and invoke sites" << std::endl;
+
+        const auto run = [&](const std::string &label, const int runs, const auto &resolve) {
+            const size_t allocations_before = allocation_count.load();
+            const double seconds = time_best_of(runs, [&] {
+                for (const auto &[parser, index]: sites) {
+                    sink += resolve(*parser, index);
+                }
+            });
+            std::cout << std::left << std::setw(28) << label << std::right << std::fixed << std::setprecision(3)
+                    << std::setw(10) << seconds * 1000.0 << " ms" << std::setw(12) << std::setprecision(1)
+                    << seconds * 1e9 / sites.size() << " ns/ref" << std::setw(10)
+                    << (allocation_count.load() - allocations_before) / runs << " allocations" << std::endl;
+        };
+        run("by hand (strings)", iterations, [](const ClassParser &parser, const uint16_t index) {
+            const ClassParser::ConstantPool &pool = parser.get_constant_pool();
+            const uint16_t name_and_type = pool.index2(index);
+            const std::string owner = parser.get_class_name(pool.index1(index));
+            const std::string name = parser.get_utf8_string(pool.index1(name_and_type));
+            const std::string descriptor = parser.get_utf8_string(pool.index2(name_and_type));
+            return owner.size() + name.size() + descriptor.size();
+        });
+        run("by hand (views)", iterations, [](const ClassParser &parser, const uint16_t index) {
+            const ClassParser::ConstantPool &pool = parser.get_constant_pool();
+            const uint16_t name_and_type = pool.index2(index);
+            return parser.get_class_name_view(pool.index1(index)).size() +
+                   parser.get_utf8_view(pool.index1(name_and_type)).size() +
+                   parser.get_utf8_view(pool.index2(name_and_type)).size();
+        });
+        const auto cached = [](const ClassParser &parser, const uint16_t index) {
+            const ClassParser::MemberReference &reference = parser.resolve_member_reference(index);
+            return reference.owner.size() + reference.name.size() + reference.descriptor.size();
+        };
+        run("cache, first pass", 1, cached);
+        run("cache", iterations, cached);
+    }
+
+    void bench_interpreter(const Corpus &, const int iterations) {
+        std::vector<Kernel> kernels;
+        const std::vector<uint8_t> bytes = build_kernels_class(kernels);
+        ClassParser parser{std::span<const uint8_t>(bytes)};
+        parser.parse();
+        VirtualMachine vm;
+        vm.add_class(parser);
+
+        const auto format = [](const char type, const VirtualMachine::Value value) {
+            switch (type) {
+                case 'J': return std::to_string(value.l);
+                case 'F': return std::to_string(value.f);
+                case 'D': return std::to_string(value.d);
+                default: return std::to_string(value.i);
+            }
+        };
+        const auto matches = [](const char type, const VirtualMachine::Value actual,
+                                const VirtualMachine::Value expected) {
+            switch (type) {
+                case 'J': return actual.l == expected.l;
+                case 'F': return std::abs(actual.f - expected.f) <= 1e-5f * std::abs(expected.f);
+                case 'D': return std::abs(actual.d - expected.d) <= 1e-9 * std::abs(expected.d);
+                default: return actual.i == expected.i;
+            }
+        };
+        const auto run = [&](const std::string &label, const auto &body, const double native_seconds) {
+            uint64_t instructions = 0;
+            const double seconds = time_best_of(iterations, [&] {
+                vm.reset_instruction_count();
+                body();
+                instructions = vm.get_instruction_count();
+                vm.release_arrays();
+            });
+            std::cout << std::left << std::setw(28) << label << std::right << std::fixed << std::setprecision(3)
+                    << std::setw(10) << seconds * 1000.0 << " ms" << std::setw(12) << instructions
+                    << " instructions" << std::setw(10) << std::setprecision(1) << instructions / seconds / 1e6
+                    << " M/s";
+            if (native_seconds > 0) {
+                std::cout << std::setw(10) << seconds / native_seconds << "x native";
+            }
+            std::cout << std::endl;
+        };
+
+        double native_total = 0;
+        for (const Kernel &kernel: kernels) {
+            VirtualMachine::Value expected{};
+            const double native_seconds = time_best_of(iterations, [&] { expected = kernel.native(kernel.argument); });
+            native_total += native_seconds;
+            VirtualMachine::Value actual{};
+            const VirtualMachine::Value argument{.i = kernel.argument};
+            run(std::string(kernel.name) + "(" + std::to_string(kernel.argument) + ")", [&] {
+                actual = vm.invoke(parser, kernel.name, kernel.descriptor, std::span(&argument, 1));
+            }, native_seconds);
+            if (!matches(kernel.result_type, actual, expected)) {
+                throw std::runtime_error(std::string(kernel.name) + " returned " + format(kernel.result_type, actual) +
+                                         ", expected " + format(kernel.result_type, expected));
+            }
+        }
+        run("main (all kernels)", [&] { vm.run_main(parser); }, native_total);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    const std::map<std::string, std::function<void(const Corpus &, int)> > benchmarks = {
+        {"arena", bench_arena},
+        {"async-load", bench_async_load},
+        {"batch", bench_batch},
+        {"cfg", bench_cfg},
+        {"attributes", bench_attributes},
+        {"constant-pool", bench_constant_pool},
+        {"decode", bench_decode},
+        {"frames", bench_frames},
+        {"instructions", bench_instructions},
+        {"interpreter", bench_interpreter},
+        {"load", bench_load},
+        {"lookup", bench_lookup},
+        {"member-refs", bench_member_refs},
+        {"options", bench_options},
+        {"reuse", bench_reuse},
+        {"scan", bench_scan},
+        {"shared", bench_shared},
+        {"symbols", bench_symbols},
+        {"utf8", bench_utf8},
+        {"visitor", bench_visitor},
+    };
+
+    if (argc < 3 || benchmarks.find(argv[1]) == benchmarks.end()) {
+        std::cerr << "Usage: " << argv[0] << " <benchmark> <class-dir> [iterations]" << std::endl;
+        std::cerr << "Benchmarks:";
+        for (const auto &[name, fn]: benchmarks) {
+            std::cerr << " " << name;
+        }
+        std::cerr << std::endl;
+        return 1;
+    }
+
+    const int iterations = argc > 3 ? std::atoi(argv[3]) : 5;
+    try {
+        const Corpus corpus = collect_corpus(argv[2]);
+        std::cout << "Corpus: " << corpus.files.size() << " classes, "
+                << corpus.total_bytes / 1024 << " KB" << std::endl;
+        benchmarks.at(argv[1])(corpus, iterations);
+    } catch (const std::exception &e) {
+        std::cerr << "Error execution: " << e.what() << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,269 @@
+#include "stack_map_table.h"
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+
+namespace {
+    struct Reader {
+        std::span<const uint8_t> data;
+        size_t offset = 0;
+
+        void require(const size_t count) const {
+            if (offset + count > data.size()) {
+                throw std::runtime_error("Truncated StackMapTable at byte " + std::to_string(offset));
+            }
+        }
+
+        uint8_t u1() {
+            require(1);
+            return data[offset++];
+        }
+
+        uint16_t u2() {
+            require(2);
+            const uint16_t value = static_cast<uint16_t>(data[offset] << 8 | data[offset + 1]);
+            offset += 2;
+            return value;
+        }
+    };
+
+    const char *frame_kind_name(const StackMapTable::FrameKind kind) {
+        switch (kind) {
+            case StackMapTable::FRAME_INITIAL: return "initial";
+            case StackMapTable::FRAME_SAME: return "same";
+            case StackMapTable::FRAME_SAME_LOCALS_1_STACK_ITEM: return "same_locals_1_stack_item";
+            case StackMapTable::FRAME_CHOP: return "chop";
+            case StackMapTable::FRAME_APPEND: return "append";
+            case StackMapTable::FRAME_FULL: return "full";
+        }
+        return "unknown";
+    }
+
+    void append_types(std::ostringstream &oss, const std::span<const StackMapTable::VerificationType> types) {
+        oss << "[";
+        for (size_t i = 0; i < types.size(); ++i) {
+            if (i != 0) oss << ", ";
+            oss << types[i].to_string();
+        }
+        oss << "]";
+    }
+}
+
+std::string StackMapTable::VerificationType::to_string() const {
+    switch (tag) {
+        case ITEM_TOP: return "top";
+        case ITEM_INTEGER: return "int";
+        case ITEM_FLOAT: return "float";
+        case ITEM_DOUBLE: return "double";
+        case ITEM_LONG: return "long";
+        case ITEM_NULL: return "null";
+        case ITEM_UNINITIALIZED_THIS: return "uninitializedThis";
+        case ITEM_OBJECT: return std::string(class_name);
+        case ITEM_UNINITIALIZED: return "uninitialized(" + std::to_string(value) + ")";
+    }
+    return "unknown";
+}
+
+StackMapTable::StackMapTable(const ClassParser &parser, const ClassParser::MethodInfo &method) {
+    if (!method.code_attribute) {
+        throw std::runtime_error("Method has no Code attribute: " + std::string(method.name) +
+                                 std::string(method.descriptor));
+    }
+    if (parser.get_options() & ClassParser::PARSE_SKIP_FRAMES) {
+        throw std::runtime_error("StackMapTable was skipped while parsing");
+    }
+    add_initial_frame(parser, method);
+    for (const ClassParser::CodeAttribute::AttributeInfo &attribute: method.code_attribute->attributes) {
+        if (parser.attribute_kind(attribute.name_index) == ClassParser::SpecializedAttribute::STACK_MAP_TABLE) {
+            decode(parser, attribute.bytes(), method.code_attribute->bytecode().size());
+            break;
+        }
+    }
+}
+
+void StackMapTable::add_initial_frame(const ClassParser &parser, const ClassParser::MethodInfo &method) {
+    if (!(method.access_flags & ClassParser::ACC_STATIC)) {
+        if (method.name == "<init>" && parser.get_class_name() != "java/lang/Object") {
+            types.push_back({ITEM_UNINITIALIZED_THIS, 0, {}});
+        } else {
+            types.push_back({ITEM_OBJECT, 0, parser.get_class_name()});
+        }
+    }
+
+    const std::string_view descriptor = method.descriptor;
+    if (descriptor.empty() || descriptor[0] != '(') {
+        throw std::runtime_error("Invalid method descriptor: " + std::string(descriptor));
+    }
+    size_t i = 1;
+    while (i < descriptor.size() && descriptor[i] != ')') {
+        const size_t start = i;
+        while (i < descriptor.size() && descriptor[i] == '[') ++i;
+        if (i < descriptor.size() && descriptor[i] == 'L') {
+            i = descriptor.find(';', i);
+            if (i == std::string_view::npos) break;
+        }
+        if (i >= descriptor.size()) break;
+        ++i;
+        if (i - start > 1) {
+            // Arrays keep their descriptor as the class name; plain classes drop the L and ;.
+            const bool is_array = descriptor[start] == '[';
+            types.push_back({ITEM_OBJECT, 0, is_array
+                                                 ? descriptor.substr(start, i - start)
+                                                 : descriptor.substr(start + 1, i - start - 2)});
+            continue;
+        }
+        switch (descriptor[start]) {
+            case 'B':
+            case 'C':
+            case 'I':
+            case 'S':
+            case 'Z':
+                types.push_back({ITEM_INTEGER, 0, {}});
+                break;
+            case 'F':
+                types.push_back({ITEM_FLOAT, 0, {}});
+                break;
+            case 'J':
+                types.push_back({ITEM_LONG, 0, {}});
+                break;
+            case 'D':
+                types.push_back({ITEM_DOUBLE, 0, {}});
+                break;
+            default:
+                throw std::runtime_error("Invalid method descriptor: " + std::string(descriptor));
+        }
+    }
+    if (i >= descriptor.size()) {
+        throw std::runtime_error("Invalid method descriptor: " + std::string(descriptor));
+    }
+
+    Frame &frame = frames.emplace_back();
+    frame.locals_count = static_cast<uint16_t>(types.size());
+    frame.stack_begin = static_cast<uint32_t>(types.size());
+}
+
+void StackMapTable::decode(const ClassParser &parser, const std::span<const uint8_t> data,
+                           const size_t code_length) {
+    Reader reader{data};
+    const auto read_type = [&] {
+        VerificationType type;
+        const uint8_t tag = reader.u1();
+        if (tag > ITEM_UNINITIALIZED) {
+            throw std::runtime_error("Invalid verification type tag " + std::to_string(tag));
+        }
+        type.tag = static_cast<Tag>(tag);
+        if (type.tag == ITEM_OBJECT) {
+            type.value = reader.u2();
+            type.class_name = parser.get_class_name_view(type.value);
+        } else if (type.tag == ITEM_UNINITIALIZED) {
+            type.value = reader.u2();
+        }
+        types.push_back(type);
+    };
+    const auto read_types = [&](const size_t count) {
+        for (size_t i = 0; i < count; ++i) {
+            read_type();
+        }
+    };
+
+    const uint16_t count = reader.u2();
+    frames.reserve(frames.size() + count);
+    for (uint16_t n = 0; n < count; ++n) {
+        const Frame previous = frames.back();
+        const uint8_t frame_type = reader.u1();
+        Frame frame;
+        frame.frame_type = frame_type;
+        frame.locals_begin = previous.locals_begin;
+        frame.locals_count = previous.locals_count;
+
+        uint16_t offset_delta;
+        if (frame_type < 64) {
+            frame.kind = FRAME_SAME;
+            offset_delta = frame_type;
+        } else if (frame_type < 128) {
+            frame.kind = FRAME_SAME_LOCALS_1_STACK_ITEM;
+            offset_delta = frame_type - 64;
+        } else if (frame_type < 247) {
+            throw std::runtime_error("Reserved stack map frame type " + std::to_string(frame_type));
+        } else if (frame_type == 247) {
+            frame.kind = FRAME_SAME_LOCALS_1_STACK_ITEM;
+            offset_delta = reader.u2();
+        } else if (frame_type < 251) {
+            frame.kind = FRAME_CHOP;
+            offset_delta = reader.u2();
+            const uint16_t chopped = 251 - frame_type;
+            if (chopped > previous.locals_count) {
+                throw std::runtime_error("Chop frame removes more locals than the previous frame has");
+            }
+            frame.locals_count = previous.locals_count - chopped;
+        } else if (frame_type == 251) {
+            frame.kind = FRAME_SAME;
+            offset_delta = reader.u2();
+        } else if (frame_type < 255) {
+            frame.kind = FRAME_APPEND;
+            offset_delta = reader.u2();
+            // Extends the previous slice in place when it is the last thing in the array.
+            if (previous.locals_begin + previous.locals_count != types.size()) {
+                frame.locals_begin = static_cast<uint32_t>(types.size());
+                for (uint32_t i = 0; i < previous.locals_count; ++i) {
+                    types.push_back(types[previous.locals_begin + i]);
+                }
+            }
+            read_types(frame_type - 251);
+            frame.locals_count = static_cast<uint16_t>(types.size() - frame.locals_begin);
+        } else {
+            frame.kind = FRAME_FULL;
+            offset_delta = reader.u2();
+            frame.locals_begin = static_cast<uint32_t>(types.size());
+            frame.locals_count = reader.u2();
+            read_types(frame.locals_count);
+        }
+
+        frame.stack_begin = static_cast<uint32_t>(types.size());
+        if (frame.kind == FRAME_SAME_LOCALS_1_STACK_ITEM) {
+            frame.stack_count = 1;
+            read_type();
+        } else if (frame.kind == FRAME_FULL) {
+            frame.stack_count = reader.u2();
+            read_types(frame.stack_count);
+        }
+
+        // The first explicit frame's delta is its pc; later ones count from the previous frame plus one.
+        frame.pc = n == 0 ? offset_delta : previous.pc + offset_delta + 1;
+        if (frame.pc >= code_length) {
+            throw std::runtime_error("Stack map frame at pc " + std::to_string(frame.pc) + " is outside the code");
+        }
+        frames.push_back(frame);
+    }
+}
+
+const StackMapTable::Frame *StackMapTable::find_frame(const uint32_t pc) const {
+    const Frame &frame = nearest_frame(pc);
+    return frame.pc == pc ? &frame : nullptr;
+}
+
+const StackMapTable::Frame &StackMapTable::nearest_frame(const uint32_t pc) const {
+    const auto it = std::upper_bound(frames.begin(), frames.end(), pc, [](const uint32_t value, const Frame &frame) {
+        return value < frame.pc;
+    });
+    return *(it - 1);
+}
+
+std::string StackMapTable::to_string(const Frame &frame) const {
+    std::ostringstream oss;
+    oss << frame.pc << ": " << frame_kind_name(frame.kind) << " locals=";
+    append_types(oss, get_locals(frame));
+    oss << " stack=";
+    append_types(oss, get_stack(frame));
+    return oss.str();
+}
+
+std::string StackMapTable::to_string() const {
+    std::ostringstream oss;
+    oss << "StackMapTable[" << frames.size() - 1 << " frames, " << types.size() << " types]\n";
+    for (const Frame &frame: frames) {
+        oss << "  " << to_string(frame) << "\n";
+    }
+    return oss.str();
+}
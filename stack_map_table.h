@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "class_parser.h"
+
+// A method's StackMapTable with every delta-encoded frame expanded once. Frames are sorted by pc
+// and start with the implicit frame the JVM derives from the method descriptor, so a lookup is a
+// binary search. All verification types live in one array; frames refer to slices of it, and a
+// frame that keeps, chops or extends its predecessor's locals reuses that slice.
+class StackMapTable {
+public:
+    enum Tag : uint8_t {
+        ITEM_TOP = 0,
+        ITEM_INTEGER = 1,
+        ITEM_FLOAT = 2,
+        ITEM_DOUBLE = 3,
+        ITEM_LONG = 4,
+        ITEM_NULL = 5,
+        ITEM_UNINITIALIZED_THIS = 6,
+        ITEM_OBJECT = 7,
+        ITEM_UNINITIALIZED = 8,
+    };
+
+    struct VerificationType {
+        Tag tag = ITEM_TOP;
+        // The Class constant for ITEM_OBJECT, or 0 when the type comes from the method descriptor;
+        // the offset of the new instruction for ITEM_UNINITIALIZED.
+        uint16_t value = 0;
+        std::string_view class_name;
+
+        std::string to_string() const;
+    };
+
+    enum FrameKind : uint8_t {
+        FRAME_INITIAL,
+        FRAME_SAME,
+        FRAME_SAME_LOCALS_1_STACK_ITEM,
+        FRAME_CHOP,
+        FRAME_APPEND,
+        FRAME_FULL,
+    };
+
+    // Locals are listed as in the class file: a long or double is one entry covering two slots.
+    struct Frame {
+        uint32_t pc = 0;
+        FrameKind kind = FRAME_INITIAL;
+        uint8_t frame_type = 0;
+        uint16_t locals_count = 0;
+        uint16_t stack_count = 0;
+        uint32_t locals_begin = 0;
+        uint32_t stack_begin = 0;
+    };
+
+    // The parser must still hold the method and must not have been run with PARSE_SKIP_FRAMES.
+    StackMapTable(const ClassParser &parser, const ClassParser::MethodInfo &method);
+
+    size_t size() const { return frames.size(); }
+    const std::vector<Frame> &get_frames() const { return frames; }
+    size_t get_type_count() const { return types.size(); }
+
+    std::span<const VerificationType> get_locals(const Frame &frame) const {
+        return {types.data() + frame.locals_begin, frame.locals_count};
+    }
+
+    std::span<const VerificationType> get_stack(const Frame &frame) const {
+        return {types.data() + frame.stack_begin, frame.stack_count};
+    }
+
+    // The frame recorded for pc, or nullptr when there is none.
+    const Frame *find_frame(uint32_t pc) const;
+    // The last frame at or before pc; the implicit initial frame when nothing else precedes it.
+    const Frame &nearest_frame(uint32_t pc) const;
+
+    std::string to_string(const Frame &frame) const;
+    std::string to_string() const;
+
+private:
+    std::vector<VerificationType> types;
+    std::vector<Frame> frames;
+
+    void add_initial_frame(const ClassParser &parser, const ClassParser::MethodInfo &method);
+    void decode(const ClassParser &parser, std::span<const uint8_t> data, size_t code_length);
+};
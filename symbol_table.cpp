@@ -0,0 +1,129 @@
+#include "symbol_table.h"
+
+#include <bit>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+
+SymbolTable::SymbolTable() : shards(new Shard[SHARD_COUNT]) {
+}
+
+SymbolTable::~SymbolTable() {
+    for (unsigned s = 0; s < SHARD_COUNT; ++s) {
+        for (auto &block: shards[s].blocks) {
+            delete[] block.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+unsigned SymbolTable::shard_of(const size_t hash) {
+    return static_cast<unsigned>(hash >> (sizeof(size_t) * 8 - SHARD_BITS)) & (SHARD_COUNT - 1);
+}
+
+// Block b holds entries [BLOCK_BASE * (2^b - 1), BLOCK_BASE * (2^(b+1) - 1)).
+void SymbolTable::locate(const uint32_t local, unsigned &block, uint32_t &offset) {
+    block = std::bit_width(local / BLOCK_BASE + 1) - 1;
+    offset = local - BLOCK_BASE * ((1u << block) - 1);
+}
+
+std::string_view SymbolTable::Shard::store(const std::string_view text) {
+    if (text.size() > CHUNK_SIZE / 4) {
+        chunks.emplace_back(new char[text.size()]);
+        std::memcpy(chunks.back().get(), text.data(), text.size());
+        text_bytes += text.size();
+        return {chunks.back().get(), text.size()};
+    }
+    if (chunk_used + text.size() > CHUNK_SIZE) {
+        chunks.emplace_back(new char[CHUNK_SIZE]);
+        chunk_used = 0;
+    }
+    char *out = chunks.back().get() + chunk_used;
+    std::memcpy(out, text.data(), text.size());
+    chunk_used += text.size();
+    text_bytes += text.size();
+    return {out, text.size()};
+}
+
+SymbolTable::Symbol SymbolTable::intern(const std::string_view text) {
+    const size_t hash = std::hash<std::string_view>()(text);
+    const unsigned s = shard_of(hash);
+    Shard &shard = shards[s];
+    {
+        std::shared_lock lock(shard.mutex);
+        if (const auto it = shard.index.find(text); it != shard.index.end()) {
+            return it->second;
+        }
+    }
+
+    std::unique_lock lock(shard.mutex);
+    if (const auto it = shard.index.find(text); it != shard.index.end()) {
+        return it->second;
+    }
+    const uint32_t local = shard.count;
+    if (local >= (UINT32_MAX >> SHARD_BITS) - 1) {
+        throw std::runtime_error("Symbol table shard is full");
+    }
+    unsigned block;
+    uint32_t offset;
+    locate(local, block, offset);
+    std::string_view *entries = shard.blocks[block].load(std::memory_order_relaxed);
+    if (entries == nullptr) {
+        entries = new std::string_view[static_cast<size_t>(BLOCK_BASE) << block];
+        shard.blocks[block].store(entries, std::memory_order_release);
+    }
+
+    const std::string_view stored = shard.store(text);
+    entries[offset] = stored;
+    shard.count++;
+
+    const Symbol symbol = (local << SHARD_BITS | s) + 1;
+    shard.index.emplace(stored, symbol);
+    return symbol;
+}
+
+SymbolTable::Symbol SymbolTable::find(const std::string_view text) const {
+    const Shard &shard = shards[shard_of(std::hash<std::string_view>()(text))];
+    std::shared_lock lock(shard.mutex);
+    const auto it = shard.index.find(text);
+    return it == shard.index.end() ? NO_SYMBOL : it->second;
+}
+
+// Symbols come from intern() or find(), whose locking orders the entry write before this read.
+std::string_view SymbolTable::text(const Symbol symbol) const {
+    if (symbol == NO_SYMBOL) {
+        return {};
+    }
+    const Shard &shard = shards[(symbol - 1) & (SHARD_COUNT - 1)];
+    unsigned block;
+    uint32_t offset;
+    locate((symbol - 1) >> SHARD_BITS, block, offset);
+    const std::string_view *entries = block < MAX_BLOCKS ? shard.blocks[block].load(std::memory_order_acquire) : nullptr;
+    if (entries == nullptr) {
+        throw std::runtime_error("Invalid symbol: " + std::to_string(symbol));
+    }
+    return entries[offset];
+}
+
+size_t SymbolTable::size() const {
+    size_t total = 0;
+    for (unsigned s = 0; s < SHARD_COUNT; ++s) {
+        std::shared_lock lock(shards[s].mutex);
+        total += shards[s].count;
+    }
+    return total;
+}
+
+size_t SymbolTable::memory_usage() const {
+    size_t total = 0;
+    for (unsigned s = 0; s < SHARD_COUNT; ++s) {
+        const Shard &shard = shards[s];
+        std::shared_lock lock(shard.mutex);
+        total += shard.text_bytes + shard.index.size() * (sizeof(std::string_view) + sizeof(Symbol) + 2 * sizeof(void *));
+        for (unsigned b = 0; b < MAX_BLOCKS; ++b) {
+            if (shard.blocks[b].load(std::memory_order_relaxed) != nullptr) {
+                total += (static_cast<size_t>(BLOCK_BASE) << b) * sizeof(std::string_view);
+            }
+        }
+    }
+    return total;
+}
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <shared_mutex>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// Thread-safe string interner shared across parsed classes. Symbols are never removed, so a
+// symbol's text stays valid for the lifetime of the table and equal strings compare as equal ids.
+class SymbolTable {
+public:
+    typedef uint32_t Symbol;
+
+    static constexpr Symbol NO_SYMBOL = 0;
+
+    SymbolTable();
+    ~SymbolTable();
+
+    SymbolTable(const SymbolTable &) = delete;
+    SymbolTable &operator=(const SymbolTable &) = delete;
+
+    Symbol intern(std::string_view text);
+    Symbol find(std::string_view text) const;
+    std::string_view text(Symbol symbol) const;
+
+    size_t size() const;
+    size_t memory_usage() const;
+
+private:
+    static constexpr unsigned SHARD_BITS = 4;
+    static constexpr unsigned SHARD_COUNT = 1u << SHARD_BITS;
+    static constexpr unsigned BLOCK_BASE = 256;
+    static constexpr unsigned MAX_BLOCKS = 32 - SHARD_BITS;
+    static constexpr size_t CHUNK_SIZE = 64 * 1024;
+
+    // Entries live in blocks of doubling size that never move, so text() reads them without
+    // taking the shard lock. Blocks are published with release stores once allocated.
+    struct alignas(64) Shard {
+        mutable std::shared_mutex mutex;
+        std::unordered_map<std::string_view, Symbol> index;
+        std::atomic<std::string_view *> blocks[MAX_BLOCKS] = {};
+        uint32_t count = 0;
+        std::vector<std::unique_ptr<char[]> > chunks;
+        size_t chunk_used = CHUNK_SIZE;
+        size_t text_bytes = 0;
+
+        std::string_view store(std::string_view text);
+    };
+
+    std::unique_ptr<Shard[]> shards;
+
+    static unsigned shard_of(size_t hash);
+    static void locate(uint32_t local, unsigned &block, uint32_t &offset);
+};
@@ -0,0 +1,1313 @@
+#include "virtual_machine.h"
+
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "bytecode.h"
+
+// Threaded dispatch jumps straight from one handler to the next through a table of label
+// addresses; other compilers get an equivalent switch.
+#if defined(__GNUC__)
+#define VM_THREADED_DISPATCH 1
+#else
+#define VM_THREADED_DISPATCH 0
+#endif
+
+// Every opcode the interpreter handles. The rest dispatch to the unsupported handler.
+#define VM_OPCODES(X) \
+    X(OP_NOP) X(OP_ACONST_NULL) X(OP_ICONST_M1) X(OP_ICONST_0) X(OP_ICONST_1) X(OP_ICONST_2) X(OP_ICONST_3) \
+    X(OP_ICONST_4) X(OP_ICONST_5) X(OP_LCONST_0) X(OP_LCONST_1) X(OP_FCONST_0) X(OP_FCONST_1) X(OP_FCONST_2) \
+    X(OP_DCONST_0) X(OP_DCONST_1) X(OP_BIPUSH) X(OP_SIPUSH) X(OP_LDC) X(OP_LDC_W) X(OP_LDC2_W) \
+    X(OP_ILOAD) X(OP_LLOAD) X(OP_FLOAD) X(OP_DLOAD) X(OP_ALOAD) \
+    X(OP_ILOAD_0) X(OP_ILOAD_1) X(OP_ILOAD_2) X(OP_ILOAD_3) X(OP_LLOAD_0) X(OP_LLOAD_1) X(OP_LLOAD_2) \
+    X(OP_LLOAD_3) X(OP_FLOAD_0) X(OP_FLOAD_1) X(OP_FLOAD_2) X(OP_FLOAD_3) X(OP_DLOAD_0) X(OP_DLOAD_1) \
+    X(OP_DLOAD_2) X(OP_DLOAD_3) X(OP_ALOAD_0) X(OP_ALOAD_1) X(OP_ALOAD_2) X(OP_ALOAD_3) \
+    X(OP_IALOAD) X(OP_LALOAD) X(OP_FALOAD) X(OP_DALOAD) X(OP_AALOAD) X(OP_BALOAD) X(OP_CALOAD) X(OP_SALOAD) \
+    X(OP_ISTORE) X(OP_LSTORE) X(OP_FSTORE) X(OP_DSTORE) X(OP_ASTORE) \
+    X(OP_ISTORE_0) X(OP_ISTORE_1) X(OP_ISTORE_2) X(OP_ISTORE_3) X(OP_LSTORE_0) X(OP_LSTORE_1) X(OP_LSTORE_2) \
+    X(OP_LSTORE_3) X(OP_FSTORE_0) X(OP_FSTORE_1) X(OP_FSTORE_2) X(OP_FSTORE_3) X(OP_DSTORE_0) X(OP_DSTORE_1) \
+    X(OP_DSTORE_2) X(OP_DSTORE_3) X(OP_ASTORE_0) X(OP_ASTORE_1) X(OP_ASTORE_2) X(OP_ASTORE_3) \
+    X(OP_IASTORE) X(OP_LASTORE) X(OP_FASTORE) X(OP_DASTORE) X(OP_AASTORE) X(OP_BASTORE) X(OP_CASTORE) \
+    X(OP_SASTORE) \
+    X(OP_POP) X(OP_POP2) X(OP_DUP) X(OP_DUP_X1) X(OP_DUP_X2) X(OP_DUP2) X(OP_DUP2_X1) X(OP_DUP2_X2) X(OP_SWAP) \
+    X(OP_IADD) X(OP_LADD) X(OP_FADD) X(OP_DADD) X(OP_ISUB) X(OP_LSUB) X(OP_FSUB) X(OP_DSUB) \
+    X(OP_IMUL) X(OP_LMUL) X(OP_FMUL) X(OP_DMUL) X(OP_IDIV) X(OP_LDIV) X(OP_FDIV) X(OP_DDIV) \
+    X(OP_IREM) X(OP_LREM) X(OP_FREM) X(OP_DREM) X(OP_INEG) X(OP_LNEG) X(OP_FNEG) X(OP_DNEG) \
+    X(OP_ISHL) X(OP_LSHL) X(OP_ISHR) X(OP_LSHR) X(OP_IUSHR) X(OP_LUSHR) \
+    X(OP_IAND) X(OP_LAND) X(OP_IOR) X(OP_LOR) X(OP_IXOR) X(OP_LXOR) X(OP_IINC) \
+    X(OP_I2L) X(OP_I2F) X(OP_I2D) X(OP_L2I) X(OP_L2F) X(OP_L2D) X(OP_F2I) X(OP_F2L) X(OP_F2D) \
+    X(OP_D2I) X(OP_D2L) X(OP_D2F) X(OP_I2B) X(OP_I2C) X(OP_I2S) \
+    X(OP_LCMP) X(OP_FCMPL) X(OP_FCMPG) X(OP_DCMPL) X(OP_DCMPG) \
+    X(OP_IFEQ) X(OP_IFNE) X(OP_IFLT) X(OP_IFGE) X(OP_IFGT) X(OP_IFLE) \
+    X(OP_IF_ICMPEQ) X(OP_IF_ICMPNE) X(OP_IF_ICMPLT) X(OP_IF_ICMPGE) X(OP_IF_ICMPGT) X(OP_IF_ICMPLE) \
+    X(OP_IF_ACMPEQ) X(OP_IF_ACMPNE) X(OP_GOTO) X(OP_TABLESWITCH) X(OP_LOOKUPSWITCH) \
+    X(OP_IRETURN) X(OP_LRETURN) X(OP_FRETURN) X(OP_DRETURN) X(OP_ARETURN) X(OP_RETURN) \
+    X(OP_INVOKESTATIC) X(OP_NEWARRAY) X(OP_ANEWARRAY) X(OP_ARRAYLENGTH) X(OP_WIDE) X(OP_MULTIANEWARRAY) \
+    X(OP_IFNULL) X(OP_IFNONNULL) X(OP_GOTO_W)
+
+struct VirtualMachine::Class {
+    const ClassParser *parser;
+    // Resolved invokestatic targets by constant pool index.
+    std::vector<const Method *> static_calls;
+};
+
+struct VirtualMachine::Method {
+    Class *owner;
+    const ClassParser::MethodInfo *info;
+    const uint8_t *code;
+    uint16_t max_locals;
+    uint16_t max_stack;
+    uint16_t argument_slots;
+    uint8_t return_slots;
+};
+
+namespace {
+    uint16_t read_u2(const uint8_t *p) {
+        return static_cast<uint16_t>(p[0] << 8 | p[1]);
+    }
+
+    int16_t read_s2(const uint8_t *p) {
+        return static_cast<int16_t>(read_u2(p));
+    }
+
+    int32_t read_s4(const uint8_t *p) {
+        return static_cast<int32_t>(static_cast<uint32_t>(p[0]) << 24 | static_cast<uint32_t>(p[1]) << 16 |
+                                    static_cast<uint32_t>(p[2]) << 8 | p[3]);
+    }
+
+    // Java's saturating float-to-integer conversions.
+    template<typename Integer, typename Float>
+    Integer java_convert(const Float value) {
+        if (std::isnan(value)) {
+            return 0;
+        }
+        if (value >= static_cast<Float>(std::numeric_limits<Integer>::max())) {
+            return std::numeric_limits<Integer>::max();
+        }
+        if (value <= static_cast<Float>(std::numeric_limits<Integer>::min())) {
+            return std::numeric_limits<Integer>::min();
+        }
+        return static_cast<Integer>(value);
+    }
+
+    template<typename Float>
+    int32_t java_compare(const Float a, const Float b, const int32_t nan_result) {
+        if (a > b) return 1;
+        if (a == b) return 0;
+        if (a < b) return -1;
+        return nan_result;
+    }
+
+    size_t element_size(const VirtualMachine::ArrayType type) {
+        switch (type) {
+            case VirtualMachine::T_BOOLEAN:
+            case VirtualMachine::T_BYTE:
+                return 1;
+            case VirtualMachine::T_CHAR:
+            case VirtualMachine::T_SHORT:
+                return 2;
+            case VirtualMachine::T_FLOAT:
+            case VirtualMachine::T_INT:
+            case VirtualMachine::T_REFERENCE:
+                return 4;
+            case VirtualMachine::T_DOUBLE:
+            case VirtualMachine::T_LONG:
+                return 8;
+        }
+        throw std::runtime_error("Invalid array type " + std::to_string(type));
+    }
+
+    VirtualMachine::ArrayType array_type_for(const char descriptor) {
+        switch (descriptor) {
+            case 'Z': return VirtualMachine::T_BOOLEAN;
+            case 'C': return VirtualMachine::T_CHAR;
+            case 'F': return VirtualMachine::T_FLOAT;
+            case 'D': return VirtualMachine::T_DOUBLE;
+            case 'B': return VirtualMachine::T_BYTE;
+            case 'S': return VirtualMachine::T_SHORT;
+            case 'I': return VirtualMachine::T_INT;
+            case 'J': return VirtualMachine::T_LONG;
+            default: return VirtualMachine::T_REFERENCE;
+        }
+    }
+
+    std::string method_name(const ClassParser &parser, const ClassParser::MethodInfo &method) {
+        return std::string(parser.get_class_name()) + "." + std::string(method.name) + std::string(method.descriptor);
+    }
+
+    // Local variable slots an instruction reads or writes, as (first, count); count is 0 for none.
+    std::pair<uint32_t, uint32_t> local_slots(const Bytecode::Instruction &instruction) {
+        const uint8_t opcode = instruction.get_opcode();
+        const auto width = [](const int group) { return group == 1 || group == 3 ? 2u : 1u; };
+        if (opcode >= Bytecode::OP_ILOAD_0 && opcode <= Bytecode::OP_ALOAD_3) {
+            const int n = opcode - Bytecode::OP_ILOAD_0;
+            return {n % 4, width(n / 4)};
+        }
+        if (opcode >= Bytecode::OP_ISTORE_0 && opcode <= Bytecode::OP_ASTORE_3) {
+            const int n = opcode - Bytecode::OP_ISTORE_0;
+            return {n % 4, width(n / 4)};
+        }
+        if (opcode >= Bytecode::OP_ILOAD && opcode <= Bytecode::OP_ALOAD) {
+            return {instruction.get_local_index(), width(opcode - Bytecode::OP_ILOAD)};
+        }
+        if (opcode >= Bytecode::OP_ISTORE && opcode <= Bytecode::OP_ASTORE) {
+            return {instruction.get_local_index(), width(opcode - Bytecode::OP_ISTORE)};
+        }
+        if (opcode == Bytecode::OP_IINC || opcode == Bytecode::OP_RET) {
+            return {instruction.get_local_index(), 1};
+        }
+        return {0, 0};
+    }
+
+    // Walks every reachable instruction once, checking that locals stay below max_locals, the
+    // operand stack within [0, max_stack] with one depth per pc, and control never leaves the code.
+    void verify(const ClassParser &parser, const ClassParser::MethodInfo &method) {
+        const ClassParser::CodeAttribute &code = *method.code_attribute;
+        const Bytecode bytecode(code);
+        const auto size = static_cast<uint32_t>(code.bytecode().size());
+        const auto fail = [&](const uint32_t pc, const std::string &message) {
+            throw std::runtime_error("VerifyError: " + message + " at pc " + std::to_string(pc) + " in " +
+                                     method_name(parser, method));
+        };
+        if (size == 0) {
+            fail(0, "empty code");
+        }
+
+        std::vector<int32_t> depths(size, -1);
+        std::vector<uint32_t> work;
+        const auto flow = [&](const uint32_t from, const int64_t target, const int32_t depth) {
+            if (target < 0 || target >= size) {
+                fail(from, "control leaves the code");
+            }
+            int32_t &known = depths[target];
+            if (known < 0) {
+                known = depth;
+                work.push_back(static_cast<uint32_t>(target));
+            } else if (known != depth) {
+                fail(static_cast<uint32_t>(target), "inconsistent stack depth");
+            }
+        };
+        flow(0, 0, 0);
+        while (!work.empty()) {
+            const uint32_t pc = work.back();
+            work.pop_back();
+            const Bytecode::Instruction instruction = bytecode.at(pc);
+            const auto [first_local, local_count] = local_slots(instruction);
+            if (local_count != 0 && first_local + local_count > code.max_locals) {
+                fail(pc, "local variable out of range");
+            }
+            const Bytecode::StackEffect effect = instruction.get_stack_effect(parser);
+            int32_t depth = depths[pc] - effect.pops;
+            if (depth < 0) {
+                fail(pc, "operand stack underflow");
+            }
+            depth += effect.pushes;
+            if (depth > code.max_stack) {
+                fail(pc, "operand stack overflow");
+            }
+
+            const uint8_t opcode = instruction.get_opcode();
+            switch (instruction.get_info().operand) {
+                case Bytecode::OPERAND_TABLESWITCH:
+                case Bytecode::OPERAND_LOOKUPSWITCH:
+                    flow(pc, static_cast<int64_t>(pc) + instruction.get_default_offset(), depth);
+                    for (uint32_t i = 0, count = instruction.get_case_count(); i < count; ++i) {
+                        flow(pc, static_cast<int64_t>(pc) + instruction.get_case_offset(i), depth);
+                    }
+                    continue;
+                case Bytecode::OPERAND_BRANCH:
+                case Bytecode::OPERAND_BRANCH_WIDE:
+                    // jsr is not interpreted, so nothing past it needs checking.
+                    if (opcode == Bytecode::OP_JSR || opcode == Bytecode::OP_JSR_W) continue;
+                    flow(pc, static_cast<int64_t>(pc) + instruction.get_branch_offset(), depth);
+                    if (opcode == Bytecode::OP_GOTO || opcode == Bytecode::OP_GOTO_W) continue;
+                    break;
+                default:
+                    if ((opcode >= Bytecode::OP_IRETURN && opcode <= Bytecode::OP_RETURN) ||
+                        opcode == Bytecode::OP_ATHROW || opcode == Bytecode::OP_RET) {
+                        continue;
+                    }
+                    break;
+            }
+            flow(pc, static_cast<int64_t>(pc) + instruction.get_length(), depth);
+        }
+    }
+
+#if VM_THREADED_DISPATCH
+#define VM_OPCODE_VALUE(op) Bytecode::op,
+    constexpr uint8_t THREADED_OPCODES[] = {VM_OPCODES(VM_OPCODE_VALUE)};
+#undef VM_OPCODE_VALUE
+
+    // handlers[0] is the unsupported handler, then one per entry of THREADED_OPCODES.
+    std::array<const void *, 256> make_dispatch_table(const void *const *handlers) {
+        std::array<const void *, 256> table;
+        table.fill(handlers[0]);
+        for (size_t i = 0; i < std::size(THREADED_OPCODES); ++i) {
+            table[THREADED_OPCODES[i]] = handlers[i + 1];
+        }
+        return table;
+    }
+#endif
+}
+
+VirtualMachine::VirtualMachine(const size_t stack_slots, const size_t heap_limit)
+    : stack(new Value[stack_slots]), stack_slots(stack_slots), heap_limit(heap_limit) {
+}
+
+VirtualMachine::~VirtualMachine() = default;
+
+void VirtualMachine::add_class(const ClassParser &parser) {
+    register_class(parser);
+}
+
+VirtualMachine::Class &VirtualMachine::register_class(const ClassParser &parser) {
+    auto [it, inserted] = classes.try_emplace(parser.get_class_name());
+    if (inserted) {
+        it->second = std::make_unique<Class>();
+        it->second->parser = &parser;
+        it->second->static_calls.assign(parser.get_constant_pool().size(), nullptr);
+    } else if (it->second->parser != &parser) {
+        throw std::runtime_error("Class already added: " + std::string(parser.get_class_name()));
+    }
+    return *it->second;
+}
+
+const VirtualMachine::Method &VirtualMachine::prepare(Class &owner, const ClassParser::MethodInfo &info) {
+    auto [it, inserted] = methods.try_emplace(&info);
+    if (!inserted) {
+        return *it->second;
+    }
+    try {
+        const ClassParser &parser = *owner.parser;
+        if (!(info.access_flags & ClassParser::ACC_STATIC)) {
+            throw std::runtime_error("Only static methods can run: " + method_name(parser, info));
+        }
+        if (!info.code_attribute) {
+            throw std::runtime_error("Method has no Code attribute: " + method_name(parser, info));
+        }
+        const int argument_slots = Bytecode::descriptor_slots(info.descriptor);
+        if (argument_slots > info.code_attribute->max_locals) {
+            throw std::runtime_error("VerifyError: arguments exceed max_locals in " + method_name(parser, info));
+        }
+        verify(parser, info);
+
+        auto method = std::make_unique<Method>();
+        method->owner = &owner;
+        method->info = &info;
+        method->code = info.code_attribute->bytecode().data();
+        method->max_locals = info.code_attribute->max_locals;
+        method->max_stack = info.code_attribute->max_stack;
+        method->argument_slots = static_cast<uint16_t>(argument_slots);
+        method->return_slots = static_cast<uint8_t>(Bytecode::return_slots(info.descriptor));
+        it->second = std::move(method);
+    } catch (...) {
+        methods.erase(it);
+        throw;
+    }
+    return *it->second;
+}
+
+const VirtualMachine::Method &VirtualMachine::resolve_static_call(Class &caller, const uint16_t index) {
+    const Method *&cached = caller.static_calls[index];
+    if (cached != nullptr) {
+        return *cached;
+    }
+    const ClassParser &parser = *caller.parser;
+    const uint8_t tag = parser.get_constant_pool().tag(index);
+    if (tag != ClassParser::CONSTANT_Methodref && tag != ClassParser::CONSTANT_InterfaceMethodref) {
+        throw std::runtime_error("invokestatic needs a method reference, found constant #" + std::to_string(index));
+    }
+    const ClassParser::MemberReference &method = parser.resolve_member_reference(index);
+    const std::string signature = std::string(method.owner) + "." + std::string(method.name) +
+                                  std::string(method.descriptor);
+    const auto owner = classes.find(method.owner);
+    if (owner == classes.end()) {
+        throw std::runtime_error("Unsupported call to " + signature + ": class not added");
+    }
+    const ClassParser::MethodInfo *callee = owner->second->parser->find_method(method.name, method.descriptor);
+    if (callee == nullptr) {
+        throw std::runtime_error("NoSuchMethodError: " + signature);
+    }
+    cached = &prepare(*owner->second, *callee);
+    return *cached;
+}
+
+void VirtualMachine::run_main(const ClassParser &parser) {
+    const ClassParser::MethodInfo *main = parser.find_main_method();
+    if (main == nullptr) {
+        throw std::runtime_error("No main(String[]) in " + std::string(parser.get_class_name()));
+    }
+    Value arguments[1];
+    arguments[0].a = new_array(T_REFERENCE, 0);
+    call(prepare(register_class(parser), *main), arguments);
+}
+
+VirtualMachine::Value VirtualMachine::invoke(const ClassParser &parser, const std::string_view name,
+                                             const std::string_view descriptor,
+                                             const std::span<const Value> arguments) {
+    const ClassParser::MethodInfo *method = parser.find_method(name, descriptor);
+    if (method == nullptr) {
+        throw std::runtime_error("NoSuchMethodError: " + std::string(parser.get_class_name()) + "." +
+                                 std::string(name) + std::string(descriptor));
+    }
+    return call(prepare(register_class(parser), *method), arguments);
+}
+
+VirtualMachine::Value VirtualMachine::call(const Method &method, const std::span<const Value> arguments) {
+    // Spread the arguments over slots, giving longs and doubles two each.
+    const std::string_view descriptor = method.info->descriptor;
+    size_t slot = 0;
+    size_t count = 0;
+    for (size_t i = 1; i < descriptor.size() && descriptor[i] != ')'; ++i, ++count) {
+        if (count >= arguments.size()) {
+            break;
+        }
+        const char type = descriptor[i];
+        while (descriptor[i] == '[') ++i;
+        if (descriptor[i] == 'L') i = descriptor.find(';', i);
+        stack[slot] = arguments[count];
+        slot += type == 'J' || type == 'D' ? 2 : 1;
+    }
+    if (slot != method.argument_slots || count != arguments.size()) {
+        throw std::runtime_error("Wrong number of arguments for " + method_name(*method.owner->parser, *method.info));
+    }
+    return execute(method, stack.get());
+}
+
+VirtualMachine::Reference VirtualMachine::new_array(const ArrayType type, const int32_t length) {
+    if (length < 0) {
+        throw std::runtime_error("NegativeArraySizeException: " + std::to_string(length));
+    }
+    const size_t bytes = sizeof(Array) + static_cast<size_t>(length) * element_size(type);
+    // The handle counts too, or empty arrays could grow the table past the limit.
+    if (bytes + sizeof(Array *) > heap_limit - heap_bytes || arrays.size() > std::numeric_limits<Reference>::max() - 1) {
+        throw std::runtime_error("OutOfMemoryError: array heap limit of " + std::to_string(heap_limit) +
+                                 " bytes reached");
+    }
+    void *memory = heap.allocate(bytes, alignof(int64_t));
+    std::memset(memory, 0, bytes);
+    Array *array = new(memory) Array{type, length};
+    heap_bytes += bytes + sizeof(Array *);
+    arrays.push_back(array);
+    return static_cast<Reference>(arrays.size() - 1);
+}
+
+VirtualMachine::Reference VirtualMachine::new_multi_array(const std::string_view descriptor,
+                                                          const std::span<const int32_t> counts) {
+    // descriptor is the element type after this level's '['.
+    if (counts.size() == 1) {
+        return new_array(descriptor[0] == '[' ? T_REFERENCE : array_type_for(descriptor[0]), counts[0]);
+    }
+    const Reference outer = new_array(T_REFERENCE, counts[0]);
+    for (int32_t i = 0; i < counts[0]; ++i) {
+        const Reference inner = new_multi_array(descriptor.substr(1), counts.subspan(1));
+        arrays[outer]->elements<Reference>()[i] = inner;
+    }
+    return outer;
+}
+
+const VirtualMachine::Array &VirtualMachine::get_array(const Reference reference) const {
+    if (reference == NULL_REFERENCE) {
+        throw std::runtime_error("NullPointerException");
+    }
+    if (reference >= arrays.size()) {
+        throw std::runtime_error("Invalid reference " + std::to_string(reference));
+    }
+    return *arrays[reference];
+}
+
+VirtualMachine::Array &VirtualMachine::get_array(const Reference reference) {
+    return const_cast<Array &>(std::as_const(*this).get_array(reference));
+}
+
+void VirtualMachine::release_arrays() {
+    arrays.resize(1);
+    heap.release();
+    heap_bytes = 0;
+}
+
+VirtualMachine::Value VirtualMachine::execute(const Method &method, Value *const locals) {
+    Value *const stack_base = locals + method.max_locals;
+    if (depth >= MAX_CALL_DEPTH || stack_base + method.max_stack > stack.get() + stack_slots) {
+        throw std::runtime_error("StackOverflowError in " + method_name(*method.owner->parser, *method.info));
+    }
+    for (Value *local = locals + method.argument_slots; local < stack_base; ++local) {
+        local->l = 0;
+    }
+
+    // Instructions run in this frame since the last flush into instruction_count.
+    uint64_t executed = 0;
+    struct Scope {
+        VirtualMachine &vm;
+        const uint64_t &executed;
+        ~Scope() {
+            vm.instruction_count += executed;
+            --vm.depth;
+        }
+    } scope{*this, executed};
+    ++depth;
+
+    Class &owner = *method.owner;
+    const ClassParser::ConstantPool &pool = owner.parser->get_constant_pool();
+    const uint8_t *const code = method.code;
+    const uint8_t *ip = code;
+    Value *sp = stack_base;
+
+    const auto fail = [&](const std::string &message) {
+        throw std::runtime_error(message + " at pc " + std::to_string(ip - code) + " in " +
+                                 method_name(*owner.parser, *method.info));
+    };
+    const auto check_limit = [&] {
+        if (instruction_count + executed > instruction_limit) {
+            fail("Instruction limit of " + std::to_string(instruction_limit) + " exceeded");
+        }
+    };
+    const auto array_at = [&](const Reference reference) -> Array & {
+        if (reference == NULL_REFERENCE) fail("NullPointerException");
+        if (reference >= arrays.size()) fail("Invalid reference " + std::to_string(reference));
+        return *arrays[reference];
+    };
+    // The element at index of an array whose type must be one of the two given.
+    const auto element = [&]<typename T>(const Reference reference, const int32_t index, const ArrayType type,
+                                         const ArrayType alternative) -> T & {
+        Array &array = array_at(reference);
+        if (array.type != type && array.type != alternative) fail("VerifyError: wrong array type");
+        if (static_cast<uint32_t>(index) >= static_cast<uint32_t>(array.length)) {
+            fail("ArrayIndexOutOfBoundsException: Index " + std::to_string(index) + " out of bounds for length " +
+                 std::to_string(array.length));
+        }
+        return array.elements<T>()[index];
+    };
+
+#define ELEMENT(T, reference, index, type, alternative) \
+    element.template operator()<T>(reference, index, type, alternative)
+#define BRANCH(condition) \
+    do { \
+        if (condition) { \
+            const int16_t offset = read_s2(ip + 1); \
+            if (offset <= 0) check_limit(); \
+            ip += offset; \
+        } else { \
+            ip += 3; \
+        } \
+        DISPATCH(); \
+    } while (0)
+
+#if VM_THREADED_DISPATCH
+#define VM_HANDLER_ADDRESS(op) &&target_##op,
+    static const void *const handlers[] = {&&unsupported, VM_OPCODES(VM_HANDLER_ADDRESS)};
+#undef VM_HANDLER_ADDRESS
+    static const std::array<const void *, 256> dispatch_table = make_dispatch_table(handlers);
+#define TARGET(op) target_##op
+#define DISPATCH() \
+    do { \
+        ++executed; \
+        goto *dispatch_table[*ip]; \
+    } while (0)
+    DISPATCH();
+#else
+#define TARGET(op) case Bytecode::op
+#define DISPATCH() \
+    do { \
+        ++executed; \
+        goto dispatch; \
+    } while (0)
+    ++executed;
+dispatch:
+    switch (*ip) {
+#endif
+
+    TARGET(OP_NOP):
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_ACONST_NULL):
+        (sp++)->a = NULL_REFERENCE;
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_ICONST_M1):
+    TARGET(OP_ICONST_0):
+    TARGET(OP_ICONST_1):
+    TARGET(OP_ICONST_2):
+    TARGET(OP_ICONST_3):
+    TARGET(OP_ICONST_4):
+    TARGET(OP_ICONST_5):
+        (sp++)->i = *ip - Bytecode::OP_ICONST_0;
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_LCONST_0):
+    TARGET(OP_LCONST_1):
+        sp->l = *ip - Bytecode::OP_LCONST_0;
+        sp += 2;
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_FCONST_0):
+    TARGET(OP_FCONST_1):
+    TARGET(OP_FCONST_2):
+        (sp++)->f = static_cast<float>(*ip - Bytecode::OP_FCONST_0);
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_DCONST_0):
+    TARGET(OP_DCONST_1):
+        sp->d = *ip - Bytecode::OP_DCONST_0;
+        sp += 2;
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_BIPUSH):
+        (sp++)->i = static_cast<int8_t>(ip[1]);
+        ip += 2;
+        DISPATCH();
+    TARGET(OP_SIPUSH):
+        (sp++)->i = read_s2(ip + 1);
+        ip += 3;
+        DISPATCH();
+    TARGET(OP_LDC):
+    TARGET(OP_LDC_W): {
+        const uint16_t index = *ip == Bytecode::OP_LDC ? ip[1] : read_u2(ip + 1);
+        if (pool.tag(index) == ClassParser::CONSTANT_Integer) {
+            (sp++)->i = static_cast<int32_t>(pool.int_bits(index));
+        } else if (pool.tag(index) == ClassParser::CONSTANT_Float) {
+            (sp++)->f = std::bit_cast<float>(pool.int_bits(index));
+        } else {
+            fail("Unsupported ldc of constant #" + std::to_string(index));
+        }
+        ip += *ip == Bytecode::OP_LDC ? 2 : 3;
+        DISPATCH();
+    }
+    TARGET(OP_LDC2_W): {
+        const uint16_t index = read_u2(ip + 1);
+        if (pool.tag(index) == ClassParser::CONSTANT_Long) {
+            sp->l = static_cast<int64_t>(pool.long_bits(index));
+        } else if (pool.tag(index) == ClassParser::CONSTANT_Double) {
+            sp->d = std::bit_cast<double>(pool.long_bits(index));
+        } else {
+            fail("Unsupported ldc2_w of constant #" + std::to_string(index));
+        }
+        sp += 2;
+        ip += 3;
+        DISPATCH();
+    }
+
+    TARGET(OP_ILOAD):
+    TARGET(OP_FLOAD):
+    TARGET(OP_ALOAD):
+        *sp++ = locals[ip[1]];
+        ip += 2;
+        DISPATCH();
+    TARGET(OP_LLOAD):
+    TARGET(OP_DLOAD):
+        *sp = locals[ip[1]];
+        sp += 2;
+        ip += 2;
+        DISPATCH();
+    TARGET(OP_ILOAD_0):
+    TARGET(OP_ILOAD_1):
+    TARGET(OP_ILOAD_2):
+    TARGET(OP_ILOAD_3):
+        *sp++ = locals[*ip - Bytecode::OP_ILOAD_0];
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_FLOAD_0):
+    TARGET(OP_FLOAD_1):
+    TARGET(OP_FLOAD_2):
+    TARGET(OP_FLOAD_3):
+        *sp++ = locals[*ip - Bytecode::OP_FLOAD_0];
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_ALOAD_0):
+    TARGET(OP_ALOAD_1):
+    TARGET(OP_ALOAD_2):
+    TARGET(OP_ALOAD_3):
+        *sp++ = locals[*ip - Bytecode::OP_ALOAD_0];
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_LLOAD_0):
+    TARGET(OP_LLOAD_1):
+    TARGET(OP_LLOAD_2):
+    TARGET(OP_LLOAD_3):
+        *sp = locals[*ip - Bytecode::OP_LLOAD_0];
+        sp += 2;
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_DLOAD_0):
+    TARGET(OP_DLOAD_1):
+    TARGET(OP_DLOAD_2):
+    TARGET(OP_DLOAD_3):
+        *sp = locals[*ip - Bytecode::OP_DLOAD_0];
+        sp += 2;
+        ip += 1;
+        DISPATCH();
+
+    TARGET(OP_ISTORE):
+    TARGET(OP_FSTORE):
+    TARGET(OP_ASTORE):
+        locals[ip[1]] = *--sp;
+        ip += 2;
+        DISPATCH();
+    TARGET(OP_LSTORE):
+    TARGET(OP_DSTORE):
+        sp -= 2;
+        locals[ip[1]] = *sp;
+        ip += 2;
+        DISPATCH();
+    TARGET(OP_ISTORE_0):
+    TARGET(OP_ISTORE_1):
+    TARGET(OP_ISTORE_2):
+    TARGET(OP_ISTORE_3):
+        locals[*ip - Bytecode::OP_ISTORE_0] = *--sp;
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_FSTORE_0):
+    TARGET(OP_FSTORE_1):
+    TARGET(OP_FSTORE_2):
+    TARGET(OP_FSTORE_3):
+        locals[*ip - Bytecode::OP_FSTORE_0] = *--sp;
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_ASTORE_0):
+    TARGET(OP_ASTORE_1):
+    TARGET(OP_ASTORE_2):
+    TARGET(OP_ASTORE_3):
+        locals[*ip - Bytecode::OP_ASTORE_0] = *--sp;
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_LSTORE_0):
+    TARGET(OP_LSTORE_1):
+    TARGET(OP_LSTORE_2):
+    TARGET(OP_LSTORE_3):
+        sp -= 2;
+        locals[*ip - Bytecode::OP_LSTORE_0] = *sp;
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_DSTORE_0):
+    TARGET(OP_DSTORE_1):
+    TARGET(OP_DSTORE_2):
+    TARGET(OP_DSTORE_3):
+        sp -= 2;
+        locals[*ip - Bytecode::OP_DSTORE_0] = *sp;
+        ip += 1;
+        DISPATCH();
+
+    TARGET(OP_IALOAD):
+        sp[-2].i = ELEMENT(int32_t, sp[-2].a, sp[-1].i, T_INT, T_INT);
+        sp -= 1;
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_LALOAD):
+        sp[-2].l = ELEMENT(int64_t, sp[-2].a, sp[-1].i, T_LONG, T_LONG);
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_FALOAD):
+        sp[-2].f = ELEMENT(float, sp[-2].a, sp[-1].i, T_FLOAT, T_FLOAT);
+        sp -= 1;
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_DALOAD):
+        sp[-2].d = ELEMENT(double, sp[-2].a, sp[-1].i, T_DOUBLE, T_DOUBLE);
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_AALOAD):
+        sp[-2].a = ELEMENT(Reference, sp[-2].a, sp[-1].i, T_REFERENCE, T_REFERENCE);
+        sp -= 1;
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_BALOAD):
+        sp[-2].i = ELEMENT(int8_t, sp[-2].a, sp[-1].i, T_BYTE, T_BOOLEAN);
+        sp -= 1;
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_CALOAD):
+        sp[-2].i = ELEMENT(uint16_t, sp[-2].a, sp[-1].i, T_CHAR, T_CHAR);
+        sp -= 1;
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_SALOAD):
+        sp[-2].i = ELEMENT(int16_t, sp[-2].a, sp[-1].i, T_SHORT, T_SHORT);
+        sp -= 1;
+        ip += 1;
+        DISPATCH();
+
+    TARGET(OP_IASTORE):
+        ELEMENT(int32_t, sp[-3].a, sp[-2].i, T_INT, T_INT) = sp[-1].i;
+        sp -= 3;
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_LASTORE):
+        ELEMENT(int64_t, sp[-4].a, sp[-3].i, T_LONG, T_LONG) = sp[-2].l;
+        sp -= 4;
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_FASTORE):
+        ELEMENT(float, sp[-3].a, sp[-2].i, T_FLOAT, T_FLOAT) = sp[-1].f;
+        sp -= 3;
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_DASTORE):
+        ELEMENT(double, sp[-4].a, sp[-3].i, T_DOUBLE, T_DOUBLE) = sp[-2].d;
+        sp -= 4;
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_AASTORE):
+        ELEMENT(Reference, sp[-3].a, sp[-2].i, T_REFERENCE, T_REFERENCE) = sp[-1].a;
+        sp -= 3;
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_BASTORE):
+        ELEMENT(int8_t, sp[-3].a, sp[-2].i, T_BYTE, T_BOOLEAN) = static_cast<int8_t>(sp[-1].i);
+        sp -= 3;
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_CASTORE):
+        ELEMENT(uint16_t, sp[-3].a, sp[-2].i, T_CHAR, T_CHAR) = static_cast<uint16_t>(sp[-1].i);
+        sp -= 3;
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_SASTORE):
+        ELEMENT(int16_t, sp[-3].a, sp[-2].i, T_SHORT, T_SHORT) = static_cast<int16_t>(sp[-1].i);
+        sp -= 3;
+        ip += 1;
+        DISPATCH();
+
+    TARGET(OP_POP):
+        sp -= 1;
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_POP2):
+        sp -= 2;
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_DUP):
+        sp[0] = sp[-1];
+        sp += 1;
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_DUP_X1): {
+        const Value v1 = sp[-1], v2 = sp[-2];
+        sp[-2] = v1;
+        sp[-1] = v2;
+        sp[0] = v1;
+        sp += 1;
+        ip += 1;
+        DISPATCH();
+    }
+    TARGET(OP_DUP_X2): {
+        const Value v1 = sp[-1], v2 = sp[-2], v3 = sp[-3];
+        sp[-3] = v1;
+        sp[-2] = v3;
+        sp[-1] = v2;
+        sp[0] = v1;
+        sp += 1;
+        ip += 1;
+        DISPATCH();
+    }
+    TARGET(OP_DUP2):
+        sp[0] = sp[-2];
+        sp[1] = sp[-1];
+        sp += 2;
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_DUP2_X1): {
+        const Value v1 = sp[-1], v2 = sp[-2], v3 = sp[-3];
+        sp[-3] = v2;
+        sp[-2] = v1;
+        sp[-1] = v3;
+        sp[0] = v2;
+        sp[1] = v1;
+        sp += 2;
+        ip += 1;
+        DISPATCH();
+    }
+    TARGET(OP_DUP2_X2): {
+        const Value v1 = sp[-1], v2 = sp[-2], v3 = sp[-3], v4 = sp[-4];
+        sp[-4] = v2;
+        sp[-3] = v1;
+        sp[-2] = v4;
+        sp[-1] = v3;
+        sp[0] = v2;
+        sp[1] = v1;
+        sp += 2;
+        ip += 1;
+        DISPATCH();
+    }
+    TARGET(OP_SWAP): {
+        const Value v1 = sp[-1];
+        sp[-1] = sp[-2];
+        sp[-2] = v1;
+        ip += 1;
+        DISPATCH();
+    }
+
+    // int and long arithmetic wraps like Java's, so it runs on unsigned values.
+    TARGET(OP_IADD):
+        sp[-2].i = static_cast<int32_t>(static_cast<uint32_t>(sp[-2].i) + static_cast<uint32_t>(sp[-1].i));
+        sp -= 1;
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_LADD):
+        sp[-4].l = static_cast<int64_t>(static_cast<uint64_t>(sp[-4].l) + static_cast<uint64_t>(sp[-2].l));
+        sp -= 2;
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_FADD):
+        sp[-2].f += sp[-1].f;
+        sp -= 1;
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_DADD):
+        sp[-4].d += sp[-2].d;
+        sp -= 2;
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_ISUB):
+        sp[-2].i = static_cast<int32_t>(static_cast<uint32_t>(sp[-2].i) - static_cast<uint32_t>(sp[-1].i));
+        sp -= 1;
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_LSUB):
+        sp[-4].l = static_cast<int64_t>(static_cast<uint64_t>(sp[-4].l) - static_cast<uint64_t>(sp[-2].l));
+        sp -= 2;
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_FSUB):
+        sp[-2].f -= sp[-1].f;
+        sp -= 1;
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_DSUB):
+        sp[-4].d -= sp[-2].d;
+        sp -= 2;
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_IMUL):
+        sp[-2].i = static_cast<int32_t>(static_cast<uint32_t>(sp[-2].i) * static_cast<uint32_t>(sp[-1].i));
+        sp -= 1;
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_LMUL):
+        sp[-4].l = static_cast<int64_t>(static_cast<uint64_t>(sp[-4].l) * static_cast<uint64_t>(sp[-2].l));
+        sp -= 2;
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_FMUL):
+        sp[-2].f *= sp[-1].f;
+        sp -= 1;
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_DMUL):
+        sp[-4].d *= sp[-2].d;
+        sp -= 2;
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_IDIV):
+        if (sp[-1].i == 0) fail("ArithmeticException: / by zero");
+        sp[-2].i = sp[-1].i == -1 ? static_cast<int32_t>(0u - static_cast<uint32_t>(sp[-2].i)) : sp[-2].i / sp[-1].i;
+        sp -= 1;
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_LDIV):
+        if (sp[-2].l == 0) fail("ArithmeticException: / by zero");
+        sp[-4].l = sp[-2].l == -1 ? static_cast<int64_t>(0u - static_cast<uint64_t>(sp[-4].l)) : sp[-4].l / sp[-2].l;
+        sp -= 2;
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_FDIV):
+        sp[-2].f /= sp[-1].f;
+        sp -= 1;
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_DDIV):
+        sp[-4].d /= sp[-2].d;
+        sp -= 2;
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_IREM):
+        if (sp[-1].i == 0) fail("ArithmeticException: / by zero");
+        sp[-2].i = sp[-1].i == -1 ? 0 : sp[-2].i % sp[-1].i;
+        sp -= 1;
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_LREM):
+        if (sp[-2].l == 0) fail("ArithmeticException: / by zero");
+        sp[-4].l = sp[-2].l == -1 ? 0 : sp[-4].l % sp[-2].l;
+        sp -= 2;
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_FREM):
+        sp[-2].f = std::fmod(sp[-2].f, sp[-1].f);
+        sp -= 1;
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_DREM):
+        sp[-4].d = std::fmod(sp[-4].d, sp[-2].d);
+        sp -= 2;
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_INEG):
+        sp[-1].i = static_cast<int32_t>(0u - static_cast<uint32_t>(sp[-1].i));
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_LNEG):
+        sp[-2].l = static_cast<int64_t>(0u - static_cast<uint64_t>(sp[-2].l));
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_FNEG):
+        sp[-1].f = -sp[-1].f;
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_DNEG):
+        sp[-2].d = -sp[-2].d;
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_ISHL):
+        sp[-2].i = static_cast<int32_t>(static_cast<uint32_t>(sp[-2].i) << (sp[-1].i & 0x1f));
+        sp -= 1;
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_LSHL):
+        sp[-3].l = static_cast<int64_t>(static_cast<uint64_t>(sp[-3].l) << (sp[-1].i & 0x3f));
+        sp -= 1;
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_ISHR):
+        sp[-2].i >>= sp[-1].i & 0x1f;
+        sp -= 1;
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_LSHR):
+        sp[-3].l >>= sp[-1].i & 0x3f;
+        sp -= 1;
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_IUSHR):
+        sp[-2].i = static_cast<int32_t>(static_cast<uint32_t>(sp[-2].i) >> (sp[-1].i & 0x1f));
+        sp -= 1;
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_LUSHR):
+        sp[-3].l = static_cast<int64_t>(static_cast<uint64_t>(sp[-3].l) >> (sp[-1].i & 0x3f));
+        sp -= 1;
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_IAND):
+        sp[-2].i &= sp[-1].i;
+        sp -= 1;
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_LAND):
+        sp[-4].l &= sp[-2].l;
+        sp -= 2;
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_IOR):
+        sp[-2].i |= sp[-1].i;
+        sp -= 1;
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_LOR):
+        sp[-4].l |= sp[-2].l;
+        sp -= 2;
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_IXOR):
+        sp[-2].i ^= sp[-1].i;
+        sp -= 1;
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_LXOR):
+        sp[-4].l ^= sp[-2].l;
+        sp -= 2;
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_IINC): {
+        Value &local = locals[ip[1]];
+        local.i = static_cast<int32_t>(static_cast<uint32_t>(local.i) + static_cast<int8_t>(ip[2]));
+        ip += 3;
+        DISPATCH();
+    }
+
+    TARGET(OP_I2L):
+        sp[-1].l = sp[-1].i;
+        sp += 1;
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_I2F):
+        sp[-1].f = static_cast<float>(sp[-1].i);
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_I2D):
+        sp[-1].d = sp[-1].i;
+        sp += 1;
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_L2I):
+        sp[-2].i = static_cast<int32_t>(sp[-2].l);
+        sp -= 1;
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_L2F):
+        sp[-2].f = static_cast<float>(sp[-2].l);
+        sp -= 1;
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_L2D):
+        sp[-2].d = static_cast<double>(sp[-2].l);
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_F2I):
+        sp[-1].i = java_convert<int32_t>(sp[-1].f);
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_F2L):
+        sp[-1].l = java_convert<int64_t>(sp[-1].f);
+        sp += 1;
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_F2D):
+        sp[-1].d = sp[-1].f;
+        sp += 1;
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_D2I):
+        sp[-2].i = java_convert<int32_t>(sp[-2].d);
+        sp -= 1;
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_D2L):
+        sp[-2].l = java_convert<int64_t>(sp[-2].d);
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_D2F):
+        sp[-2].f = static_cast<float>(sp[-2].d);
+        sp -= 1;
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_I2B):
+        sp[-1].i = static_cast<int8_t>(sp[-1].i);
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_I2C):
+        sp[-1].i = static_cast<uint16_t>(sp[-1].i);
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_I2S):
+        sp[-1].i = static_cast<int16_t>(sp[-1].i);
+        ip += 1;
+        DISPATCH();
+
+    TARGET(OP_LCMP):
+        sp[-4].i = sp[-4].l > sp[-2].l ? 1 : sp[-4].l == sp[-2].l ? 0 : -1;
+        sp -= 3;
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_FCMPL):
+    TARGET(OP_FCMPG):
+        sp[-2].i = java_compare(sp[-2].f, sp[-1].f, *ip == Bytecode::OP_FCMPL ? -1 : 1);
+        sp -= 1;
+        ip += 1;
+        DISPATCH();
+    TARGET(OP_DCMPL):
+    TARGET(OP_DCMPG):
+        sp[-4].i = java_compare(sp[-4].d, sp[-2].d, *ip == Bytecode::OP_DCMPL ? -1 : 1);
+        sp -= 3;
+        ip += 1;
+        DISPATCH();
+
+    TARGET(OP_IFEQ):
+        --sp;
+        BRANCH(sp->i == 0);
+    TARGET(OP_IFNE):
+        --sp;
+        BRANCH(sp->i != 0);
+    TARGET(OP_IFLT):
+        --sp;
+        BRANCH(sp->i < 0);
+    TARGET(OP_IFGE):
+        --sp;
+        BRANCH(sp->i >= 0);
+    TARGET(OP_IFGT):
+        --sp;
+        BRANCH(sp->i > 0);
+    TARGET(OP_IFLE):
+        --sp;
+        BRANCH(sp->i <= 0);
+    TARGET(OP_IF_ICMPEQ):
+        sp -= 2;
+        BRANCH(sp[0].i == sp[1].i);
+    TARGET(OP_IF_ICMPNE):
+        sp -= 2;
+        BRANCH(sp[0].i != sp[1].i);
+    TARGET(OP_IF_ICMPLT):
+        sp -= 2;
+        BRANCH(sp[0].i < sp[1].i);
+    TARGET(OP_IF_ICMPGE):
+        sp -= 2;
+        BRANCH(sp[0].i >= sp[1].i);
+    TARGET(OP_IF_ICMPGT):
+        sp -= 2;
+        BRANCH(sp[0].i > sp[1].i);
+    TARGET(OP_IF_ICMPLE):
+        sp -= 2;
+        BRANCH(sp[0].i <= sp[1].i);
+    TARGET(OP_IF_ACMPEQ):
+        sp -= 2;
+        BRANCH(sp[0].a == sp[1].a);
+    TARGET(OP_IF_ACMPNE):
+        sp -= 2;
+        BRANCH(sp[0].a != sp[1].a);
+    TARGET(OP_IFNULL):
+        --sp;
+        BRANCH(sp->a == NULL_REFERENCE);
+    TARGET(OP_IFNONNULL):
+        --sp;
+        BRANCH(sp->a != NULL_REFERENCE);
+    TARGET(OP_GOTO):
+        BRANCH(true);
+    TARGET(OP_GOTO_W): {
+        const int32_t offset = read_s4(ip + 1);
+        if (offset <= 0) check_limit();
+        ip += offset;
+        DISPATCH();
+    }
+    TARGET(OP_TABLESWITCH): {
+        const uint32_t pc = static_cast<uint32_t>(ip - code);
+        const uint8_t *table = code + ((pc + 4) & ~3u);
+        const int64_t index = static_cast<int64_t>((--sp)->i) - read_s4(table + 4);
+        const int64_t count = static_cast<int64_t>(read_s4(table + 8)) - read_s4(table + 4) + 1;
+        check_limit();
+        ip += index >= 0 && index < count ? read_s4(table + 12 + index * 4) : read_s4(table);
+        DISPATCH();
+    }
+    TARGET(OP_LOOKUPSWITCH): {
+        const uint32_t pc = static_cast<uint32_t>(ip - code);
+        const uint8_t *table = code + ((pc + 4) & ~3u);
+        const int32_t key = (--sp)->i;
+        // Pairs are sorted by key, so a binary search finds the match.
+        int32_t low = 0;
+        int32_t high = read_s4(table + 4) - 1;
+        int32_t offset = read_s4(table);
+        while (low <= high) {
+            const int32_t middle = low + (high - low) / 2;
+            const int32_t candidate = read_s4(table + 8 + middle * 8);
+            if (candidate < key) {
+                low = middle + 1;
+            } else if (candidate > key) {
+                high = middle - 1;
+            } else {
+                offset = read_s4(table + 12 + middle * 8);
+                break;
+            }
+        }
+        check_limit();
+        ip += offset;
+        DISPATCH();
+    }
+
+    TARGET(OP_IRETURN):
+    TARGET(OP_FRETURN):
+    TARGET(OP_ARETURN):
+        return sp[-1];
+    TARGET(OP_LRETURN):
+    TARGET(OP_DRETURN):
+        return sp[-2];
+    TARGET(OP_RETURN):
+        return Value{};
+
+    TARGET(OP_INVOKESTATIC): {
+        const Method &callee = resolve_static_call(owner, read_u2(ip + 1));
+        instruction_count += executed;
+        executed = 0;
+        check_limit();
+        sp -= callee.argument_slots;
+        const Value result = execute(callee, sp);
+        *sp = result;
+        sp += callee.return_slots;
+        ip += 3;
+        DISPATCH();
+    }
+
+    TARGET(OP_NEWARRAY): {
+        const uint8_t type = ip[1];
+        if (type < T_BOOLEAN || type > T_LONG) fail("Invalid newarray type " + std::to_string(type));
+        sp[-1].a = new_array(static_cast<ArrayType>(type), sp[-1].i);
+        ip += 2;
+        DISPATCH();
+    }
+    TARGET(OP_ANEWARRAY):
+        sp[-1].a = new_array(T_REFERENCE, sp[-1].i);
+        ip += 3;
+        DISPATCH();
+    TARGET(OP_MULTIANEWARRAY): {
+        const std::string_view descriptor = owner.parser->get_class_name_view(read_u2(ip + 1));
+        const uint8_t dimensions = ip[3];
+        if (dimensions == 0 || descriptor.size() <= dimensions ||
+            descriptor.find_first_not_of('[') < dimensions) {
+            fail("Invalid multianewarray of " + std::string(descriptor));
+        }
+        int32_t counts[255];
+        for (uint8_t i = 0; i < dimensions; ++i) {
+            counts[i] = sp[i - dimensions].i;
+            if (counts[i] < 0) fail("NegativeArraySizeException: " + std::to_string(counts[i]));
+        }
+        sp -= dimensions;
+        (sp++)->a = new_multi_array(descriptor.substr(1), std::span<const int32_t>(counts, dimensions));
+        ip += 4;
+        DISPATCH();
+    }
+    TARGET(OP_ARRAYLENGTH):
+        sp[-1].i = array_at(sp[-1].a).length;
+        ip += 1;
+        DISPATCH();
+
+    TARGET(OP_WIDE): {
+        const uint16_t index = read_u2(ip + 2);
+        switch (ip[1]) {
+            case Bytecode::OP_ILOAD:
+            case Bytecode::OP_FLOAD:
+            case Bytecode::OP_ALOAD:
+                *sp++ = locals[index];
+                break;
+            case Bytecode::OP_LLOAD:
+            case Bytecode::OP_DLOAD:
+                *sp = locals[index];
+                sp += 2;
+                break;
+            case Bytecode::OP_ISTORE:
+            case Bytecode::OP_FSTORE:
+            case Bytecode::OP_ASTORE:
+                locals[index] = *--sp;
+                break;
+            case Bytecode::OP_LSTORE:
+            case Bytecode::OP_DSTORE:
+                sp -= 2;
+                locals[index] = *sp;
+                break;
+            case Bytecode::OP_IINC:
+                locals[index].i = static_cast<int32_t>(static_cast<uint32_t>(locals[index].i) + read_s2(ip + 4));
+                ip += 2;
+                break;
+            default:
+                goto unsupported;
+        }
+        ip += 4;
+        DISPATCH();
+    }
+
+#if !VM_THREADED_DISPATCH
+    default:
+        goto unsupported;
+    }
+#endif
+
+unsupported:
+    fail("Unsupported instruction " + std::string(Bytecode::OPCODES[*ip].name));
+    return Value{};
+
+#undef ELEMENT
+#undef BRANCH
+#undef TARGET
+#undef DISPATCH
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <memory_resource>
+#include <span>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "class_parser.h"
+
+// Interprets static methods of parsed classes: int, long, float and double arithmetic, locals,
+// branches and switches, invokestatic between added classes, and primitive and reference arrays.
+// Anything else (objects, fields, strings, monitors, exception handlers) stops execution with a
+// std::runtime_error, as do Java runtime exceptions such as division by zero.
+//
+// Each method's stack depths and local indexes are checked before it first runs, and references
+// are handles into the machine's array table, so malformed bytecode cannot touch memory outside
+// the interpreter's own stack and heap.
+class VirtualMachine {
+public:
+    typedef uint32_t Reference;
+    static constexpr Reference NULL_REFERENCE = 0;
+
+    // One operand stack or local variable slot; a long or double fills the first of two slots.
+    union Value {
+        int32_t i;
+        int64_t l;
+        float f;
+        double d;
+        Reference a;
+    };
+
+    // newarray element types, plus T_REFERENCE for anewarray and multianewarray.
+    enum ArrayType : uint8_t {
+        T_REFERENCE = 0,
+        T_BOOLEAN = 4,
+        T_CHAR = 5,
+        T_FLOAT = 6,
+        T_DOUBLE = 7,
+        T_BYTE = 8,
+        T_SHORT = 9,
+        T_INT = 10,
+        T_LONG = 11,
+    };
+
+    struct Array {
+        ArrayType type;
+        int32_t length;
+
+        // Elements follow the header: int8_t for T_BOOLEAN and T_BYTE, uint16_t for T_CHAR,
+        // int16_t, int32_t, int64_t, float and double for the rest, Reference for T_REFERENCE.
+        template<typename T>
+        T *elements() { return reinterpret_cast<T *>(this + 1); }
+        template<typename T>
+        const T *elements() const { return reinterpret_cast<const T *>(this + 1); }
+    };
+
+    static constexpr size_t DEFAULT_STACK_SLOTS = 1 << 20;
+    static constexpr size_t DEFAULT_HEAP_LIMIT = 256 * 1024 * 1024;
+    static constexpr unsigned MAX_CALL_DEPTH = 1024;
+
+    explicit VirtualMachine(size_t stack_slots = DEFAULT_STACK_SLOTS, size_t heap_limit = DEFAULT_HEAP_LIMIT);
+    ~VirtualMachine();
+
+    VirtualMachine(const VirtualMachine &) = delete;
+    VirtualMachine &operator=(const VirtualMachine &) = delete;
+
+    // Makes the class's static methods callable. The parser must outlive the machine.
+    void add_class(const ClassParser &parser);
+
+    // Runs the class's main(String[]) with an empty argument array.
+    void run_main(const ClassParser &parser);
+    // Arguments take one Value each, longs and doubles included. Returns a zero Value for void.
+    Value invoke(const ClassParser &parser, std::string_view name, std::string_view descriptor,
+                 std::span<const Value> arguments = {});
+
+    Reference new_array(ArrayType type, int32_t length);
+    const Array &get_array(Reference reference) const;
+    Array &get_array(Reference reference);
+    // Frees every array; references handed out before become invalid.
+    void release_arrays();
+
+    // Execution stops with an error once this many instructions have run in total.
+    void set_instruction_limit(const uint64_t limit) { instruction_limit = limit; }
+    uint64_t get_instruction_count() const { return instruction_count; }
+    void reset_instruction_count() { instruction_count = 0; }
+
+private:
+    struct Class;
+    struct Method;
+
+    std::unique_ptr<Value[]> stack;
+    size_t stack_slots;
+    std::pmr::monotonic_buffer_resource heap;
+    size_t heap_limit;
+    size_t heap_bytes = 0;
+    // Index 0 stands for null.
+    std::vector<Array *> arrays{nullptr};
+    std::unordered_map<std::string_view, std::unique_ptr<Class> > classes;
+    std::unordered_map<const ClassParser::MethodInfo *, std::unique_ptr<Method> > methods;
+    uint64_t instruction_count = 0;
+    uint64_t instruction_limit = std::numeric_limits<uint64_t>::max();
+    unsigned depth = 0;
+
+    Class &register_class(const ClassParser &parser);
+    const Method &prepare(Class &owner, const ClassParser::MethodInfo &info);
+    const Method &resolve_static_call(Class &caller, uint16_t index);
+    Reference new_multi_array(std::string_view descriptor, std::span<const int32_t> counts);
+    Value call(const Method &method, std::span<const Value> arguments);
+    Value execute(const Method &method, Value *locals);
+};